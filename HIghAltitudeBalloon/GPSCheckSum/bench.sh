@@ -0,0 +1,64 @@
+#!/bin/sh
+#
+# bench.sh
+# --------
+#
+# Benchmark the host tools on generated logs. habgen writes a clean text log, a
+# corrupted text log and a binary log of the given size, then each tool is timed
+# on them and nmeabench reports the rate and per sentence times of each checker.
+# fmtbench checks and times the number formatting used by the loggers. nmeatest runs
+# the NMEA tokenizer unit tests first, and the benchmark stops if they fail.
+# The same seed is used each time, so runs can be compared.
+#
+# By: G. McCall
+#     Oct-2026
+#
+# Usage:
+#   sh bench.sh [size]      (default 100M)
+#
+#   The tools and logs are built in $TMPDIR (default /tmp)/habbench.
+#
+
+SIZE=${1:-100M}
+SRC=$(cd "$(dirname "$0")" && pwd)
+OUT=${TMPDIR:-/tmp}/habbench
+mkdir -p "$OUT" || exit 1
+
+echo "Building the tools in $OUT"
+for tool in habgen gpschksum habdecode habindex habpack habflight nmeabench fmtbench nmeatest; do
+  g++ -O2 -pthread -o "$OUT/$tool" "$SRC/$tool.cpp" || exit 1
+done
+
+echo "Tests:"
+"$OUT/nmeatest" || exit 1
+
+echo "Generating $SIZE logs"
+"$OUT/habgen" -s "$SIZE" -o "$OUT/clean.log" || exit 1
+"$OUT/habgen" -s "$SIZE" --seed 2 --flip 0.001 --trunc 0.001 --nocrlf 0.001 -o "$OUT/corrupt.log" || exit 1
+"$OUT/habgen" -s "$SIZE" --seed 3 --binary -o "$OUT/binary.log" || exit 1
+
+# Run a command with its output discarded and report the elapsed time.
+timed() {
+  name=$1
+  shift
+  start=$(date +%s.%N)
+  "$@" > /dev/null 2>&1
+  end=$(date +%s.%N)
+  echo "$name $start $end" | awk '{ printf "  %-28s %8.3f s\n", $1, $3 - $2 }'
+}
+
+echo "Tools:"
+timed gpschksum:clean "$OUT/gpschksum" "$OUT/clean.log"
+timed gpschksum:corrupt "$OUT/gpschksum" "$OUT/corrupt.log"
+timed gpschksum-j:clean "$OUT/gpschksum" -j 0 "$OUT/clean.log"
+timed habdecode:binary "$OUT/habdecode" "$OUT/binary.log"
+timed habindex:clean "$OUT/habindex" "$OUT/clean.log"
+timed habpack:clean "$OUT/habpack" "$OUT/clean.log"
+timed habflight:clean "$OUT/habflight" "$OUT/clean.log"
+timed habflight:binary "$OUT/habflight" "$OUT/binary.log"
+
+echo "Checkers:"
+"$OUT/nmeabench" -n 3 "$OUT/clean.log" "$OUT/corrupt.log"
+
+echo "Formatting:"
+"$OUT/fmtbench"
@@ -0,0 +1,348 @@
+/**
+  * fmtbench.cpp
+  * ------------
+  *
+  * Check the integer number formatting used by the loggers (habFlightMonitor/FixedFormat.h)
+  * against printf, then measure the cost of formatting a field with it, with printf and
+  * with the original floating point rightJustifyF().
+  *
+  * The check covers random values of every scale and number of decimal places, widths,
+  * fills and separators. Values whose discarded digits are exactly half are checked to
+  * round away from zero (printf rounds the nearest double, which is not exact).
+  * The times are in CPU cycles per field where the time stamp counter can be read (x86),
+  * otherwise in ns. The "fmt" command of GPSCheckSumArduino measures the same fields on
+  * the device (AVR or Teensy).
+  *
+  * By: G. McCall
+  *     Oct-2026
+  *
+  * Usage:
+  *   fmtbench [-n count] [--seed n]
+  *
+  *   -n count    Random values checked and formatted per field (default 1000000).
+  *
+  * Build:
+  *   g++ -O2 -o fmtbench fmtbench.cpp
+  *
+  * History:
+  *
+  *  v1.00.00.00 - 17-Oct-2026
+  *    Initial version.
+  */
+
+#define VERSION "1.00.00.00"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#define TICK_UNIT "cycles"
+#else
+#define TICK_UNIT "ns"
+#endif
+
+#include "../habFlightMonitor/FixedFormat.h"
+
+using namespace std;
+
+
+/* The original rightJustify(), used by the original rightJustifyF(). */
+char * legacyRightJustify(char *buf, int fieldSize, long x, char filler = ' ', char seperator = '\0') {
+  bool negativeSign = false;
+  if ((negativeSign = x < 0)) {
+    x = -x;
+  }
+  char *p = buf + fieldSize;
+  *p-- = '\0';
+  int digitCount = 0;
+  do {
+    *p-- = x % 10 + '0';
+    x /= 10;
+    digitCount++;
+    if (seperator && digitCount % 3 == 0 && x && p >= buf) {
+      *p-- = seperator;
+    }
+  } while (x && p >= buf);
+  if (p >= buf && negativeSign) {
+    *p-- = '-';
+  }
+  while (p >= buf) {
+    *p-- = filler;
+  }
+  return buf;
+}
+
+
+/* The original rightJustifyF(), which finds the fraction digits by repeated multiplication. */
+char * legacyRightJustifyF(char *buf, int fieldSize, double x, int dpCnt, char filler = ' ', char seperator = '\0') {
+  long iPart = (long) x;
+  double fPart = x - (double) iPart;
+  legacyRightJustify(buf, fieldSize - 1 - dpCnt, iPart, filler, seperator);
+  char *p = buf + fieldSize - 1 - dpCnt;
+  if (p < buf + fieldSize) {
+    *p++ = '.';
+  }
+  if (fPart < 0) {
+    fPart = -fPart;
+  }
+  while (p < buf + fieldSize && dpCnt--) {
+    double tmp = fPart * 10.0;
+    int digit = (int)tmp;
+    *p++ = digit + '0';
+    fPart = tmp - digit;
+  }
+  buf[fieldSize] = '\0';
+  return buf;
+}
+
+
+static unsigned long checkCnt = 0;
+static unsigned long errCnt = 0;
+
+void report(const char * what, const string & got, const string & expected) {
+  checkCnt++;
+  if (got != expected) {
+    if (++errCnt <= 10) {
+      cerr << "**** " << what << ": \"" << got << "\" expected \"" << expected << "\"" << endl;
+    }
+  }
+}
+
+
+/*
+ * The expected text of value / 10^scale with dp places, from printf. Returns false
+ * if the discarded digits are exactly half, where printf depends on the nearest double.
+ */
+bool printfFixed(char * buf, size_t size, int32_t value, int scale, int dp) {
+  if (dp < scale) {
+    int64_t divisor = fmtPow10(scale - dp);
+    int64_t rem = llabs((int64_t) value) % divisor;
+    if (rem * 2 == divisor) {
+      return false;
+    }
+  }
+  snprintf(buf, size, "%.*Lf", dp, (long double) value / fmtPow10(scale));
+  return true;
+}
+
+
+/*
+ * Check FmtCursor against printf.
+ */
+void verify(unsigned long count, mt19937 & rng) {
+  char buf[64];
+  char expected[64];
+  unsigned long legacyErrCnt = 0;
+  unsigned long legacyCnt = 0;
+  uniform_int_distribution<int32_t> anyValue(INT32_MIN, INT32_MAX);
+  uniform_int_distribution<int> digitCnt(1, 10);
+  uniform_int_distribution<int> places(0, FMT_MAX_SCALE);
+
+  for (unsigned long i = 0; i < count; i++) {
+    // Values of every length, not just the long ones.
+    int32_t value = anyValue(rng) / (int32_t) fmtPow10(10 - digitCnt(rng));
+    int scale = places(rng);
+    int dp = places(rng);
+    int width = places(rng) * 2;
+
+    {
+      FmtCursor out(buf, sizeof(buf));
+      out.appendSigned(value);
+      snprintf(expected, sizeof(expected), "%d", value);
+      report("signed", out.getText(), expected);
+    }
+    {
+      FmtCursor out(buf, sizeof(buf));
+      out.appendUnsigned((uint32_t) value, width, '0');
+      snprintf(expected, sizeof(expected), "%0*u", width, (uint32_t) value);
+      report("unsigned", out.getText(), expected);
+    }
+    {
+      FmtCursor out(buf, sizeof(buf));
+      out.appendSigned(value, width, '0');
+      snprintf(expected, sizeof(expected), "%0*d", width, value);
+      report("signed zero fill", out.getText(), expected);
+    }
+
+    char text[64];
+    if (printfFixed(text, sizeof(text), value, scale, dp)) {
+      FmtCursor out(buf, sizeof(buf));
+      out.appendFixed(value, scale, dp);
+      report("fixed", out.getText(), text);
+
+      FmtCursor padded(buf, sizeof(buf));
+      padded.appendFixed(value, scale, dp, width);
+      snprintf(expected, sizeof(expected), "%*s", width, text);
+      report("fixed width", padded.getText(), expected);
+    } else {
+      // Exactly half: away from zero.
+      int64_t divisor = fmtPow10(scale - dp);
+      int64_t rounded = ((int64_t) value + (value < 0 ? -divisor / 2 : divisor / 2)) / divisor;
+      int64_t unit = fmtPow10(dp);
+      string half = (value < 0 ? "-" : "") + to_string(llabs(rounded) / unit);
+      if (dp > 0) {
+        string fraction = to_string(llabs(rounded) % unit);
+        half += "." + string(dp - fraction.size(), '0') + fraction;
+      }
+      FmtCursor out(buf, sizeof(buf));
+      out.appendFixed(value, scale, dp);
+      report("fixed half", out.getText(), half);
+    }
+
+    // Separators: printf's digits, grouped in threes.
+    {
+      FmtCursor out(buf, sizeof(buf));
+      out.appendFixed(value, scale, scale, 0, ' ', ',');
+      printfFixed(text, sizeof(text), value, scale, scale);
+      string plain = text;
+      size_t intStart = value < 0 ? 1 : 0;
+      size_t intEnd = plain.find('.') == string::npos ? plain.size() : plain.find('.');
+      for (size_t j = intEnd; j > intStart + 3; j -= 3) {
+        plain.insert(j - 3, ",");
+      }
+      report("separator", out.getText(), plain);
+    }
+
+    // The original rightJustifyF() against printf, for the record.
+    if (dp >= 1 && dp <= 6 && value > -100000000 && value < 100000000) {
+      double x = (double) value / fmtPow10(scale);
+      char legacy[64];
+      legacyRightJustifyF(legacy, 20, x, dp);
+      snprintf(expected, sizeof(expected), "%20.*f", dp, x);
+      legacyCnt++;
+      legacyErrCnt += strcmp(legacy, expected) != 0;
+    }
+  }
+
+  // Truncation: the text is cut short and the cursor marked.
+  {
+    char small[8];
+    FmtCursor out(small, sizeof(small));
+    out.appendText("$HAB,").appendFixed(-33800012, 6, 6);
+    report("truncated", out.getText(), "$HAB,-3");
+    report("truncated flag", out.isTruncated() ? "yes" : "no", "yes");
+  }
+
+  printf("Checked %lu fields against printf: %lu errors\n", checkCnt, errCnt);
+  printf("Original rightJustifyF: %lu of %lu fields differ from printf\n", legacyErrCnt, legacyCnt);
+}
+
+
+/*
+ * Read a cycle counter (or the time in ns).
+ */
+inline uint64_t ticks() {
+#if defined(HAVE_TSC)
+  return __rdtsc();
+#else
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+// Keeps the formatted lengths, so the formatting is not optimised away.
+volatile size_t benchSink = 0;
+
+/*
+ * Time a formatter over a set of values and report the cost of one field.
+ */
+template <typename T, typename F>
+void bench(const char * name, const vector<T> & values, F format) {
+  char buf[64];
+  uint64_t best = UINT64_MAX;
+  for (int pass = 0; pass < 3; pass++) {
+    uint64_t t0 = ticks();
+    for (const T & v : values) {
+      benchSink += format(buf, v);
+    }
+    uint64_t t1 = ticks();
+    best = min(best, t1 - t0);
+  }
+  printf("  %-28s %8.1f %s/field\n", name, (double) best / values.size(), TICK_UNIT);
+}
+
+
+/* main
+ * ----
+ * Check, then time.
+ */
+int main(int argc, const char * argv[]) {
+  unsigned long count = 1000000;
+  unsigned long seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      count = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 10);
+    } else {
+      cerr << "fmtbench v" << VERSION << endl;
+      cerr << "Usage: fmtbench [-n count] [--seed n]" << endl;
+      return 1;
+    }
+  }
+
+  mt19937 rng(seed);
+  verify(count, rng);
+
+  // Latitudes (6 places), altitudes (2 places) and counts, as in the $HAB record.
+  vector<double> lats, alts;
+  vector<int32_t> latFixed, altFixed;
+  vector<uint32_t> counts;
+  uniform_real_distribution<double> lat(-90.0, 90.0);
+  uniform_real_distribution<double> alt(0.0, 40000.0);
+  uniform_int_distribution<uint32_t> cnt(0, 100000);
+  for (unsigned long i = 0; i < count; i++) {
+    lats.push_back(lat(rng));
+    alts.push_back(alt(rng));
+    latFixed.push_back(lround(lats.back() * 1000000.0));
+    altFixed.push_back(lround(alts.back() * 100.0));
+    counts.push_back(cnt(rng));
+  }
+
+  printf("Per field:\n");
+  bench("fixed lat (%.6f)", lats, [](char * buf, double v) {
+    FmtCursor out(buf, 64);
+    out.appendFixed(lround(v * 1000000.0), 6, 6);
+    return out.getLength();
+  });
+  bench("fixed lat, scaled", latFixed, [](char * buf, int32_t v) {
+    FmtCursor out(buf, 64);
+    out.appendFixed(v, 6, 6);
+    return out.getLength();
+  });
+  bench("snprintf lat", lats, [](char * buf, double v) {
+    return (size_t) snprintf(buf, 64, "%.6f", v);
+  });
+  bench("rightJustifyF lat (original)", lats, [](char * buf, double v) {
+    return strlen(legacyRightJustifyF(buf, 12, v, 6));
+  });
+  bench("fixed alt (%.2f)", altFixed, [](char * buf, int32_t v) {
+    FmtCursor out(buf, 64);
+    out.appendFixed(v, 2, 2);
+    return out.getLength();
+  });
+  bench("snprintf alt", alts, [](char * buf, double v) {
+    return (size_t) snprintf(buf, 64, "%.2f", v);
+  });
+  bench("rightJustifyF alt (original)", alts, [](char * buf, double v) {
+    return strlen(legacyRightJustifyF(buf, 10, v, 2));
+  });
+  bench("unsigned count", counts, [](char * buf, uint32_t v) {
+    FmtCursor out(buf, 64);
+    out.appendUnsigned(v);
+    return out.getLength();
+  });
+  bench("snprintf count", counts, [](char * buf, uint32_t v) {
+    return (size_t) snprintf(buf, 64, "%u", v);
+  });
+  return errCnt == 0 ? 0 : 2;
+}
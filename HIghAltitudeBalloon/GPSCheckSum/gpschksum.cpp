@@ -1,7 +1,7 @@
 /**
   * gpschecksum.cpp
   * ---------------
-  * 
+  *
   * Verify the checksum calculated and written to be a ublox GPS receiver.
   * Currently only recognises NMEA format GPS sentences.
   *
@@ -9,10 +9,46 @@
   *     May-2024
   *
   * Usage:
-  *   gpschecksum file.Log
+  *   gpschecksum [-j threads] [--follow] [--interval secs] file.Log|- ...
+  *
+  *   -j threads  Memory map each file and check it in parallel using the given
+  *               number of threads (0 = one per core). The output is the same as
+  *               the default mode, which reads the file line by line.
+  *   -           Check the sentences arriving on stdin, e.g. the logger's console
+  *               output piped from a serial terminal.
+  *   --follow    Check the file, then keep checking lines as they are appended
+  *               (like tail -f) until interrupted.
+  *   --interval  How often the running statistics are written to stderr when
+  *               reading stdin or following a file (default 10 seconds, 0 = never).
+  *
+  *   When reading stdin or following, lines that do not contain a '$' (e.g. debug
+  *   messages on the console) are skipped rather than counted as errors.
+  *   Ctrl-C (SIGINT) or SIGTERM ends the check and prints the summary.
+  *
+  * Build:
+  *   g++ -O2 -pthread -o gpschksum gpschksum.cpp
   *
   * History:
   *
+  *  v1.04.01.00 - 17-Oct-2026
+  *    A CR or LF before the '$' is skipped, as the logger's NmeaSentence::parse()
+  *    does, rather than making the line NoStart.
+  *
+  *  v1.04.00.00 - 17-Oct-2026
+  *    Added the stdin (-) and --follow streaming modes with running statistics.
+  *
+  *  v1.03.00.00 - 17-Oct-2026
+  *    Checksums are verified by the SSE2/AVX2 kernel in nmeasimd.h.
+  *
+  *  v1.02.00.00 - 17-Oct-2026
+  *    Added the parallel memory mapped mode (-j).
+  *    The last line is no longer counted twice.
+  *    Output is buffered rather than flushed after every error.
+  *
+  *  v1.01.00.00 - 17-Oct-2026
+  *    Use the shared NMEA tokenizer (habFlightMonitor/Nmea.h) to check the sentences.
+  *    A trailing CR is no longer treated as part of the checksum.
+  *
   *  v1.00.01.00 - 29-May-2024
   *    Added output of % in summary line.
   *
@@ -20,73 +56,125 @@
   *    Initial version.
   */
 
-#define VERSION "1.00.01.00"
+#define VERSION "1.04.01.00"
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <bits/stdc++.h>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Allow for the $HAB records, which are longer than an NMEA sentence.
+#define NMEA_MAX_LENGTH 4096
+#include "../habFlightMonitor/Nmea.h"
+#include "nmeasimd.h"
+
 using namespace std;
 
 
-/* Convert a hexadecimal character to an integer. */
-unsigned int hextoint(const char digit) {
-  const char lookup [] = "0123456789ABCDEF";
-  char ch = toupper(digit);
-  int result = 0;
+/*
+ * Buffered writer for stdout.
+ * Reports can run to millions of lines, so they are written in large blocks.
+ */
+class Writer {
+  public:
+    ~Writer() { flush(); }
 
-  for (result = 0; result < sizeof(lookup); result++) {
-//    cout << "tohexint cmp: " << lookup[result] << " to " << ch << endl;
-    if (lookup[result] == ch) {
-      break;
+    void write(const char * data, size_t len) {
+      if (len > sizeof(buf) - used) {
+        flush();
+      }
+      if (len > sizeof(buf)) {
+        fwrite(data, 1, len, stdout);
+        return;
+      }
+      memcpy(buf + used, data, len);
+      used += len;
+    }
+    void write(const char * text) { write(text, strlen(text)); }
+
+    void flush() {
+      if (used > 0) {
+        fwrite(buf, 1, used, stdout);
+        used = 0;
+      }
+      fflush(stdout);
     }
+
+  private:
+    char buf[64 * 1024];
+    size_t used = 0;
+};
+
+Writer out;
+
+
+/*
+ * A line that failed the check.
+ */
+struct LineError {
+  unsigned long lineNo;
+  const char * text;      // Not null terminated.
+  size_t len;
+  NmeaStatus status;
+  uint8_t parity;
+};
+
+
+/*
+ * Check one line (without its LF). Empty lines are not checked.
+ * Return true if the line is an error, in which case err is filled in.
+ */
+bool checkLine(const char * text, size_t len, LineError & err) {
+  if (len == 0) {
+    return false;
+  }
+  uint8_t parity;
+  NmeaStatus status = nmeaVerify(text, len, parity);
+  if (status == NmeaOk) {
+    return false;
   }
-//  cout << "hextoint (" << ch << ") " << result << endl;
-  return result;
+  err.text = text;
+  err.len = len;
+  err.status = status;
+  err.parity = parity;
+  return true;
 }
 
 
 /*
- * Calculate and check the checksum in the GPS sentence
- * Return 0 if checksum is correct, or
- *        the checksum that the record *should* contain (but does not).
+ * Output the report for a line that failed the check.
  */
-int checksum(const char * sentence) {
-  const char * p = sentence;
-
-
-  unsigned int parity = 0;
-  unsigned int chksum = 0;
-  bool isCheckSumTerm = false;
-  while (*p) {
-    switch (*p) {
-      case '$' :        // Start of sentence.
-        parity = 0;
-        isCheckSumTerm = false;
-        break;
-      case '*':         // End of data, start of checksum.
-        isCheckSumTerm = true;
-        chksum = 0;
-        break;
-      default:          // regular data character, so simply process it.
-        if (!isCheckSumTerm) {
-          parity ^= (unsigned int) *p;
-        } else {
-          chksum = (chksum << 4) | hextoint(*p);
-        }
-        break;
-    }
-    p++;
-  }
-//  cout << endl << uppercase << hex << "Parity: " << parity << " checksum: " << chksum << dec << endl;
- 
-  if (parity != chksum) {
-    return parity;
+void reportError(const LineError & err) {
+  char wrkBuf[80];
+
+  snprintf(wrkBuf, sizeof(wrkBuf), "%lu: ", err.lineNo);
+  out.write(wrkBuf);
+  out.write(err.text, err.len);
+  if (err.status == NmeaBadChecksum || err.status == NmeaNoChecksum) {
+    snprintf(wrkBuf, sizeof(wrkBuf), "\n**** Invalid checksum. should be: 0x%X\n", err.parity);
   } else {
-    return 0;
+    snprintf(wrkBuf, sizeof(wrkBuf), "\n**** Not a GPS sentence or too long.\n");
   }
+  out.write(wrkBuf);
+}
+
 
+/*
+ * Output the summary line for a file.
+ */
+void reportSummary(unsigned long lineCnt, unsigned long errCnt) {
+  char wrkBuf[120];
+  double pct = lineCnt > 0 ? (double) errCnt / (double) lineCnt * 100.0 : 0.0;
+  snprintf(wrkBuf, sizeof(wrkBuf), "processed: %lu lines. Errors: %lu (%.2f%%)\n", lineCnt, errCnt, pct);
+  out.write(wrkBuf);
+  out.flush();
 }
 
 
@@ -94,47 +182,361 @@ int checksum(const char * sentence) {
  * Process the data in the specified file.
  */
 int process(const char * file) {
-  cout << "Processing: " << file << endl;
+  out.write("Processing: "); out.write(file); out.write("\n");
 
   ifstream datafile(file);
   if (!datafile) {
-    cout << "Error opening the file." << endl;
+    out.write("Error opening the file.\n");
     return -1;
   }
 
-  int lineCnt = 0;
-  int errCnt = 0;
+  unsigned long lineCnt = 0;
+  unsigned long errCnt = 0;
   string inLine;
+  LineError err;
 
-  while (!datafile.eof()) {
+  while (getline(datafile, inLine)) {
     lineCnt++;
-    getline(datafile, inLine);
-    if (inLine.length() > 0) {
-      int chksum = checksum(inLine.c_str());
-      if (chksum != 0) {
-        cout << lineCnt << ": " << inLine << endl;
-        cout << "**** Invalid checksum. should be: 0x" << uppercase << hex << chksum << dec << endl;
-        errCnt++;
-      }
+    if (checkLine(inLine.c_str(), inLine.length(), err)) {
+      err.lineNo = lineCnt;
+      reportError(err);
+      errCnt++;
     }
   }
   datafile.close();
 
+  reportSummary(lineCnt, errCnt);
+  return lineCnt;
+}
+
 
-  cout << "processed: " << lineCnt << " lines. Errors: " << errCnt << " (" << fixed << setprecision(2) << ((float)errCnt / (float)lineCnt * 100.0) << "%)" << endl;
+/*
+ * A newline aligned part of a mapped file and the results of checking it.
+ * Line numbers in errors are relative to the start of the chunk until the chunks are merged.
+ */
+struct Chunk {
+  const char * start;
+  const char * end;
+  unsigned long lineCnt = 0;
+  vector<LineError> errors;
+};
+
+
+/*
+ * Check every line in a chunk.
+ */
+void processChunk(Chunk & chunk) {
+  LineError err;
+  const char * p = chunk.start;
+
+  while (p < chunk.end) {
+    const char * eol = (const char *) memchr(p, '\n', chunk.end - p);
+    const char * next = eol ? eol + 1 : chunk.end;
+    if (!eol) {
+      eol = chunk.end;
+    }
+    chunk.lineCnt++;
+    if (checkLine(p, eol - p, err)) {
+      err.lineNo = chunk.lineCnt;
+      chunk.errors.push_back(err);
+    }
+    p = next;
+  }
+}
+
+
+/*
+ * Process the specified file by memory mapping it and checking it in parallel.
+ */
+int processMapped(const char * file, unsigned int threadCnt) {
+  out.write("Processing: "); out.write(file); out.write("\n");
+
+  int fd = open(file, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    out.write("Error opening the file.\n");
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  size_t size = st.st_size;
+  if (size == 0) {
+    close(fd);
+    reportSummary(0, 0);
+    return 0;
+  }
+
+  const char * data = (const char *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    out.write("Error mapping the file.\n");
+    return -1;
+  }
+  madvise((void *) data, size, MADV_SEQUENTIAL);
+
+  // Several chunks per thread, so that a thread which finishes early can take another.
+  const size_t minChunkSize = 1024 * 1024;
+  size_t chunkCnt = min((size_t) threadCnt * 4, size / minChunkSize + 1);
+  vector<Chunk> chunks;
+  const char * start = data;
+  const char * end = data + size;
+  for (size_t i = 1; i <= chunkCnt && start < end; i++) {
+    const char * chunkEnd = (i == chunkCnt) ? end : data + size / chunkCnt * i;
+    if (chunkEnd < start) {
+      chunkEnd = start;
+    }
+    // Extend the chunk to the end of the line that it splits.
+    const char * eol = (const char *) memchr(chunkEnd, '\n', end - chunkEnd);
+    chunkEnd = eol ? eol + 1 : end;
+    Chunk chunk;
+    chunk.start = start;
+    chunk.end = chunkEnd;
+    chunks.push_back(chunk);
+    start = chunkEnd;
+  }
+
+  atomic<size_t> nextChunk(0);
+  vector<thread> workers;
+  for (unsigned int t = 0; t < threadCnt; t++) {
+    workers.emplace_back([&chunks, &nextChunk]() {
+      size_t i;
+      while ((i = nextChunk++) < chunks.size()) {
+        processChunk(chunks[i]);
+      }
+    });
+  }
+  for (thread & worker : workers) {
+    worker.join();
+  }
+
+  // Merge the results in file order.
+  unsigned long lineCnt = 0;
+  unsigned long errCnt = 0;
+  for (Chunk & chunk : chunks) {
+    for (LineError & err : chunk.errors) {
+      err.lineNo += lineCnt;
+      reportError(err);
+    }
+    lineCnt += chunk.lineCnt;
+    errCnt += chunk.errors.size();
+  }
+
+  reportSummary(lineCnt, errCnt);
+  munmap((void *) data, size);
   return lineCnt;
 }
 
 
+/*
+ * Streaming modes.
+ */
+#define STREAM_BLOCK_SIZE     (64 * 1024)
+#define FOLLOW_POLL_MS        200
+
+volatile sig_atomic_t stopRequested = 0;
+
+void onStopSignal(int) {
+  stopRequested = 1;
+}
+
+
+/*
+ * Counters for a stream, and those at the last statistics report.
+ */
+struct StreamStats {
+  unsigned long lineNo = 0;         // Lines received, including skipped and empty lines.
+  unsigned long lineCnt = 0;        // Lines checked.
+  unsigned long errCnt = 0;
+  unsigned long skipCnt = 0;
+  unsigned long reportLineCnt = 0;
+  unsigned long reportErrCnt = 0;
+};
+
+
+/*
+ * Write the running statistics to stderr.
+ */
+void reportStreamStats(StreamStats & stats, double interval) {
+  unsigned long lines = stats.lineCnt - stats.reportLineCnt;
+  unsigned long errs = stats.errCnt - stats.reportErrCnt;
+  fprintf(stderr, "lines: %lu errors: %lu (%.2f%%) skipped: %lu | last %.0fs: %lu lines, %lu errors (%.2f%%)\n",
+          stats.lineCnt, stats.errCnt, stats.lineCnt ? stats.errCnt * 100.0 / stats.lineCnt : 0.0,
+          stats.skipCnt, interval, lines, errs, lines ? errs * 100.0 / lines : 0.0);
+  stats.reportLineCnt = stats.lineCnt;
+  stats.reportErrCnt = stats.errCnt;
+}
+
+
+/*
+ * Check a line received by a stream. Lines without a '$' are skipped.
+ */
+void checkStreamLine(StreamStats & stats, const char * text, size_t len, bool tooLong) {
+  stats.lineNo++;
+  if (len == 0) {
+    return;
+  }
+  LineError err;
+  if (tooLong) {
+    err.text = text;
+    err.len = len;
+    err.status = NmeaTooLong;
+    err.parity = 0;
+  } else if (!checkLine(text, len, err)) {
+    stats.lineCnt++;
+    return;
+  } else if (err.status == NmeaNoStart) {
+    stats.skipCnt++;
+    return;
+  }
+  stats.lineCnt++;
+  stats.errCnt++;
+  err.lineNo = stats.lineNo;
+  reportError(err);
+}
+
+
+/*
+ * Process a stream: stdin, or a file that is followed as it grows.
+ * Memory use is constant: data is read in blocks and a line longer than
+ * NMEA_MAX_LENGTH is truncated and reported as too long.
+ * No wait is longer than the statistics interval (or FOLLOW_POLL_MS when following).
+ */
+int processStream(const char * name, int fd, bool follow, double interval) {
+  out.write("Processing: "); out.write(name); out.write("\n");
+  out.flush();
+
+  static char block[STREAM_BLOCK_SIZE];
+  static char line[NMEA_MAX_LENGTH + 1];
+  size_t lineLen = 0;
+  bool tooLong = false;
+  off_t offset = 0;
+  StreamStats stats;
+
+  auto nextReport = chrono::steady_clock::now() + chrono::duration<double>(interval);
+  while (!stopRequested) {
+    int waitMs = -1;
+    if (interval > 0) {
+      auto remaining = chrono::duration_cast<chrono::milliseconds>(nextReport - chrono::steady_clock::now());
+      waitMs = max(0, (int) remaining.count());
+    }
+
+    ssize_t n = 0;
+    if (follow) {
+      n = read(fd, block, sizeof(block));
+      if (n == 0) {
+        // No new data. If the file got shorter it was replaced, so start again.
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size < offset) {
+          fprintf(stderr, "%s: file truncated, restarting\n", name);
+          lseek(fd, 0, SEEK_SET);
+          offset = 0;
+          lineLen = 0;
+        }
+        poll(NULL, 0, waitMs < 0 ? FOLLOW_POLL_MS : min(waitMs, FOLLOW_POLL_MS));
+      }
+    } else {
+      struct pollfd pfd = { fd, POLLIN, 0 };
+      if (poll(&pfd, 1, waitMs) > 0) {
+        n = read(fd, block, sizeof(block));
+        if (n == 0) {
+          break;              // End of file.
+        }
+      }
+    }
+    if (n < 0 && errno != EINTR) {
+      perror(name);
+      break;
+    }
+
+    // Split the block into lines.
+    if (n > 0) {
+      offset += n;
+      const char * p = block;
+      const char * end = block + n;
+      while (p < end) {
+        const char * eol = (const char *) memchr(p, '\n', end - p);
+        const char * stop = eol ? eol : end;
+        size_t take = min((size_t) (stop - p), sizeof(line) - 1 - lineLen);
+        memcpy(line + lineLen, p, take);
+        lineLen += take;
+        tooLong |= (take < (size_t) (stop - p));
+        if (eol) {
+          checkStreamLine(stats, line, lineLen, tooLong);
+          lineLen = 0;
+          tooLong = false;
+        }
+        p = stop + (eol ? 1 : 0);
+      }
+      out.flush();
+    }
+
+    if (interval > 0 && chrono::steady_clock::now() >= nextReport) {
+      reportStreamStats(stats, interval);
+      nextReport += chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(interval));
+    }
+  }
+
+  // A last line without a LF is complete at the end of stdin, but a followed
+  // file may still be being written.
+  if (lineLen > 0 && !follow) {
+    checkStreamLine(stats, line, lineLen, tooLong);
+  }
+  if (stats.skipCnt > 0) {
+    char wrkBuf[80];
+    snprintf(wrkBuf, sizeof(wrkBuf), "skipped: %lu lines without a GPS sentence.\n", stats.skipCnt);
+    out.write(wrkBuf);
+  }
+  reportSummary(stats.lineCnt, stats.errCnt);
+  return stats.lineCnt;
+}
+
+
 /* main
  * ----
  * Step through the command line arguments one by one.
  * Assume that the argument is a GPS log file and process it.
  */
 int main(int argc, const char * argv[]) {
-  
-  for (int i = 1; i < argc; i++) {
-    process(argv[i]);
+  bool parallel = false;
+  unsigned int threadCnt = 0;
+  bool follow = false;
+  double interval = 10.0;
+
+  // Stop cleanly (and print the summary) when interrupted. SA_RESTART is not set,
+  // so a blocked read returns and the stop is seen at once.
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = onStopSignal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  for (int i = 1; i < argc && !stopRequested; i++) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      parallel = true;
+      threadCnt = atoi(argv[++i]);
+      if (threadCnt == 0) {
+        threadCnt = max(1u, thread::hardware_concurrency());
+      }
+    } else if (strcmp(argv[i], "--follow") == 0) {
+      follow = true;
+    } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+      interval = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-") == 0) {
+      processStream("stdin", STDIN_FILENO, false, interval);
+    } else if (follow) {
+      int fd = open(argv[i], O_RDONLY);
+      if (fd < 0) {
+        out.write("Processing: "); out.write(argv[i]); out.write("\n");
+        out.write("Error opening the file.\n");
+        continue;
+      }
+      processStream(argv[i], fd, true, interval);
+      close(fd);
+    } else if (parallel) {
+      processMapped(argv[i], threadCnt);
+    } else {
+      process(argv[i]);
+    }
   }
 }
-
@@ -0,0 +1,208 @@
+/**
+  * habdecode.cpp
+  * -------------
+  *
+  * Convert a hab log containing binary $HAB records (see LOG_BINARY_HAB in
+  * habFlightMonitor/hab_config.h) back into the text layout, so the result can
+  * be processed by gpschksum and the analysis spreadsheets.
+  * Text lines (NMEA sentences and headers) are copied through unchanged, and each
+  * binary record becomes a text line ending in CR LF, as the logger writes it.
+  *
+  * A record of a version other than HAB_REC_VERSION is reported and skipped. After a
+  * record that is not valid, decoding resumes at the next line or binary record.
+  *
+  * By: G. McCall
+  *     Oct-2026
+  *
+  * Usage:
+  *   habdecode file.log > file.csv
+  *
+  * Build:
+  *   g++ -O2 -o habdecode habdecode.cpp
+  *
+  * History:
+  *
+  *  v1.04.00.00 - 17-Oct-2026
+  *    A record of another version is reported as unsupported. Resynchronise after
+  *    an invalid record at the next '$', '!' or binary record rather than the next LF,
+  *    which lost the line that followed it.
+  *    Text lines keep their CR, and decoded records end in CR LF.
+  *
+  *  v1.03.00.00 - 17-Oct-2026
+  *    Record version 4: loop, gps, temp, oled and sd latency summaries replace the
+  *    oledUpd, tempUpd, sumLogTimeMs and logHist fields.
+  *
+  *  v1.02.00.00 - 17-Oct-2026
+  *    Record version 3: added chkErrGP, chkErrGN and chkErrOther.
+  *
+  *  v1.01.00.00 - 17-Oct-2026
+  *    Record version 2: added gpsOvfCnt and gpsHighWater.
+  *
+  *  v1.00.00.00 - 17-Oct-2026
+  *    Initial version.
+  */
+
+#define VERSION "1.04.00.00"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include <cstring>
+
+#include "../habFlightMonitor/HabRecord.h"
+
+using namespace std;
+
+
+/*
+ * Output a binary record in the same layout as the text $HAB record
+ * produced by logData() in habFlightMonitor.ino.
+ */
+void printRecord(const HabRecord & rec) {
+  char buf[100];
+
+  snprintf(buf, sizeof(buf), "$HAB,%d:%02d:%02d,", rec.hour, rec.minute, rec.second);
+  cout << buf;
+  snprintf(buf, sizeof(buf), "%.6f,%.6f,%.2f,%.4f,%d,", rec.lat / 1000000.0, rec.lon / 1000000.0,
+          rec.alt / 100.0, rec.hdop / 10000.0, rec.satCnt);
+  cout << buf;
+  snprintf(buf, sizeof(buf), "%.2f,%.2f,%.2f,", rec.temp1 / 100.0, rec.temp2 / 100.0, rec.battV / 100.0);
+  cout << buf;
+  snprintf(buf, sizeof(buf), "%u,%u,", rec.gpsOvfCnt, rec.gpsHighWater);
+  cout << buf;
+  snprintf(buf, sizeof(buf), "%u,%u,%u,", rec.chkErrGP, rec.chkErrGN, rec.chkErrOther);
+  cout << buf;
+  cout << rec.logCnt;
+
+  for (int i = 0; i < HAB_REC_TIMER_CNT; i++) {
+    const HabTimerSummary & t = rec.timers[i];
+    snprintf(buf, sizeof(buf), ",%u,%u,%u,%u,%u", t.cnt, LatencyHistogram::bucketValue(t.p50, t.max),
+             LatencyHistogram::bucketValue(t.p90, t.max), LatencyHistogram::bucketValue(t.p99, t.max), t.max);
+    cout << buf;
+  }
+  cout << "\r\n";
+}
+
+
+// Result of reading a binary record.
+enum RecordStatus {
+  RecordOk,
+  RecordInvalid,            // Not a valid record: torn, or the CRC is incorrect.
+  RecordUnsupported         // A valid record of another version or length.
+};
+
+
+/*
+ * Read the rest of a binary record whose first sync byte has been read into buf,
+ * which must hold HAB_REC_HEADER_SIZE + 255 + HAB_REC_CRC_SIZE bytes.
+ */
+RecordStatus readRecord(istream & in, uint8_t * buf) {
+  buf[0] = HAB_REC_SYNC1;
+
+  // The remainder of the header.
+  for (int i = 1; i < HAB_REC_HEADER_SIZE; i++) {
+    int ch = in.get();
+    if (ch == EOF) {
+      return RecordInvalid;
+    }
+    buf[i] = ch;
+  }
+  if (buf[1] != HAB_REC_SYNC2) {
+    return RecordInvalid;
+  }
+
+  // The body and CRC.
+  unsigned int size = HAB_REC_HEADER_SIZE + buf[3];
+  if (!in.read((char *) buf + HAB_REC_HEADER_SIZE, size - HAB_REC_HEADER_SIZE + HAB_REC_CRC_SIZE)) {
+    return RecordInvalid;
+  }
+  uint16_t crc = buf[size] | (buf[size + 1] << 8);
+  if (crc != habCrc16(buf + 2, size - 2)) {
+    return RecordInvalid;
+  }
+
+  return buf[2] == HAB_REC_VERSION && size == HAB_REC_SIZE ? RecordOk : RecordUnsupported;
+}
+
+
+/*
+ * Process the data in the specified file.
+ */
+int process(const char * file) {
+  cerr << "Processing: " << file << endl;
+
+  ifstream datafile(file, ios::binary);
+  if (!datafile) {
+    cerr << "Error opening the file." << endl;
+    return -1;
+  }
+
+  int lineCnt = 0;
+  int recCnt = 0;
+  int errCnt = 0;
+  string inLine;
+  uint8_t buf[HAB_REC_HEADER_SIZE + 255 + HAB_REC_CRC_SIZE];
+  int ch;
+
+  while ((ch = datafile.get()) != EOF) {
+    if (inLine.empty() && ch == HAB_REC_SYNC1) {
+      streampos recStart = datafile.tellg();
+      RecordStatus status = readRecord(datafile, buf);
+      if (status == RecordOk) {
+        HabRecord rec;
+        memcpy(&rec, buf, HAB_REC_SIZE + HAB_REC_CRC_SIZE);
+        printRecord(rec);
+        recCnt++;
+        continue;
+      }
+      errCnt++;
+      if (status == RecordUnsupported) {
+        // The CRC is correct, so the record can be skipped.
+        cerr << "**** Unsupported record version " << (unsigned int) buf[2] << " (length " << (unsigned int) buf[3]
+             << ") after line " << lineCnt << endl;
+        continue;
+      }
+
+      // Not a valid record. Report it and resynchronise at the next line or record,
+      // which may be within the bytes read for this one.
+      datafile.clear();
+      datafile.seekg(recStart);
+      unsigned long skipped = 1;
+      while ((ch = datafile.peek()) != EOF && ch != '$' && ch != '!' && ch != HAB_REC_SYNC1) {
+        datafile.get();
+        skipped++;
+      }
+      cerr << "**** Invalid binary record after line " << lineCnt << ", skipped " << skipped << " bytes" << endl;
+      continue;
+    }
+
+    inLine += (char) ch;
+    if (ch == '\n') {
+      lineCnt++;
+      cout << inLine;
+      inLine.clear();
+    }
+  }
+  if (!inLine.empty()) {
+    lineCnt++;
+    cout << inLine;
+  }
+  datafile.close();
+
+  cerr << "processed: " << lineCnt << " lines. Binary records: " << recCnt << ". Errors: " << errCnt << endl;
+  return lineCnt;
+}
+
+
+/* main
+ * ----
+ * Step through the command line arguments one by one.
+ * Assume that the argument is a hab log file and process it.
+ */
+int main(int argc, const char * argv[]) {
+
+  for (int i = 1; i < argc; i++) {
+    process(argv[i]);
+  }
+}
@@ -0,0 +1,746 @@
+/**
+  * habflight.cpp
+  * -------------
+  *
+  * Post flight analysis of hab logs.
+  *
+  * Reports the flight metrics that were previously worked out in a spreadsheet:
+  * launch, burst altitude, ascent and descent rates, landing, time above
+  * ALTITUDE_RECORD_LOW, heater duty cycle and the periods without a GPS fix.
+  * Warm restarts of the logger ($HABRS records) are listed with the gap in the track.
+  * The track can also be written as KML (Google Earth) and/or GPX.
+  *
+  * Each log is memory mapped and split into chunks at record boundaries. The chunks
+  * are parsed in parallel ($HAB text and binary records, GGA and RMC sentences), then
+  * the results are joined in order and the metrics computed in a single pass.
+  * Several logs (e.g. a flight that spans habNNNN.log files) are treated as one flight.
+  *
+  * The track comes from the GGA sentences, or from the $HAB records if the log has
+  * no GGA sentences. NMEA sentences with an incorrect checksum are ignored.
+  * The heater state is only held in binary $HAB records. For text records the duty cycle
+  * is estimated from the heater sensor's temperature and HEATER_ON_TEMP/HEATER_OFF_TEMP.
+  *
+  * By: G. McCall
+  *     Oct-2026
+  *
+  * Usage:
+  *   habflight [-j threads] [-g secs] [--kml file.kml] [--gpx file.gpx] file.log ...
+  *
+  *   -j threads  Threads used to parse the logs (default: one per core).
+  *   -g secs     Report periods of at least secs without a GPS fix (default 5).
+  *   --kml file  Write the track as KML.
+  *   --gpx file  Write the track as GPX. Times are included if the log has an RMC date.
+  *
+  * Build:
+  *   g++ -O2 -pthread -o habflight habflight.cpp
+  *
+  * History:
+  *
+  *  v1.01.00.00 - 17-Oct-2026
+  *    Report warm restarts ($HABRS records).
+  *
+  *  v1.00.00.00 - 17-Oct-2026
+  *    Initial version.
+  */
+
+#define VERSION "1.01.00.00"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../habFlightMonitor/hab_config.h"
+#include "../GPSCheckSumArduino/HabIndex.h"
+#define NMEA_MAX_LENGTH 4096
+#include "../habFlightMonitor/Nmea.h"
+
+using namespace std;
+
+// Climb above the first altitude that marks the launch (m).
+#define LAUNCH_ALT_GAIN 50.0
+// Height above the final altitude at which the descent is taken to have ended (m).
+#define LANDING_ALT_TOL 50.0
+// Smallest chunk worth handing to a thread.
+#define MIN_CHUNK_SIZE (1024 * 1024)
+
+
+/*
+ * A GPS position, from a GGA sentence or a $HAB record.
+ */
+struct Fix {
+  double tod;               // Seconds since midnight UTC (see FlightClock).
+  double lat;               // Degrees.
+  double lon;
+  double alt;               // Metres.
+  bool valid;               // False if the receiver had no fix.
+};
+
+/*
+ * The sensor readings of a $HAB record.
+ */
+struct HabSample {
+  double tod;
+  bool timeValid;
+  double temp1;
+  double temp2;
+  int heater;               // 1 = on, 0 = off, -1 = not logged (text records).
+};
+
+/*
+ * The part of a log parsed by one thread.
+ */
+struct Chunk {
+  const char * start;
+  const char * end;
+  vector<Fix> ggaFixes;
+  vector<Fix> habFixes;
+  vector<HabSample> habs;
+  vector<size_t> restarts;  // Number of track fixes (GGA or $HAB) before each $HABRS record.
+  vector<size_t> habRestarts;
+  long date = -1;           // The first RMC date (ddmmyy) in the chunk.
+  double dateTod = 0;       // The time given with it.
+  unsigned long recCnt = 0;
+  unsigned long badCnt = 0; // Sentences with an incorrect checksum, invalid binary records.
+};
+
+
+/*
+ * Parse a decimal field.
+ */
+bool parseNumber(const NmeaField & fld, double & value) {
+  if (fld.len == 0) {
+    return false;
+  }
+  char buf[32];
+  size_t len = min((size_t) fld.len, sizeof(buf) - 1);
+  memcpy(buf, fld.ptr, len);
+  buf[len] = '\0';
+  char * end;
+  value = strtod(buf, &end);
+  return end != buf;
+}
+
+
+/*
+ * Parse an NMEA time (hhmmss.ss) into seconds since midnight.
+ */
+bool parseNmeaTime(const NmeaField & fld, double & tod) {
+  double hhmmss;
+  if (fld.len < 6 || !parseNumber(fld, hhmmss)) {
+    return false;
+  }
+  int whole = (int) hhmmss;
+  tod = whole / 10000 * 3600 + whole / 100 % 100 * 60 + (hhmmss - whole / 100 * 100);
+  return true;
+}
+
+
+/*
+ * Parse an NMEA position (d)ddmm.mmmm with its hemisphere into degrees.
+ */
+bool parseNmeaPosition(const NmeaField & value, const NmeaField & hemisphere, double & degrees) {
+  double v;
+  if (!parseNumber(value, v) || hemisphere.len != 1) {
+    return false;
+  }
+  double d = floor(v / 100);
+  degrees = d + (v - d * 100) / 60.0;
+  if (*hemisphere.ptr == 'S' || *hemisphere.ptr == 'W') {
+    degrees = -degrees;
+  }
+  return true;
+}
+
+
+/*
+ * Parse a GGA or RMC sentence.
+ */
+void parseSentence(Chunk & chunk, NmeaSentence & nmea, const char * text, size_t len) {
+  NmeaStatus status = nmea.parse(text, len);
+  if (nmea.getType() != NmeaTypeGGA && nmea.getType() != NmeaTypeRMC) {
+    return;
+  }
+  if (status != NmeaOk) {
+    chunk.badCnt++;
+    return;
+  }
+  Fix fix;
+  if (!parseNmeaTime(nmea.getField(1), fix.tod)) {
+    return;
+  }
+  if (nmea.getType() == NmeaTypeGGA) {
+    double quality = 0;
+    parseNumber(nmea.getField(6), quality);
+    fix.valid = quality > 0
+                && parseNmeaPosition(nmea.getField(2), nmea.getField(3), fix.lat)
+                && parseNmeaPosition(nmea.getField(4), nmea.getField(5), fix.lon)
+                && parseNumber(nmea.getField(9), fix.alt);
+    chunk.ggaFixes.push_back(fix);
+  } else if (chunk.date < 0) {
+    double date;
+    if (parseNumber(nmea.getField(9), date) && date > 0) {
+      chunk.date = (long) date;
+      chunk.dateTod = fix.tod;
+    }
+  }
+}
+
+
+/*
+ * Parse a text $HAB record. The header line (which names the fields) is skipped.
+ * Layout: $HAB,h:mm:ss,lat,lon,alt,hdop,satCnt,T1,T2,battV,...
+ */
+void parseHab(Chunk & chunk, const char * text, size_t len) {
+  double values[8];
+  int valueCnt = 0;
+  const char * end = text + len;
+  const char * p = (const char *) memchr(text, ',', len);
+  int32_t tod = p ? habParseTime(p + 1, end) : HAB_IDX_NO_TIME;
+  if (tod == HAB_IDX_NO_TIME) {
+    return;
+  }
+  p = (const char *) memchr(p + 1, ',', end - p - 1);
+  while (p && valueCnt < 8) {
+    NmeaField fld;
+    fld.ptr = p + 1;
+    const char * next = (const char *) memchr(p + 1, ',', end - p - 1);
+    fld.len = (next ? next : end) - fld.ptr;
+    if (!parseNumber(fld, values[valueCnt])) {
+      return;
+    }
+    valueCnt++;
+    p = next;
+  }
+  if (valueCnt < 7) {
+    return;
+  }
+
+  // A text record holds 0 for a position that is not valid.
+  Fix fix = { (double) tod, values[0], values[1], values[2], values[0] != 0 || values[1] != 0 };
+  chunk.habFixes.push_back(fix);
+  HabSample sample = { fix.tod, true, values[5], values[6], -1 };
+  chunk.habs.push_back(sample);
+}
+
+
+/*
+ * Parse a binary $HAB record of len bytes. Return false if it is not a valid record.
+ */
+bool parseBinaryHab(Chunk & chunk, const uint8_t * data, size_t len) {
+  HabRecord rec;
+  if (len < HAB_REC_HEADER_SIZE) {
+    return false;
+  }
+  memset(&rec, 0, sizeof(rec));
+  memcpy(&rec, data, min(len, sizeof(rec)));
+  unsigned int size = HAB_REC_HEADER_SIZE + rec.length;
+  if (rec.version != HAB_REC_VERSION || len != size + HAB_REC_CRC_SIZE
+        || (data[size] | data[size + 1] << 8) != habCrc16(data + 2, size - 2)) {
+    return false;
+  }
+  double tod = rec.hour * 3600.0 + rec.minute * 60 + rec.second;
+  bool timeValid = rec.flags & HAB_FLAG_TIME_VALID;
+  if (timeValid) {
+    Fix fix = { tod, rec.lat / 1000000.0, rec.lon / 1000000.0, rec.alt / 100.0,
+                (rec.flags & HAB_FLAG_LOC_VALID) && (rec.flags & HAB_FLAG_ALT_VALID) };
+    chunk.habFixes.push_back(fix);
+  }
+  HabSample sample = { tod, timeValid, rec.temp1 / 100.0, rec.temp2 / 100.0, (rec.flags & HAB_FLAG_HEATER_ON) ? 1 : 0 };
+  chunk.habs.push_back(sample);
+  return true;
+}
+
+
+/*
+ * Return the length of the binary record at p, or 0 if p is not the start of one.
+ */
+size_t binaryLength(const uint8_t * p, const uint8_t * end) {
+  if (end - p < HAB_REC_HEADER_SIZE || p[0] != HAB_REC_SYNC1 || p[1] != HAB_REC_SYNC2) {
+    return 0;
+  }
+  size_t len = HAB_REC_HEADER_SIZE + p[3] + HAB_REC_CRC_SIZE;
+  return len <= (size_t) (end - p) ? len : end - p;
+}
+
+
+/*
+ * Parse the records in a chunk. Binary records are skipped by their length, as
+ * they may contain LF bytes.
+ */
+void processChunk(Chunk & chunk) {
+  NmeaSentence nmea;
+  const char * p = chunk.start;
+  while (p < chunk.end) {
+    chunk.recCnt++;
+    size_t binLen = binaryLength((const uint8_t *) p, (const uint8_t *) chunk.end);
+    if (binLen) {
+      if (!parseBinaryHab(chunk, (const uint8_t *) p, binLen)) {
+        chunk.badCnt++;
+      }
+      p += binLen;
+      continue;
+    }
+    const char * eol = (const char *) memchr(p, '\n', chunk.end - p);
+    const char * next = eol ? eol + 1 : chunk.end;
+    size_t len = next - p;
+    if (len > 6 && p[0] == '$') {
+      if (memcmp(p, "$HAB,", 5) == 0) {
+        parseHab(chunk, p, len);
+      } else if (memcmp(p, "$HABRS,", 7) == 0 && isdigit((unsigned char) p[7])) {
+        chunk.restarts.push_back(chunk.ggaFixes.size());
+        chunk.habRestarts.push_back(chunk.habFixes.size());
+      } else if (memcmp(p + 3, "GGA,", 4) == 0 || memcmp(p + 3, "RMC,", 4) == 0) {
+        parseSentence(chunk, nmea, p, len);
+      }
+    }
+    p = next;
+  }
+}
+
+
+/*
+ * Return the start of the first record at or after p. Records start after a LF,
+ * with a '$', '!' (a sentence marked as invalid) or a binary record's sync bytes.
+ */
+const char * nextRecord(const char * p, const char * end) {
+  while (p < end) {
+    const char * eol = (const char *) memchr(p, '\n', end - p);
+    if (eol == NULL) {
+      return end;
+    }
+    p = eol + 1;
+    if (p < end && (*p == '$' || *p == '!' || binaryLength((const uint8_t *) p, (const uint8_t *) end))) {
+      return p;
+    }
+  }
+  return end;
+}
+
+
+/*
+ * Map a log and parse it in parallel, adding its chunks to the flight.
+ * The mapping is released once the chunks have been parsed.
+ */
+bool processLog(const char * file, unsigned int threadCnt, vector<Chunk> & chunks) {
+  int fd = open(file, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    cerr << "Error opening " << file << endl;
+    if (fd >= 0) {
+      close(fd);
+    }
+    return false;
+  }
+  size_t size = st.st_size;
+  if (size == 0) {
+    close(fd);
+    return true;
+  }
+  const char * data = (const char *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    cerr << "Error mapping " << file << endl;
+    return false;
+  }
+  madvise((void *) data, size, MADV_WILLNEED);
+
+  // Several chunks per thread, so that a thread which finishes early can take another.
+  size_t first = chunks.size();
+  const char * end = data + size;
+  size_t chunkCnt = min((size_t) threadCnt * 4, size / MIN_CHUNK_SIZE + 1);
+  const char * start = data;
+  for (size_t i = 1; i <= chunkCnt && start < end; i++) {
+    const char * chunkEnd = (i == chunkCnt) ? end : nextRecord(max(start, data + size / chunkCnt * i), end);
+    Chunk chunk;
+    chunk.start = start;
+    chunk.end = chunkEnd;
+    chunks.push_back(chunk);
+    start = chunkEnd;
+  }
+
+  atomic<size_t> nextChunk(first);
+  vector<thread> workers;
+  for (unsigned int t = 0; t < threadCnt; t++) {
+    workers.emplace_back([&chunks, &nextChunk]() {
+      size_t i;
+      while ((i = nextChunk++) < chunks.size()) {
+        processChunk(chunks[i]);
+      }
+    });
+  }
+  for (thread & worker : workers) {
+    worker.join();
+  }
+  munmap((void *) data, size);
+  return true;
+}
+
+
+/*
+ * A point of the flight in time order, with the time made continuous across midnight.
+ */
+struct TrackPoint {
+  double t;                 // Seconds since midnight UTC of the first day.
+  double lat;
+  double lon;
+  double alt;
+  bool valid;
+};
+
+/*
+ * Converts times of day into a continuous time, allowing for midnight.
+ */
+class FlightClock {
+  public:
+    double toTime(double tod) {
+      double t = tod + dayOffset;
+      if (started && t < last - 43200) {
+        dayOffset += 86400;
+        t += 86400;
+      }
+      started = true;
+      last = t;
+      return t;
+    }
+    double getDayOffset() const { return dayOffset; }
+
+  private:
+    bool started = false;
+    double last = 0;
+    double dayOffset = 0;
+};
+
+
+/*
+ * Days since 1970-01-01 of a date given as ddmmyy.
+ */
+long daysFromDate(long ddmmyy) {
+  struct tm tm;
+  memset(&tm, 0, sizeof(tm));
+  tm.tm_mday = ddmmyy / 10000;
+  tm.tm_mon = ddmmyy / 100 % 100 - 1;
+  tm.tm_year = ddmmyy % 100 + 100;
+  return timegm(&tm) / 86400;
+}
+
+
+/*
+ * Format a continuous time as h:mm:ss (the hours continue past 24 after midnight).
+ */
+string formatTime(double t) {
+  char buf[32];
+  long secs = lround(t);
+  snprintf(buf, sizeof(buf), "%ld:%02ld:%02ld", secs / 3600, secs / 60 % 60, secs % 60);
+  return buf;
+}
+
+string formatDuration(double secs) {
+  char buf[32];
+  long s = lround(secs);
+  snprintf(buf, sizeof(buf), "%ldh %02ldm %02lds", s / 3600, s / 60 % 60, s % 60);
+  return buf;
+}
+
+
+/*
+ * Distance between two positions (m), using a spherical earth.
+ */
+double distance(double lat1, double lon1, double lat2, double lon2) {
+  const double rad = M_PI / 180.0;
+  double dLat = (lat2 - lat1) * rad;
+  double dLon = (lon2 - lon1) * rad;
+  double a = sin(dLat / 2) * sin(dLat / 2) + cos(lat1 * rad) * cos(lat2 * rad) * sin(dLon / 2) * sin(dLon / 2);
+  return 6371000.0 * 2 * atan2(sqrt(a), sqrt(1 - a));
+}
+
+
+/*
+ * Write the track as KML.
+ */
+bool writeKml(const char * file, const vector<TrackPoint> & track) {
+  FILE * out = fopen(file, "w");
+  if (!out) {
+    cerr << "Error creating " << file << endl;
+    return false;
+  }
+  fprintf(out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  fprintf(out, "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n<Document>\n<name>HAB flight</name>\n");
+  fprintf(out, "<Placemark>\n<name>Track</name>\n<LineString>\n<extrude>1</extrude>\n");
+  fprintf(out, "<altitudeMode>absolute</altitudeMode>\n<coordinates>\n");
+  for (const TrackPoint & pt : track) {
+    if (pt.valid) {
+      fprintf(out, "%.6f,%.6f,%.1f\n", pt.lon, pt.lat, pt.alt);
+    }
+  }
+  fprintf(out, "</coordinates>\n</LineString>\n</Placemark>\n</Document>\n</kml>\n");
+  return fclose(out) == 0;
+}
+
+
+/*
+ * Write the track as GPX. epochDay is the day of the first point, or -1 if not known.
+ */
+bool writeGpx(const char * file, const vector<TrackPoint> & track, long epochDay) {
+  FILE * out = fopen(file, "w");
+  if (!out) {
+    cerr << "Error creating " << file << endl;
+    return false;
+  }
+  fprintf(out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  fprintf(out, "<gpx version=\"1.1\" creator=\"habflight %s\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n", VERSION);
+  fprintf(out, "<trk>\n<name>HAB flight</name>\n<trkseg>\n");
+  for (const TrackPoint & pt : track) {
+    if (!pt.valid) {
+      continue;
+    }
+    fprintf(out, "<trkpt lat=\"%.6f\" lon=\"%.6f\"><ele>%.1f</ele>", pt.lat, pt.lon, pt.alt);
+    if (epochDay >= 0) {
+      time_t secs = epochDay * 86400 + (time_t) pt.t;
+      struct tm tm;
+      gmtime_r(&secs, &tm);
+      char buf[40];
+      strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+      fprintf(out, "<time>%s</time>", buf);
+    }
+    fprintf(out, "</trkpt>\n");
+  }
+  fprintf(out, "</trkseg>\n</trk>\n</gpx>\n");
+  return fclose(out) == 0;
+}
+
+
+/*
+ * Join the chunks in order and report the flight metrics.
+ */
+void analyse(vector<Chunk> & chunks, double dropoutSecs, const char * kmlFile, const char * gpxFile) {
+  // Use the GGA sentences for the track if there are any.
+  bool useGga = false;
+  unsigned long recCnt = 0;
+  unsigned long badCnt = 0;
+  for (const Chunk & chunk : chunks) {
+    useGga |= !chunk.ggaFixes.empty();
+    recCnt += chunk.recCnt;
+    badCnt += chunk.badCnt;
+  }
+
+  vector<TrackPoint> track;
+  FlightClock clock;
+  long epochDay = -1;
+  vector<size_t> restarts;          // Index of the first track point after each restart.
+  for (Chunk & chunk : chunks) {
+    vector<Fix> & fixes = useGga ? chunk.ggaFixes : chunk.habFixes;
+    for (size_t i : useGga ? chunk.restarts : chunk.habRestarts) {
+      restarts.push_back(track.size() + i);
+    }
+    bool dateUsed = false;
+    for (const Fix & fix : fixes) {
+      TrackPoint pt = { clock.toTime(fix.tod), fix.lat, fix.lon, fix.alt, fix.valid };
+      track.push_back(pt);
+      if (epochDay < 0 && chunk.date >= 0 && !dateUsed && fix.tod >= chunk.dateTod) {
+        // The day of the RMC date, less the days since the first point.
+        epochDay = daysFromDate(chunk.date) - (long) (clock.getDayOffset() / 86400);
+        dateUsed = true;
+      }
+    }
+    vector<Fix>().swap(fixes);
+  }
+
+  printf("Records: %lu, invalid: %lu, track points: %zu (from %s)\n", recCnt, badCnt, track.size(),
+         useGga ? "GGA" : "$HAB");
+
+  // Single pass over the track.
+  const TrackPoint * firstFix = NULL;
+  const TrackPoint * launch = NULL;
+  const TrackPoint * burst = NULL;
+  const TrackPoint * lastFix = NULL;
+  double timeAboveRecord = 0;
+  double lastValidTime = 0;
+  bool haveValid = false;
+  vector<pair<double, double>> dropouts;
+  for (const TrackPoint & pt : track) {
+    if (!pt.valid) {
+      continue;
+    }
+    if (haveValid && pt.t - lastValidTime >= dropoutSecs) {
+      dropouts.push_back(make_pair(lastValidTime, pt.t));
+    }
+    if (firstFix == NULL) {
+      firstFix = &pt;
+    }
+    if (launch == NULL && pt.alt >= firstFix->alt + LAUNCH_ALT_GAIN) {
+      launch = &pt;
+    }
+    if (burst == NULL || pt.alt > burst->alt) {
+      burst = &pt;
+    }
+    if (lastFix && lastFix->alt > ALTITUDE_RECORD_LOW && pt.alt > ALTITUDE_RECORD_LOW) {
+      timeAboveRecord += pt.t - lastFix->t;
+    }
+    lastFix = &pt;
+    lastValidTime = pt.t;
+    haveValid = true;
+  }
+
+  if (firstFix == NULL) {
+    printf("No GPS fixes.\n");
+  } else {
+    // The landing is the first point after the burst that is near the final altitude.
+    const TrackPoint * landing = NULL;
+    for (const TrackPoint * pt = burst; pt <= lastFix; pt++) {
+      if (pt->valid && pt->alt <= lastFix->alt + LANDING_ALT_TOL) {
+        landing = pt;
+        break;
+      }
+    }
+
+    printf("First fix:          %s  %.6f, %.6f  %.1f m\n", formatTime(firstFix->t).c_str(), firstFix->lat, firstFix->lon, firstFix->alt);
+    if (launch) {
+      printf("Launch:             %s  %.1f m\n", formatTime(launch->t).c_str(), launch->alt);
+    }
+    printf("Burst:              %s  %.6f, %.6f  %.1f m\n", formatTime(burst->t).c_str(), burst->lat, burst->lon, burst->alt);
+    if (launch && burst->t > launch->t) {
+      printf("Ascent:             %s, %.2f m/s average\n", formatDuration(burst->t - launch->t).c_str(),
+             (burst->alt - launch->alt) / (burst->t - launch->t));
+    }
+    if (landing && landing->t > burst->t) {
+      printf("Descent:            %s, %.2f m/s average\n", formatDuration(landing->t - burst->t).c_str(),
+             (burst->alt - landing->alt) / (landing->t - burst->t));
+      printf("Landing:            %s  %.6f, %.6f  %.1f m\n", formatTime(landing->t).c_str(), landing->lat, landing->lon, landing->alt);
+      if (launch) {
+        printf("Flight time:        %s\n", formatDuration(landing->t - launch->t).c_str());
+        printf("Distance:           %.1f km from the launch\n", distance(launch->lat, launch->lon, landing->lat, landing->lon) / 1000.0);
+      }
+    }
+    string label = "Above " + to_string((long) ALTITUDE_RECORD_LOW) + " m:";
+    printf("%-20s%s%s\n", label.c_str(), formatDuration(timeAboveRecord).c_str(),
+           burst->alt > ALTITUDE_RECORD_LOW ? "  (record broken)" : "");
+  }
+
+  // Heater duty cycle, from the $HAB records.
+  double heaterOn = 0;
+  double heaterTotal = 0;
+  bool estimated = false;
+  bool heater = false;
+  bool havePrev = false;
+  double prevTime = 0;
+  FlightClock habClock;
+  for (const Chunk & chunk : chunks) {
+    for (const HabSample & sample : chunk.habs) {
+      if (!sample.timeValid) {
+        continue;
+      }
+      double t = habClock.toTime(sample.tod);
+      if (havePrev && t > prevTime) {
+        heaterTotal += t - prevTime;
+        heaterOn += heater ? t - prevTime : 0;
+      }
+      if (sample.heater >= 0) {
+        heater = sample.heater;
+      } else {
+        // Apply the logger's hysteresis to the sensor that controls the heater.
+        double temp = HEATER_TEMP_SENSOR == INTERNAL_TEMP ? sample.temp1 : sample.temp2;
+        if (temp <= HEATER_ON_TEMP) {
+          heater = true;
+        } else if (temp >= HEATER_OFF_TEMP) {
+          heater = false;
+        }
+        estimated = true;
+      }
+      prevTime = t;
+      havePrev = true;
+    }
+  }
+  if (heaterTotal > 0) {
+    printf("Heater duty cycle:  %.1f%% (%s of %s)%s\n", heaterOn / heaterTotal * 100.0, formatDuration(heaterOn).c_str(),
+           formatDuration(heaterTotal).c_str(), estimated ? "  (estimated from temperature)" : "");
+  }
+
+  printf("GPS dropouts of %.0f s or more: %zu\n", dropoutSecs, dropouts.size());
+  for (const pair<double, double> & d : dropouts) {
+    printf("  %s - %s  %s\n", formatTime(d.first).c_str(), formatTime(d.second).c_str(), formatDuration(d.second - d.first).c_str());
+  }
+
+  printf("Warm restarts: %zu\n", restarts.size());
+  for (size_t i : restarts) {
+    if (i > 0 && i < track.size()) {
+      printf("  %s - %s  %s\n", formatTime(track[i - 1].t).c_str(), formatTime(track[i].t).c_str(),
+             formatDuration(track[i].t - track[i - 1].t).c_str());
+    } else {
+      printf("  %s\n", i == 0 ? "before the first fix" : "after the last fix");
+    }
+  }
+
+  if (kmlFile && writeKml(kmlFile, track)) {
+    cerr << "Track written to " << kmlFile << endl;
+  }
+  if (gpxFile && writeGpx(gpxFile, track, epochDay)) {
+    cerr << "Track written to " << gpxFile << endl;
+  }
+}
+
+
+/* main
+ * ----
+ * Parse the options, then analyse the logs as one flight.
+ */
+int main(int argc, const char * argv[]) {
+  unsigned int threadCnt = max(1u, thread::hardware_concurrency());
+  double dropoutSecs = 5;
+  const char * kmlFile = NULL;
+  const char * gpxFile = NULL;
+  vector<const char *> files;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threadCnt = max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+      dropoutSecs = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--kml") == 0 && i + 1 < argc) {
+      kmlFile = argv[++i];
+    } else if (strcmp(argv[i], "--gpx") == 0 && i + 1 < argc) {
+      gpxFile = argv[++i];
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) {
+    cerr << "habflight v" << VERSION << endl;
+    cerr << "Usage: habflight [-j threads] [-g secs] [--kml file.kml] [--gpx file.gpx] file.log ..." << endl;
+    return 1;
+  }
+
+  auto start = chrono::steady_clock::now();
+  vector<Chunk> chunks;
+  size_t bytes = 0;
+  for (const char * file : files) {
+    struct stat st;
+    if (stat(file, &st) == 0) {
+      bytes += st.st_size;
+    }
+    if (!processLog(file, threadCnt, chunks)) {
+      return 1;
+    }
+  }
+  double parseSecs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  analyse(chunks, dropoutSecs, kmlFile, gpxFile);
+
+  double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "%zu bytes in %.3f s (parsed in %.3f s, %.0f MB/s, %u threads)\n", bytes, secs, parseSecs,
+          bytes / parseSecs / 1e6, threadCnt);
+  return 0;
+}
@@ -0,0 +1,578 @@
+/**
+  * habgen.cpp
+  * ----------
+  *
+  * Generate a realistic hab log of any size, as a repeatable workload for measuring
+  * gpschksum, the other host tools and the logger's NMEA path.
+  *
+  * A flight is simulated once a second: a wait on the ground, an ascent to burst, a
+  * descent under a parachute and a wait after landing. Flights follow one another until
+  * the log reaches the requested size. The log holds what habFlightMonitor writes:
+  *   - the logHeader() lines,
+  *   - GNRMC and GNGGA sentences for each fix, and GNTXT messages from time to time,
+  *   - $HAB records (text, or binary with --binary) at the LOG_PHASE_INTERVALS_MS of the
+  *     flight phase, and every LOG_TRANSITION_INTERVAL_MS after a phase change. The
+  *     per phase budgets are not applied.
+  * The GPS loses its fix for a while during each flight.
+  *
+  * Lines can be corrupted at random, as happens on a real flight. Each rate is the
+  * probability that a line is affected:
+  *   --flip     one bit of the line is inverted.
+  *   --trunc    the line is cut short (the line terminator is kept).
+  *   --nocrlf   the CR, LF or both are dropped.
+  * The same seed always gives the same log.
+  *
+  * By: G. McCall
+  *     Oct-2026
+  *
+  * Usage:
+  *   habgen [options] > file.log
+  *
+  *   -o file         Write to file rather than stdout.
+  *   -s size         Size of the log, in bytes with an optional K, M or G suffix (default 10M).
+  *   -n flights      Stop after this many complete flights rather than at a size.
+  *   --seed n        Random number seed (default 1).
+  *   --start h:mm    UTC time of the first fix (default 9:00).
+  *   --burst m       Burst altitude (default 33000).
+  *   --ascent m/s    Ascent rate (default 5).
+  *   --binary        Write binary $HAB records (LOG_BINARY_HAB).
+  *   --flip rate     Bit flip rate (default 0).
+  *   --trunc rate    Truncation rate (default 0).
+  *   --nocrlf rate   Dropped CR/LF rate (default 0).
+  *
+  *   A summary, including the number of each kind of corruption, is written to stderr.
+  *
+  * Build:
+  *   g++ -O2 -o habgen habgen.cpp
+  *
+  * History:
+  *
+  *  v1.02.00.00 - 17-Oct-2026
+  *    $HAB records are written at the logger's flight phase intervals.
+  *
+  *  v1.01.00.00 - 17-Oct-2026
+  *    $HAB record version 4: latency timer summaries replace the log time history.
+  *
+  *  v1.00.00.00 - 17-Oct-2026
+  *    Initial version.
+  */
+
+#define VERSION "1.02.00.00"
+
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#include "../habFlightMonitor/hab_config.h"
+#include "../habFlightMonitor/HabRecord.h"
+
+using namespace std;
+
+#define GROUND_ALT        120.0     // Metres.
+#define PRELAUNCH_SECS    900       // Time on the ground before the launch.
+#define LANDED_SECS       1800      // Time on the ground after the landing.
+#define DESCENT_RATE      5.0       // Descent rate at sea level (m/s).
+#define DROPOUT_START_ALT 18000.0   // The fix is lost for a while when the balloon first climbs past this.
+#define DROPOUT_SECS      40
+
+
+
+/*
+ * Small, fast random number generator (xorshift64*). Used rather than <random> so
+ * that the same seed gives the same log with any compiler.
+ */
+class Random {
+  public:
+    Random(uint64_t seed) : state(seed ? seed * 0x9E3779B97F4A7C15ULL : 1) {}
+
+    uint64_t next() {
+      state ^= state >> 12;
+      state ^= state << 25;
+      state ^= state >> 27;
+      return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // Uniform in [0, 1).
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Uniform in [0, n).
+    unsigned int below(unsigned int n) { return n ? (unsigned int) (uniform() * n) : 0; }
+
+    bool chance(double p) { return p > 0 && uniform() < p; }
+
+  private:
+    uint64_t state;
+};
+
+
+/*
+ * Writes lines to the log, corrupting some of them.
+ */
+class LogWriter {
+  public:
+    LogWriter(FILE * out, uint64_t seed) : rnd(seed), out(out) {}
+
+    double flipRate = 0;
+    double truncRate = 0;
+    double noCrLfRate = 0;
+
+    unsigned long lineCnt = 0;
+    unsigned long flipCnt = 0;
+    unsigned long truncCnt = 0;
+    unsigned long noCrLfCnt = 0;
+    uint64_t bytes = 0;
+
+    /*
+     * Write a line of text, adding the CR/LF.
+     */
+    void line(const char * text) {
+      char buf[600];
+      size_t len = strlen(text);
+      if (len > sizeof(buf) - 2) {
+        len = sizeof(buf) - 2;
+      }
+      memcpy(buf, text, len);
+      lineCnt++;
+
+      if (len > 1 && rnd.chance(truncRate)) {
+        len = 1 + rnd.below(len - 1);
+        truncCnt++;
+      }
+      if (len > 0 && rnd.chance(flipRate)) {
+        buf[rnd.below(len)] ^= 1 << rnd.below(8);
+        flipCnt++;
+      }
+      const char * eol = "\r\n";
+      if (rnd.chance(noCrLfRate)) {
+        static const char * broken[] = { "\n", "\r", "" };
+        eol = broken[rnd.below(3)];
+        noCrLfCnt++;
+      }
+      size_t eolLen = strlen(eol);
+      memcpy(buf + len, eol, eolLen);
+      write(buf, len + eolLen);
+    }
+
+    /*
+     * Write an NMEA sentence, adding the '$', checksum and CR/LF.
+     */
+    void sentence(const char * body) {
+      uint8_t parity = 0;
+      for (const char * p = body; *p; p++) {
+        parity ^= *p;
+      }
+      char buf[300];
+      snprintf(buf, sizeof(buf), "$%s*%02X", body, parity);
+      line(buf);
+    }
+
+    /*
+     * Write a binary record. These are not corrupted, as a flipped bit in the length
+     * would make the rest of the log unreadable, which is not what the logger produces.
+     */
+    void binary(const void * data, size_t len) {
+      write(data, len);
+    }
+
+    Random rnd;
+
+  private:
+    void write(const void * data, size_t len) {
+      fwrite(data, 1, len, out);
+      bytes += len;
+    }
+
+    FILE * out;
+};
+
+
+/*
+ * The state of the simulated flight.
+ */
+class Flight {
+  public:
+    Flight(double burstAlt, double ascentRate) : burstAlt(burstAlt), ascentRate(ascentRate) {
+      restart();
+    }
+
+    // Start the next flight from where the last one landed.
+    void restart() {
+      phase = Waiting;
+      phaseSecs = 0;
+      alt = GROUND_ALT;
+      dropoutLeft = 0;
+      dropoutDone = false;
+    }
+
+    /*
+     * Advance the flight by a second.
+     */
+    void step(Random & rnd) {
+      phaseSecs++;
+      switch (phase) {
+        case Waiting:
+          if (phaseSecs >= PRELAUNCH_SECS) {
+            phase = Ascending;
+            phaseSecs = 0;
+          }
+          break;
+        case Ascending:
+          alt += ascentRate * (0.9 + 0.2 * rnd.uniform());
+          if (alt >= burstAlt) {
+            phase = Descending;
+            phaseSecs = 0;
+          }
+          break;
+        case Descending:
+          // The parachute is less effective in thin air.
+          alt -= DESCENT_RATE * sqrt(exp(alt / 7200.0)) * (0.9 + 0.2 * rnd.uniform());
+          if (alt <= GROUND_ALT) {
+            alt = GROUND_ALT;
+            phase = Landed;
+            phaseSecs = 0;
+          }
+          break;
+        case Landed:
+          if (phaseSecs >= LANDED_SECS) {
+            restart();
+          }
+          break;
+      }
+
+      // Drift with the wind, which is strongest in the jet stream.
+      if (phase == Ascending || phase == Descending) {
+        double wind = 5.0 + 25.0 * exp(-pow((alt - 11000.0) / 3000.0, 2));
+        lon += wind / (111320.0 * cos(lat * M_PI / 180.0));
+        lat -= 1.5 / 110540.0;
+      }
+
+      if (!dropoutDone && alt >= DROPOUT_START_ALT) {
+        dropoutDone = true;
+        dropoutLeft = DROPOUT_SECS;
+      } else if (dropoutLeft > 0) {
+        dropoutLeft--;
+      }
+
+      // Air temperature (standard atmosphere), and the payload, which is kept warm
+      // by the heater.
+      tempExternal = alt < 11000 ? 15.0 - 0.0065 * alt : alt < 20000 ? -56.5 : -56.5 + 0.001 * (alt - 20000);
+      double target = heaterOn ? tempExternal + 45.0 : tempExternal + 25.0;
+      tempInternal += (target - tempInternal) / 300.0;
+      if (tempInternal <= HEATER_ON_TEMP) {
+        heaterOn = true;
+      } else if (tempInternal >= HEATER_OFF_TEMP) {
+        heaterOn = false;
+      }
+      battV -= (heaterOn ? 0.00004 : 0.00001);
+      if (battV < 3.3) {
+        battV = 4.2;      // A fresh battery for the next flight.
+      }
+    }
+
+    bool hasFix() const { return dropoutLeft == 0; }
+
+    // The flight phase as the logger sees it, an index into the LOG_PHASE_xxx tables
+    // (see FlightPhase in habFlightMonitor/hab.h).
+    int logPhase() const {
+      switch (phase) {
+        case Ascending:   return 1;
+        case Descending:  return phaseSecs * 1000 < PHASE_BURST_MS ? 3 : 4;
+        case Landed:      return 5;
+        default:          return 0;
+      }
+    }
+
+    // True once a second into the wait before each launch.
+    bool isStarting() const { return phase == Waiting && phaseSecs == 1; }
+
+    double alt = GROUND_ALT;
+    double lat = -33.868820;
+    double lon = 151.209296;
+    double tempInternal = 20.0;
+    double tempExternal = 15.0;
+    double battV = 4.2;
+    bool heaterOn = false;
+
+  private:
+    enum Phase { Waiting, Ascending, Descending, Landed };
+
+    double burstAlt;
+    double ascentRate;
+    Phase phase;
+    long phaseSecs;
+    int dropoutLeft;
+    bool dropoutDone;
+};
+
+
+/*
+ * Write the header lines, as written by logHeader() in habFlightMonitor.ino.
+ */
+void writeHeader(LogWriter & log) {
+  log.line(HAB_LOG_HEADER);
+  log.line("$GPRMC,time,status,lat,ns,lon,ew,spdKnot,cog,date,mv,mvEW,posMode,navStatus,chksum");
+  log.line("$GPGGA,time,lat,ns,lon,ew,quality,numSV,hdop,alt,altU,sep,sepU,diffAge,diffStation,chksum");
+  log.line("$GNRMC,time,status,lat,ns,lon,ew,spdKnot,cog,date,mv,mvEW,posMode,navStatus,chksum");
+  log.line("$GNGGA,time,lat,ns,lon,ew,quality,numSV,hdop,alt,altU,sep,sepU,diffAge,diffStation,chksum");
+  log.line("$GNTXT,numMsg,msgNum,msgType,text,chksum");
+  log.line("$GPTXT,numMsg,msgNum,msgType,text,chksum");
+}
+
+
+/*
+ * Format a position as NMEA (d)ddmm.mmmmm and its hemisphere.
+ */
+void formatPosition(char * buf, size_t size, double degrees, int degreeDigits, char pos, char neg) {
+  double a = fabs(degrees);
+  int d = (int) a;
+  snprintf(buf, size, "%0*d%08.5f,%c", degreeDigits, d, (a - d) * 60.0, degrees < 0 ? neg : pos);
+}
+
+
+/*
+ * Write the GNRMC and GNGGA sentences for a second.
+ */
+void writeFix(LogWriter & log, const Flight & flight, long t, int day) {
+  char time[16], date[8], lat[24], lon[24], body[200];
+  snprintf(time, sizeof(time), "%02ld%02ld%02ld.00", t / 3600 % 24, t / 60 % 60, t % 60);
+  snprintf(date, sizeof(date), "%02d1026", 17 + day % 14);
+  formatPosition(lat, sizeof(lat), flight.lat, 2, 'N', 'S');
+  formatPosition(lon, sizeof(lon), flight.lon, 3, 'E', 'W');
+
+  if (flight.hasFix()) {
+    snprintf(body, sizeof(body), "GNRMC,%s,A,%s,%s,%.3f,,%s,,,A,V", time, lat, lon, 3.2 + log.rnd.uniform(), date);
+    log.sentence(body);
+    snprintf(body, sizeof(body), "GNGGA,%s,%s,%s,1,%02u,%.2f,%.1f,M,21.3,M,,", time, lat, lon,
+             8 + log.rnd.below(5), 0.6 + 0.4 * log.rnd.uniform(), flight.alt);
+    log.sentence(body);
+  } else {
+    snprintf(body, sizeof(body), "GNRMC,%s,V,,,,,,,%s,,,N,V", time, date);
+    log.sentence(body);
+    snprintf(body, sizeof(body), "GNGGA,%s,,,,,0,00,99.99,,,,,,", time);
+    log.sentence(body);
+  }
+}
+
+
+/*
+ * A latency timer of the logger: how many timings it takes in a log interval and how
+ * long they take (us). A few of them are slow (e.g. when the SD card is busy).
+ */
+struct TimerModel {
+  unsigned int cnt;
+  unsigned int cntSpread;
+  uint32_t us;
+  uint32_t usSpread;
+  double slowRate;
+  uint32_t slowUs;
+};
+
+static const TimerModel timerModels[HAB_REC_TIMER_CNT] = {
+  { 400, 200,     6,    20, 0.02, 20000 },    // loop
+  {   4,   4,   150,   400, 0.05,  3000 },    // gps
+  {   4,   2,   700,   200, 0.00,     0 },    // temp
+  {   2,   4, 12000, 14000, 0.00,     0 },    // oled
+  {   4,   4,    40,    60, 0.10,  6000 },    // sd
+};
+
+
+/*
+ * Fill the latency histograms for a log interval.
+ */
+void simulateTimers(Random & rnd, LatencyHistogram * hists) {
+  for (int i = 0; i < HAB_REC_TIMER_CNT; i++) {
+    const TimerModel & m = timerModels[i];
+    hists[i].reset();
+    unsigned int cnt = m.cnt + rnd.below(m.cntSpread);
+    for (unsigned int j = 0; j < cnt; j++) {
+      uint32_t us = m.us + rnd.below(m.usSpread);
+      if (rnd.chance(m.slowRate)) {
+        us += rnd.below(m.slowUs);
+      }
+      hists[i].record(us);
+    }
+  }
+}
+
+
+/*
+ * Write a $HAB record, in the layout written by logData().
+ */
+void writeHab(LogWriter & log, const Flight & flight, long t, bool binary, uint32_t logCnt) {
+  Random & rnd = log.rnd;
+  static LatencyHistogram hists[HAB_REC_TIMER_CNT];
+  simulateTimers(rnd, hists);
+  double hdop = flight.hasFix() ? 0.6 + 0.4 * rnd.uniform() : 0;
+  int satCnt = flight.hasFix() ? 8 + rnd.below(5) : 0;
+
+  if (binary) {
+    HabRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.hour = t / 3600 % 24;
+    rec.minute = t / 60 % 60;
+    rec.second = t % 60;
+    rec.flags = HAB_FLAG_TIME_VALID | (flight.hasFix() ? HAB_FLAG_LOC_VALID | HAB_FLAG_ALT_VALID | HAB_FLAG_HDOP_VALID | HAB_FLAG_SAT_VALID : 0)
+              | (flight.alt > ALTITUDE_RECORD_LOW ? HAB_FLAG_RECORD_BROKEN : 0) | (flight.heaterOn ? HAB_FLAG_HEATER_ON : 0);
+    rec.lat = lround(flight.lat * 1000000.0);
+    rec.lon = lround(flight.lon * 1000000.0);
+    rec.alt = lround(flight.alt * 100.0);
+    rec.hdop = lround(hdop * 10000.0);
+    rec.satCnt = satCnt;
+    rec.temp1 = lround(flight.tempInternal * 100.0);
+    rec.temp2 = lround(flight.tempExternal * 100.0);
+    rec.battV = lround(flight.battV * 100.0);
+    rec.logCnt = logCnt;
+    for (int i = 0; i < HAB_REC_TIMER_CNT; i++) {
+      habSummariseTimer(rec.timers[i], hists[i]);
+    }
+    log.binary(&rec, habFinishRecord(rec));
+    return;
+  }
+
+  char buf[600];
+  int n = snprintf(buf, sizeof(buf), "$HAB,%ld:%02ld:%02ld,%.6f,%.6f,%.2f,%.4f,%d,%.2f,%.2f,%.2f,%u,%u,%u,%u,%u,%u",
+                   t / 3600 % 24, t / 60 % 60, t % 60, flight.hasFix() ? flight.lat : 0.0, flight.hasFix() ? flight.lon : 0.0,
+                   flight.hasFix() ? flight.alt : 0.0, hdop, satCnt, flight.tempInternal, flight.tempExternal, flight.battV,
+                   0u, 0u, 0u, 0u, 0u, logCnt);
+  for (const LatencyHistogram & hist : hists) {
+    n += snprintf(buf + n, sizeof(buf) - n, ",%u,%u,%u,%u,%u", hist.getCount(), hist.percentile(50), hist.percentile(90),
+                  hist.percentile(99), hist.getMax());
+  }
+  log.line(buf);
+}
+
+
+/*
+ * Parse a size with an optional K, M or G suffix.
+ */
+uint64_t parseSize(const char * text) {
+  char * end;
+  double size = strtod(text, &end);
+  switch (*end) {
+    case 'k': case 'K': size *= 1024; break;
+    case 'm': case 'M': size *= 1024 * 1024; break;
+    case 'g': case 'G': size *= 1024.0 * 1024 * 1024; break;
+  }
+  return (uint64_t) size;
+}
+
+
+/* main
+ * ----
+ * Simulate flights until the log is big enough.
+ */
+int main(int argc, const char * argv[]) {
+  const char * outFile = NULL;
+  uint64_t size = 10 * 1024 * 1024;
+  long flightCnt = 0;
+  uint64_t seed = 1;
+  long start = 9 * 3600;
+  double burstAlt = 33000;
+  double ascentRate = 5;
+  bool binary = false;
+  double flipRate = 0, truncRate = 0, noCrLfRate = 0;
+
+  for (int i = 1; i < argc; i++) {
+    const char * opt = argv[i];
+    const char * arg = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(opt, "--binary") == 0) {
+      binary = true;
+      continue;
+    }
+    if (arg == NULL) {
+      cerr << "Usage: habgen [-o file] [-s size | -n flights] [--seed n] [--start h:mm] [--burst m] [--ascent m/s] [--binary]"
+           << " [--flip rate] [--trunc rate] [--nocrlf rate]" << endl;
+      return 1;
+    }
+    i++;
+    if (strcmp(opt, "-o") == 0) {
+      outFile = arg;
+    } else if (strcmp(opt, "-s") == 0) {
+      size = parseSize(arg);
+    } else if (strcmp(opt, "-n") == 0) {
+      flightCnt = atol(arg);
+      size = UINT64_MAX;
+    } else if (strcmp(opt, "--seed") == 0) {
+      seed = strtoull(arg, NULL, 10);
+    } else if (strcmp(opt, "--start") == 0) {
+      int h = 0, m = 0;
+      sscanf(arg, "%d:%d", &h, &m);
+      start = h * 3600L + m * 60L;
+    } else if (strcmp(opt, "--burst") == 0) {
+      burstAlt = atof(arg);
+    } else if (strcmp(opt, "--ascent") == 0) {
+      ascentRate = atof(arg);
+    } else if (strcmp(opt, "--flip") == 0) {
+      flipRate = atof(arg);
+    } else if (strcmp(opt, "--trunc") == 0) {
+      truncRate = atof(arg);
+    } else if (strcmp(opt, "--nocrlf") == 0) {
+      noCrLfRate = atof(arg);
+    } else {
+      cerr << "Unknown option: " << opt << endl;
+      return 1;
+    }
+  }
+
+  FILE * out = outFile ? fopen(outFile, "wb") : stdout;
+  if (!out) {
+    cerr << "Error creating " << outFile << endl;
+    return 1;
+  }
+  static char outBuf[1024 * 1024];
+  setvbuf(out, outBuf, _IOFBF, sizeof(outBuf));
+
+  LogWriter log(out, seed);
+  log.flipRate = flipRate;
+  log.truncRate = truncRate;
+  log.noCrLfRate = noCrLfRate;
+  Flight flight(burstAlt, ascentRate);
+
+  writeHeader(log);
+  static const long phaseIntervalMs[] = LOG_PHASE_INTERVALS_MS;
+  int logPhase = flight.logPhase();
+  long phaseMs = LOG_TRANSITION_MS;       // No transition at the start.
+  long msSinceLog = phaseIntervalMs[logPhase];
+  uint32_t logCnt = 0;
+  unsigned long habCnt = 0;
+  long flightsStarted = 0;
+  for (long t = start; log.bytes < size; t++) {
+    flight.step(log.rnd);
+    if (flight.isStarting() && flightCnt > 0 && ++flightsStarted > flightCnt) {
+      break;
+    }
+    writeFix(log, flight, t, (int) (t / 86400));
+    if (t % 60 == 0) {
+      log.sentence("GNTXT,01,01,02,ANTSTATUS=OK");
+    }
+
+    // The log rate changes with the flight phase, as in getLogInterval().
+    if (flight.logPhase() != logPhase) {
+      logPhase = flight.logPhase();
+      phaseMs = 0;
+    } else {
+      phaseMs += 1000;
+    }
+    long logIntervalMs = phaseMs < LOG_TRANSITION_MS ? LOG_TRANSITION_INTERVAL_MS : phaseIntervalMs[logPhase];
+    msSinceLog += 1000;
+    if (msSinceLog >= logIntervalMs) {
+      msSinceLog = 0;
+      writeHab(log, flight, t, binary, logCnt++);
+      habCnt++;
+    }
+  }
+
+  if (outFile && fclose(out) != 0) {
+    cerr << "Error writing " << outFile << endl;
+    return 1;
+  }
+  fflush(out);
+  cerr << "habgen v" << VERSION << ": " << log.bytes << " bytes, " << log.lineCnt << " lines, " << habCnt
+       << " $HAB records" << (binary ? " (binary)" : "") << ". Corrupted lines - bit flips: " << log.flipCnt
+       << ", truncated: " << log.truncCnt << ", CR/LF dropped: " << log.noCrLfCnt << endl;
+  return 0;
+}
@@ -0,0 +1,638 @@
+/**
+  * habget.cpp
+  * ----------
+  *
+  * Copy a file from the SD card of a GPSCheckSumArduino device over its console serial
+  * port, using the "get" command's CRC checked frames (see GPSCheckSumArduino/HabXfer.h).
+  *
+  * Each frame that continues the file is acknowledged. A frame with an incorrect CRC is
+  * dropped and, at the next gap or after a pause, the device is asked to resend from
+  * the first missing byte. A transfer that is interrupted leaves the part received so
+  * far, which -r continues from. At the end the CRC-32 of the whole output file is
+  * checked against the CRC the device calculated from the card.
+  *
+  * --serve acts as the device, for testing without the hardware: it opens a pty,
+  * prints its name and answers "get" commands with the files in a directory, using
+  * the same sender (HabXferSender) as the sketch. Frames can be corrupted or dropped,
+  * and the link cut part way through a file.
+  *
+  * By: G. McCall
+  *     Oct-2026
+  *
+  * Usage:
+  *   habget [-r] [--verify copy] [--timeout ms] port file [output]
+  *   habget --serve dir [--loss p] [--cut bytes] [--seed n]
+  *
+  *   port          The device's serial port (e.g. /dev/ttyACM0) or a pty.
+  *   file          Name of the file on the card (relative to the device's root).
+  *   output        Where to write it (default the file name without its directory).
+  *   -r            Resume: continue from the end of an existing output file.
+  *   --verify copy Also compare the result with a copy of the card file.
+  *   --timeout ms  Time without progress before asking for a resend (default 500).
+  *                 The device has longer to start: with -r it first calculates the
+  *                 CRC of the part already received (see START_TIMEOUT_MS).
+  *
+  *   --loss p      (serve) Probability that a frame is dropped or corrupted.
+  *   --cut bytes   (serve) Stop sending the first file after about this many bytes.
+  *
+  *   Exit status: 0 transferred and verified, 1 usage or I/O error, 2 the device
+  *   reported an error, 3 the transfer stopped (resume with -r), 4 verification failed.
+  *
+  * Example (test with a pty):
+  *   habget --serve sd > pty.txt &
+  *   habget --verify sd/hab0001.log $(cat pty.txt) hab0001.log out.log
+  *
+  * Build:
+  *   g++ -O2 -o habget habget.cpp
+  *
+  * History:
+  *
+  *  v1.01.00.00 - 17-Oct-2026
+  *    Timeouts before the Start frame are not counted as retries. The device has
+  *    START_TIMEOUT_MS, plus time for the CRC of the part already received, to start,
+  *    so that -r no longer gives up on a large log while the device calculates it.
+  *
+  *  v1.00.00.00 - 17-Oct-2026
+  *    Initial version.
+  */
+
+#define VERSION "1.01.00.00"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "../GPSCheckSumArduino/HabXfer.h"
+
+using namespace std;
+
+// Largest frame accepted from the device.
+#define MAX_FRAME_SIZE (64 * 1024 + HAB_XFER_OVERHEAD)
+// Largest frame built by --serve, the size of the sketch's line scanning buffer on a Teensy.
+#define SERVE_FRAME_SIZE (8 * 512)
+#define SERVE_WINDOW (8 * SERVE_FRAME_SIZE)
+// How long (ms) the device has to send the Start frame. When resuming, the device
+// first calculates the CRC of the part already received, so it has a further second
+// for every START_CRC_RATE bytes of that (a Mega reads and CRCs about 180 KB/s).
+#define START_TIMEOUT_MS 5000
+#define START_CRC_RATE (64UL * 1024)
+// How long (ms) to keep answering a repeated End frame once the transfer is over.
+#define FINISH_LINGER_MS 200
+
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+  stopRequested = 1;
+}
+
+
+static uint32_t nowMs() {
+  return (uint32_t) chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/*
+ * Put a serial port or pty into raw mode: binary, no echo, no line editing.
+ */
+static bool setRaw(int fd) {
+  struct termios tio;
+  if (tcgetattr(fd, &tio) != 0) {
+    return false;
+  }
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, B115200);     // Ignored by USB serial, which runs at the USB rate.
+  cfsetospeed(&tio, B115200);
+  tio.c_cc[VMIN] = 1;
+  tio.c_cc[VTIME] = 0;
+  return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+
+static bool writeAll(int fd, const uint8_t * data, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        struct pollfd pfd = { fd, POLLOUT, 0 };
+        poll(&pfd, 1, 100);
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+
+static bool sendControl(int fd, HabXferType type, uint32_t offset) {
+  uint8_t frame[HAB_XFER_CTRL_SIZE];
+  return writeAll(fd, frame, habXferFinishFrame(frame, type, 0, offset));
+}
+
+
+/*
+ * Return the CRC-32 and size of a file, or false if it cannot be read.
+ */
+static bool fileCrc(const char * name, uint32_t & crc, uint32_t & size) {
+  FILE * f = fopen(name, "rb");
+  if (!f) {
+    return false;
+  }
+  vector<uint8_t> buf(64 * 1024);
+  size_t n;
+  crc = 0;
+  size = 0;
+  while ((n = fread(buf.data(), 1, buf.size(), f)) > 0) {
+    crc = habCrc32(buf.data(), n, crc);
+    size += n;
+  }
+  fclose(f);
+  return true;
+}
+
+
+/*
+ * Compare two files. Return true if they are the same.
+ */
+static bool compareFiles(const char * a, const char * b) {
+  FILE * fa = fopen(a, "rb");
+  FILE * fb = fopen(b, "rb");
+  bool same = fa && fb;
+  vector<uint8_t> bufA(64 * 1024), bufB(64 * 1024);
+  uint64_t offset = 0;
+  while (same) {
+    size_t na = fread(bufA.data(), 1, bufA.size(), fa);
+    size_t nb = fread(bufB.data(), 1, bufB.size(), fb);
+    if (na != nb || memcmp(bufA.data(), bufB.data(), na) != 0) {
+      size_t i = 0;
+      while (i < na && i < nb && bufA[i] == bufB[i]) {
+        i++;
+      }
+      cerr << "*** " << a << " differs from " << b << " at offset " << offset + i << endl;
+      same = false;
+    } else if (na == 0) {
+      break;
+    }
+    offset += na;
+  }
+  if (!fa || !fb) {
+    cerr << "*** Unable to read " << (fa ? b : a) << endl;
+  }
+  if (fa) {
+    fclose(fa);
+  }
+  if (fb) {
+    fclose(fb);
+  }
+  return same;
+}
+
+
+/*
+ * Receive a file from the device.
+ */
+static int receive(const char * port, const char * cardName, const char * outName, bool resume,
+                   const char * verifyName, uint32_t timeoutMs) {
+  int fd = open(port, O_RDWR | O_NOCTTY);
+  if (fd < 0 || !setRaw(fd)) {
+    cerr << "*** Unable to open " << port << ": " << strerror(errno) << endl;
+    return 1;
+  }
+  tcflush(fd, TCIFLUSH);
+
+  uint32_t expected = 0;
+  uint32_t crc = 0;
+  if (resume && !fileCrc(outName, crc, expected)) {
+    expected = 0;
+    crc = 0;
+  }
+  FILE * out = fopen(outName, expected > 0 ? "ab" : "wb");
+  if (!out) {
+    cerr << "*** Unable to create " << outName << ": " << strerror(errno) << endl;
+    close(fd);
+    return 1;
+  }
+
+  // A CR first, to end anything already typed at the console.
+  string cmd = "\rget " + string(cardName) + " " + to_string(expected) + "\r";
+  writeAll(fd, (const uint8_t *) cmd.data(), cmd.size());
+
+  vector<uint8_t> frameBuf(MAX_FRAME_SIZE);
+  HabXferParser parser(frameBuf.data(), frameBuf.size());
+  vector<uint8_t> readBuf(64 * 1024);
+  uint32_t firstOffset = expected;
+  uint32_t startTimeoutMs = START_TIMEOUT_MS + (uint32_t) ((uint64_t) expected * 1000 / START_CRC_RATE);
+  uint32_t fileSize = 0;
+  uint32_t lastProgress = nowMs();
+  uint32_t startMs = lastProgress;
+  uint32_t finishMs = 0;
+  unsigned int retries = 0;
+  unsigned long nakCnt = 0;
+  bool started = false;
+  bool nakSent = false;
+  bool finished = false;
+  int rc = 3;
+
+  while (!stopRequested) {
+    uint32_t now = nowMs();
+    if (finished && now - finishMs >= FINISH_LINGER_MS) {
+      break;
+    }
+    if (!started) {
+      if (now - startMs >= startTimeoutMs) {
+        cerr << "*** No response from the device" << endl;
+        break;
+      }
+    } else if (!finished && now - lastProgress >= timeoutMs) {
+      if (++retries > HAB_XFER_MAX_RETRIES) {
+        cerr << "*** No response from the device" << endl;
+        break;
+      }
+      sendControl(fd, HabXferNak, expected);
+      nakCnt++;
+      lastProgress = now;
+    }
+
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if (poll(&pfd, 1, 50) <= 0) {
+      continue;
+    }
+    ssize_t n = read(fd, readBuf.data(), readBuf.size());
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      cerr << "*** Read failed: " << (n < 0 ? strerror(errno) : "end of file") << endl;
+      break;
+    }
+
+    for (ssize_t i = 0; i < n; i++) {
+      if (!parser.put(readBuf[i])) {
+        continue;
+      }
+      uint32_t offset = parser.getOffset();
+      uint16_t len = parser.getLength();
+      switch (parser.getType()) {
+        case HabXferStart:
+          if (len != 4 || offset != expected) {
+            cerr << "*** The device started at offset " << offset << ", not " << expected << endl;
+            sendControl(fd, HabXferCancel, 0);
+            stopRequested = 1;
+            rc = 2;
+            break;
+          }
+          fileSize = habXferGet32(parser.getPayload());
+          started = true;
+          sendControl(fd, HabXferAck, expected);
+          lastProgress = nowMs();
+          retries = 0;
+          break;
+
+        case HabXferData:
+          if (!started) {
+            break;
+          }
+          if (offset == expected) {
+            if (fwrite(parser.getPayload(), 1, len, out) != len) {
+              cerr << "*** Write failed: " << strerror(errno) << endl;
+              sendControl(fd, HabXferCancel, 0);
+              stopRequested = 1;
+              rc = 1;
+              break;
+            }
+            crc = habCrc32(parser.getPayload(), len, crc);
+            expected += len;
+            sendControl(fd, HabXferAck, expected);
+            lastProgress = nowMs();
+            retries = 0;
+            nakSent = false;
+          } else if (offset > expected && !nakSent) {
+            // A frame was lost, the ones after it are ignored until it is resent.
+            sendControl(fd, HabXferNak, expected);
+            nakCnt++;
+            nakSent = true;
+          }
+          break;
+
+        case HabXferEnd:
+          if (started && offset == expected && len == 4) {
+            sendControl(fd, HabXferFinish, offset);
+            if (!finished) {
+              finished = true;
+              finishMs = nowMs();
+              rc = habXferGet32(parser.getPayload()) == crc ? 0 : 4;
+              if (rc != 0) {
+                cerr << "*** CRC-32 of " << outName << " does not match the card" << endl;
+              }
+            }
+          }
+          break;
+
+        case HabXferError:
+          cerr << "*** Device: " << string((const char *) parser.getPayload(), len) << endl;
+          stopRequested = 1;
+          rc = 2;
+          break;
+
+        default:
+          break;
+      }
+      if (stopRequested) {
+        break;
+      }
+    }
+  }
+  if (!finished && started && rc == 3) {
+    sendControl(fd, HabXferCancel, 0);
+  }
+  fclose(out);
+  close(fd);
+
+  double secs = (nowMs() - startMs) / 1000.0;
+  uint32_t received = expected - firstOffset;
+  fprintf(stderr, "%s: %u bytes", outName, expected);
+  if (fileSize > 0) {
+    fprintf(stderr, " of %u", fileSize);
+  }
+  fprintf(stderr, ", received %u in %.2f s (%.1f KB/s), CRC errors: %lu, resend requests: %lu\n",
+          received, secs, secs > 0 ? received / 1024.0 / secs : 0.0, parser.getErrorCnt(), nakCnt);
+  if (rc == 3) {
+    cerr << "Transfer stopped at offset " << expected << ", continue it with -r" << endl;
+  } else if (rc == 0) {
+    fprintf(stderr, "CRC-32 0x%08X matches the card\n", crc);
+    if (verifyName && !compareFiles(outName, verifyName)) {
+      rc = 4;
+    } else if (verifyName) {
+      cerr << "Identical to " << verifyName << endl;
+    }
+  }
+  return rc;
+}
+
+
+/*
+ * The serial port of the device, as seen by the sender: the pty, with frames
+ * dropped or corrupted at random, and the link cut after a number of bytes.
+ */
+class ServePort {
+  public:
+    ServePort(int fd, double loss, long cutBytes, unsigned long seed)
+      : fd(fd), loss(loss), cutBytes(cutBytes), rng(seed) {
+    }
+
+    int available() {
+      if (pos == len) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 0) == 1) {
+          ssize_t n = ::read(fd, buf, sizeof(buf));
+          len = n > 0 ? n : 0;
+          pos = 0;
+        }
+      }
+      return len - pos;
+    }
+
+    int read() {
+      return available() > 0 ? buf[pos++] : -1;
+    }
+
+    size_t write(const uint8_t * data, size_t n) {
+      if (isCut()) {
+        return n;
+      }
+      sentCnt += n;
+      double r = uniform_real_distribution<double>(0.0, 1.0)(rng);
+      if (r < loss / 2) {
+        return n;                                   // Dropped.
+      }
+      if (r < loss && n > 0) {
+        vector<uint8_t> bad(data, data + n);        // Corrupted.
+        bad[rng() % n] ^= 1 << (rng() % 8);
+        writeAll(fd, bad.data(), n);
+        return n;
+      }
+      writeAll(fd, data, n);
+      return n;
+    }
+
+    size_t write(const char * text) {
+      return write((const uint8_t *) text, strlen(text));
+    }
+
+    bool isCut() const {
+      return cutBytes >= 0 && sentCnt >= (unsigned long) cutBytes;
+    }
+
+    void uncut() {
+      cutBytes = -1;
+    }
+
+  private:
+    int fd;
+    double loss;
+    long cutBytes;
+    mt19937 rng;
+    unsigned long sentCnt = 0;
+    uint8_t buf[4096];
+    size_t pos = 0;
+    size_t len = 0;
+};
+
+
+/*
+ * A file on the "card", as seen by the sender.
+ */
+class ServeFile {
+  public:
+    bool open(const string & name) {
+      f = fopen(name.c_str(), "rb");
+      return f != NULL;
+    }
+    uint32_t fileSize() {
+      struct stat st;
+      return fstat(fileno(f), &st) == 0 ? (uint32_t) st.st_size : 0;
+    }
+    int read(void * buf, size_t n) {
+      return (int) fread(buf, 1, n, f);
+    }
+    bool seekSet(uint32_t offset) {
+      return fseek(f, offset, SEEK_SET) == 0;
+    }
+    void close() {
+      if (f) {
+        fclose(f);
+        f = NULL;
+      }
+    }
+
+  private:
+    FILE * f = NULL;
+};
+
+
+/*
+ * Answer one "get file [offset]" command as the sketch does.
+ */
+static void serveGet(ServePort & port, const string & dir, const vector<string> & args) {
+  vector<uint8_t> frame(SERVE_FRAME_SIZE);
+  ServeFile file;
+  HabXferSender<ServePort, ServeFile> sender(port, file, frame.data(), frame.size(), SERVE_WINDOW);
+  if (args.size() < 2 || args.size() > 3) {
+    port.write("Error, specify a file and an optional offset.\r\n");
+    return;
+  }
+  if (!file.open(dir + "/" + args[1])) {
+    sender.fail("Failed to open");
+    port.write("\r\nFailed to open\r\n");
+    return;
+  }
+  uint32_t offset = args.size() == 3 ? strtoul(args[2].c_str(), NULL, 10) : 0;
+  sender.start(offset, file.fileSize(), nowMs());
+  while (!stopRequested && sender.poll(nowMs())) {
+    if (port.isCut()) {
+      cerr << "serve: link cut" << endl;
+      port.uncut();
+      break;
+    }
+  }
+  file.close();
+  char summary[80];
+  snprintf(summary, sizeof(summary), "\r\nResult: %d CRC-32: 0x%X resent: %u\r\n",
+           (int) sender.getResult(), sender.getFileCrc(), sender.getResentCnt());
+  port.write(summary);
+  cerr << "serve: " << args[1] << " " << summary + 2;
+}
+
+
+/*
+ * Act as the device on a new pty until interrupted.
+ */
+static int serve(const char * dir, double loss, long cutBytes, unsigned long seed) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    cerr << "*** Unable to open a pty: " << strerror(errno) << endl;
+    return 1;
+  }
+  const char * slaveName = ptsname(master);
+  // Hold the slave open, so that the pty stays up between receivers.
+  int slave = open(slaveName, O_RDWR | O_NOCTTY);
+  if (slave < 0 || !setRaw(slave)) {
+    cerr << "*** Unable to set up " << slaveName << endl;
+    return 1;
+  }
+  printf("%s\n", slaveName);
+  fflush(stdout);
+
+  ServePort port(master, loss, cutBytes, seed);
+  string line;
+  while (!stopRequested) {
+    if (port.available() == 0) {
+      struct pollfd pfd = { master, POLLIN, 0 };
+      poll(&pfd, 1, 100);
+      continue;
+    }
+    char ch = port.read();
+    uint8_t echo = ch;
+    port.write(&echo, 1);
+    if (ch != '\r' && ch != '\n') {
+      line += ch;
+      continue;
+    }
+    port.write("\r\n");
+    vector<string> args;
+    size_t p = 0;
+    while ((p = line.find_first_not_of(' ', p)) != string::npos) {
+      size_t e = line.find(' ', p);
+      args.push_back(line.substr(p, e == string::npos ? string::npos : e - p));
+      p = e;
+    }
+    line.clear();
+    if (args.empty()) {
+      continue;
+    }
+    if (args[0] == "get") {
+      serveGet(port, dir, args);
+    } else {
+      port.write("Invalid command\r\n");
+    }
+    port.write("--> ");
+  }
+  close(slave);
+  close(master);
+  return 0;
+}
+
+
+static void usage() {
+  cerr << "habget v" << VERSION << endl;
+  cerr << "Usage: habget [-r] [--verify copy] [--timeout ms] port file [output]" << endl;
+  cerr << "       habget --serve dir [--loss p] [--cut bytes] [--seed n]" << endl;
+}
+
+
+/* main
+ * ----
+ */
+int main(int argc, const char * argv[]) {
+  bool resume = false;
+  const char * verifyName = NULL;
+  const char * serveDir = NULL;
+  uint32_t timeoutMs = 500;
+  double loss = 0.0;
+  long cutBytes = -1;
+  unsigned long seed = 1;
+  vector<const char *> args;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-r") == 0) {
+      resume = true;
+    } else if (strcmp(argv[i], "--verify") == 0 && i + 1 < argc) {
+      verifyName = argv[++i];
+    } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+      timeoutMs = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+      serveDir = argv[++i];
+    } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+      loss = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--cut") == 0 && i + 1 < argc) {
+      cutBytes = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 10);
+    } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+      usage();
+      return 1;
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  if (serveDir) {
+    return serve(serveDir, loss, cutBytes, seed);
+  }
+  if (args.size() < 2 || args.size() > 3) {
+    usage();
+    return 1;
+  }
+  string outName = args.size() == 3 ? args[2] : args[1];
+  if (args.size() == 2 && outName.rfind('/') != string::npos) {
+    outName = outName.substr(outName.rfind('/') + 1);
+  }
+  return receive(args[0], args[1], outName.c_str(), resume, verifyName, timeoutMs);
+}
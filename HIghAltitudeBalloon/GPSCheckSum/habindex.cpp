@@ -0,0 +1,320 @@
+/**
+  * habindex.cpp
+  * ------------
+  *
+  * Build and use the sidecar index of a hab log (see GPSCheckSumArduino/HabIndex.h).
+  *
+  * The index records where each record type starts in each time bucket, so that a
+  * time range or record type can be extracted without reading the rest of the log.
+  * Extracted records are copied byte for byte, so binary $HAB records can be passed
+  * on to habdecode.
+  *
+  * By: G. McCall
+  *     Oct-2026
+  *
+  * Usage:
+  *   habindex [-b secs] file.log ...                  Build file.idx for each log.
+  *   habindex -l file.log                             List the index.
+  *   habindex -q file.log type|* [from [to]] > out    Extract records of a type (* = all)
+  *                                                    between two UTC times (h:mm[:ss]).
+  *
+  *   The index is (re)built by -l and -q if it is missing or out of date.
+  *   A flight that crosses midnight UTC continues at 24:00:00.
+  *
+  * Build:
+  *   g++ -O2 -o habindex habindex.cpp
+  *
+  * History:
+  *
+  *  v1.00.00.00 - 17-Oct-2026
+  *    Initial version.
+  */
+
+#define VERSION "1.00.00.00"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+
+#include "../GPSCheckSumArduino/HabIndex.h"
+
+using namespace std;
+
+#define READ_BLOCK_SIZE (64 * 1024)
+
+
+/*
+ * Index of a log, loaded into memory.
+ */
+struct Index {
+  HabIndexHeader header;
+  vector<HabIndexEntry> entries;
+};
+
+
+/*
+ * Return the size of a file, or -1 if it cannot be opened.
+ */
+long fileSize(const char * file) {
+  FILE * f = fopen(file, "rb");
+  if (!f) {
+    return -1;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fclose(f);
+  return size;
+}
+
+
+/*
+ * Scan the log and write its index.
+ */
+bool buildIndex(const char * logFile, uint16_t bucketSecs, Index & index) {
+  FILE * log = fopen(logFile, "rb");
+  if (!log) {
+    cerr << "Error opening " << logFile << endl;
+    return false;
+  }
+
+  HabLogScanner scanner;
+  HabIndexBuilder builder(bucketSecs);
+  HabIndexEntry entry;
+  index.entries.clear();
+
+  static uint8_t block[READ_BLOCK_SIZE];
+  size_t n;
+  while ((n = fread(block, 1, sizeof(block), log)) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      if (scanner.put(block[i]) && builder.add(scanner.getRecord(), entry)) {
+        index.entries.push_back(entry);
+      }
+    }
+  }
+  if (scanner.finish() && builder.add(scanner.getRecord(), entry)) {
+    index.entries.push_back(entry);
+  }
+  fclose(log);
+  index.header = builder.getHeader();
+
+  char idxFile[PATH_MAX];
+  habIndexFileName(logFile, idxFile, sizeof(idxFile));
+  FILE * idx = fopen(idxFile, "wb");
+  if (!idx) {
+    cerr << "Error creating " << idxFile << endl;
+    return false;
+  }
+  fwrite(&index.header, sizeof(index.header), 1, idx);
+  fwrite(index.entries.data(), sizeof(HabIndexEntry), index.entries.size(), idx);
+  bool ok = fclose(idx) == 0;
+  cerr << logFile << ": " << index.header.logSize << " bytes, " << index.entries.size()
+       << " index entries written to " << idxFile << endl;
+  return ok;
+}
+
+
+/*
+ * Load the index of a log, building it if it is missing or out of date.
+ */
+bool loadIndex(const char * logFile, Index & index) {
+  long size = fileSize(logFile);
+  if (size < 0) {
+    cerr << "Error opening " << logFile << endl;
+    return false;
+  }
+
+  char idxFile[PATH_MAX];
+  habIndexFileName(logFile, idxFile, sizeof(idxFile));
+  FILE * idx = fopen(idxFile, "rb");
+  if (idx) {
+    bool ok = fread(&index.header, sizeof(index.header), 1, idx) == 1
+              && habIndexIsCurrent(index.header, size);
+    if (ok) {
+      index.entries.resize(index.header.entryCnt);
+      ok = fread(index.entries.data(), sizeof(HabIndexEntry), index.entries.size(), idx) == index.entries.size();
+    }
+    fclose(idx);
+    if (ok) {
+      return true;
+    }
+  }
+  return buildIndex(logFile, HAB_IDX_DEFAULT_BUCKET, index);
+}
+
+
+/*
+ * Format a time as h:mm:ss.
+ */
+string formatTime(int32_t t) {
+  if (t == HAB_IDX_NO_TIME) {
+    return "-";
+  }
+  char buf[20];
+  snprintf(buf, sizeof(buf), "%d:%02d:%02d", t / 3600, t / 60 % 60, t % 60);
+  return buf;
+}
+
+
+/*
+ * Parse a time given as h:mm[:ss]. Return HAB_IDX_NO_TIME if it is invalid.
+ */
+int32_t parseUserTime(const char * text) {
+  int h, m, s = 0;
+  if (sscanf(text, "%d:%d:%d", &h, &m, &s) < 2 || h < 0 || m < 0 || m > 59 || s < 0 || s > 59) {
+    return HAB_IDX_NO_TIME;
+  }
+  return h * 3600 + m * 60 + s;
+}
+
+
+/*
+ * List the record types and time span covered by the index.
+ */
+int listIndex(const char * logFile) {
+  Index index;
+  if (!loadIndex(logFile, index)) {
+    return 1;
+  }
+  printf("%s: %u bytes, bucket %u secs, %u entries\n", logFile, index.header.logSize,
+         index.header.bucketSecs, index.header.entryCnt);
+  for (int type = 0; type < index.header.typeCnt; type++) {
+    unsigned long bucketCnt = 0;
+    int32_t first = HAB_IDX_NO_TIME;
+    int32_t last = HAB_IDX_NO_TIME;
+    uint32_t firstLine = 0;
+    for (const HabIndexEntry & entry : index.entries) {
+      if (entry.type != type) {
+        continue;
+      }
+      if (bucketCnt++ == 0) {
+        firstLine = entry.lineNo;
+      }
+      if (entry.bucket != HAB_IDX_NO_TIME) {
+        if (first == HAB_IDX_NO_TIME) {
+          first = entry.bucket;
+        }
+        last = entry.bucket;
+      }
+    }
+    printf("  %-8s %6lu buckets  first line %-8u %s - %s\n", index.header.typeNames[type], bucketCnt, firstLine,
+           formatTime(first).c_str(), formatTime(last == HAB_IDX_NO_TIME ? last : last + index.header.bucketSecs - 1).c_str());
+  }
+  return 0;
+}
+
+
+/*
+ * Copy the records of a type (or all types) within a time range to stdout.
+ */
+int query(const char * logFile, const char * typeName, int32_t from, int32_t to) {
+  Index index;
+  if (!loadIndex(logFile, index)) {
+    return 1;
+  }
+
+  int type = -1;
+  if (typeName) {
+    for (int i = 0; i < index.header.typeCnt; i++) {
+      if (strncmp(index.header.typeNames[i], typeName, HAB_IDX_TYPE_LEN) == 0) {
+        type = i;
+      }
+    }
+    if (type < 0) {
+      cerr << "No " << typeName << " records in " << logFile << endl;
+      return 1;
+    }
+  }
+
+  HabIndexRange range(index.header, type, from, to);
+  for (const HabIndexEntry & entry : index.entries) {
+    range.add(entry);
+  }
+  if (!range.found) {
+    cerr << "No records in that range." << endl;
+    return 1;
+  }
+
+  FILE * log = fopen(logFile, "rb");
+  if (!log || fseek(log, range.startOffset, SEEK_SET) != 0) {
+    cerr << "Error reading " << logFile << endl;
+    return 1;
+  }
+
+  // Records are collected as they are scanned and written out if they match.
+  HabLogScanner scanner;
+  scanner.reset(range.startOffset, range.startLineNo, range.startTime);
+  string record;
+  unsigned long recCnt = 0;
+  uint32_t offset = range.startOffset;
+  static uint8_t block[READ_BLOCK_SIZE];
+  size_t n;
+  bool done = false;
+  while (!done && (n = fread(block, 1, sizeof(block), log)) > 0) {
+    for (size_t i = 0; i < n && !done; i++, offset++) {
+      if (range.ended && offset >= range.endOffset) {
+        done = true;
+        break;
+      }
+      record += (char) block[i];
+      if (scanner.put(block[i])) {
+        if (range.matches(scanner.getRecord(), typeName)) {
+          fwrite(record.data(), 1, record.size(), stdout);
+          recCnt++;
+        }
+        record.clear();
+      }
+    }
+  }
+  if (!done && scanner.finish() && range.matches(scanner.getRecord(), typeName)) {
+    fwrite(record.data(), 1, record.size(), stdout);
+    recCnt++;
+  }
+  fclose(log);
+
+  cerr << recCnt << " records from line " << range.startLineNo << " (offset " << range.startOffset << ")" << endl;
+  return 0;
+}
+
+
+/* main
+ * ----
+ * Build the index of each log, or list or query one log.
+ */
+int main(int argc, const char * argv[]) {
+  if (argc >= 3 && strcmp(argv[1], "-l") == 0) {
+    return listIndex(argv[2]);
+  }
+
+  if (argc >= 4 && strcmp(argv[1], "-q") == 0) {
+    const char * typeName = strcmp(argv[3], "*") == 0 ? NULL : argv[3];
+    int32_t from = HAB_IDX_NO_TIME;
+    int32_t to = INT32_MAX;
+    if (argc >= 5 && (from = parseUserTime(argv[4])) == HAB_IDX_NO_TIME) {
+      cerr << "Invalid time: " << argv[4] << endl;
+      return 1;
+    }
+    if (argc >= 6 && (to = parseUserTime(argv[5])) == HAB_IDX_NO_TIME) {
+      cerr << "Invalid time: " << argv[5] << endl;
+      return 1;
+    }
+    return query(argv[2], typeName, from, to);
+  }
+
+  uint16_t bucketSecs = HAB_IDX_DEFAULT_BUCKET;
+  int rc = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      bucketSecs = atoi(argv[++i]);
+    } else {
+      Index index;
+      if (!buildIndex(argv[i], bucketSecs, index)) {
+        rc = 1;
+      }
+    }
+  }
+  return rc;
+}
@@ -0,0 +1,744 @@
+/**
+  * habpack.cpp
+  * -----------
+  *
+  * Convert a hab log into a columnar pack (see habpack.h), and read packs.
+  *
+  * Post flight analysis no longer needs to parse the text of the log each time. Each
+  * field of the $HAB records and of the GGA and RMC sentences becomes a column of
+  * scaled integers. A pack is memory mapped when it is read, so a column covering a
+  * whole flight is available in milliseconds.
+  *
+  * Tables and columns:
+  *   HAB - the columns named by the $HAB header line in the log, starting with UTCTime.
+  *         Text and binary $HAB records are both packed.
+  *   GGA - time, talker, lat, lon, quality, satCnt, hdop, alt, geoidSep.
+  *   RMC - time, talker, status, lat, lon, speed, course, date.
+  *   UTCTime and time are the seconds since midnight UTC on the day the log started (they
+  *   continue past 24:00:00), lat and lon are in degrees and talker is an NmeaTalker value.
+  *   NMEA sentences with an incorrect checksum are not packed.
+  *
+  * By: G. McCall
+  *     Oct-2026
+  *
+  * Usage:
+  *   habpack file.log ...                       Write file.hpk for each log.
+  *   habpack -i file.hpk                        List the columns.
+  *   habpack -s file.hpk                        Min, max and mean of every column.
+  *   habpack -c file.hpk table col [col ...]    Output the columns as CSV, e.g. for plotting.
+  *
+  * Build:
+  *   g++ -O2 -o habpack habpack.cpp
+  *
+  * History:
+  *
+  *  v1.02.00.00 - 17-Oct-2026
+  *    The HAB time column is named by the header line (UTCTime), as the other HAB
+  *    columns are, rather than time.
+  *
+  *  v1.01.00.00 - 17-Oct-2026
+  *    $HAB record version 4: latency timer columns replace the oledUpd, tempUpd,
+  *    sumLogTimeMs and logHist columns.
+  *
+  *  v1.00.00.00 - 17-Oct-2026
+  *    Initial version.
+  */
+
+#define VERSION "1.02.00.00"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+
+#include "../GPSCheckSumArduino/HabIndex.h"
+#define NMEA_MAX_LENGTH 4096
+#include "../habFlightMonitor/Nmea.h"
+#include "habpack.h"
+
+using namespace std;
+
+// Most decimal places that are kept for a column.
+#define MAX_SCALE 9
+
+// Column names of the $HAB record if the log has no header line. These are also the
+// fields of a binary record, in order, followed by the columns of each timer.
+static const char * defaultHabNames[] = {
+  "lat", "lon", "alt", "hdop", "satCnt", "T1", "T2", "battV",
+  "gpsOvfCnt", "gpsHighWater", "chkErrGP", "chkErrGN", "chkErrOther", "logCnt"
+};
+
+// The latency timers in the $HAB record (see HAB_LOG_HEADER) and their columns.
+static const char * habTimerNames[HAB_REC_TIMER_CNT] = { "loop", "gps", "temp", "oled", "sd" };
+static const char * habTimerColumns[] = { "Cnt", "P50", "P90", "P99", "Max" };
+
+
+/*
+ * A value of a field. The value is mant / 10^scale.
+ */
+struct Scaled {
+  int64_t mant;
+  int scale;
+  bool valid;
+};
+
+static const Scaled NO_VALUE = { 0, 0, false };
+
+inline Scaled scaled(int64_t mant, int scale = 0) {
+  Scaled s = { mant, scale, true };
+  return s;
+}
+
+
+/*
+ * Parse a decimal number, keeping its decimal places. An empty field is not valid.
+ */
+Scaled parseScaled(const char * p, size_t len) {
+  const char * end = p + len;
+  while (p < end && *p == ' ') {
+    p++;
+  }
+  bool neg = p < end && *p == '-';
+  if (p < end && (*p == '-' || *p == '+')) {
+    p++;
+  }
+  Scaled s = { 0, 0, false };
+  bool dot = false;
+  for (; p < end; p++) {
+    if (*p >= '0' && *p <= '9') {
+      if (!dot || s.scale < MAX_SCALE) {
+        s.mant = s.mant * 10 + (*p - '0');
+        s.scale += dot;
+      }
+      s.valid = true;
+    } else if (*p == '.' && !dot) {
+      dot = true;
+    } else {
+      return NO_VALUE;
+    }
+  }
+  if (neg) {
+    s.mant = -s.mant;
+  }
+  return s;
+}
+
+
+/*
+ * Convert an NMEA position (d)ddmm.mmmm and its hemisphere to degrees * 10^7.
+ */
+Scaled parseNmeaPosition(const NmeaField & value, const NmeaField & hemisphere) {
+  Scaled s = parseScaled(value.ptr, value.len);
+  if (!s.valid || hemisphere.len != 1) {
+    return NO_VALUE;
+  }
+  int64_t unit = 1;
+  for (int i = 0; i < s.scale; i++) {
+    unit *= 10;
+  }
+  int64_t degrees = s.mant / (100 * unit);
+  int64_t minutes = s.mant - degrees * 100 * unit;       // Minutes * unit.
+  int64_t result = degrees * 10000000 + (minutes * 10000000 + 30 * unit) / (60 * unit);
+  if (*hemisphere.ptr == 'S' || *hemisphere.ptr == 'W') {
+    result = -result;
+  }
+  return scaled(result, 7);
+}
+
+
+/*
+ * A column while it is being built.
+ */
+struct ColumnBuilder {
+  string name;
+  vector<int64_t> mant;
+  vector<int8_t> scale;
+  vector<bool> valid;
+};
+
+
+/*
+ * A table while it is being built. Each row is started, its fields set by name
+ * and then ended. A field that is not set in a row is empty.
+ */
+class TableBuilder {
+  public:
+    TableBuilder(const char * name) : name(name) {}
+
+    void startRow() {
+      rowCnt++;
+    }
+
+    void set(const string & column, const Scaled & value) {
+      ColumnBuilder & col = columns[columnId(column)];
+      while (col.mant.size() < rowCnt - 1) {
+        col.mant.push_back(0);
+        col.scale.push_back(0);
+        col.valid.push_back(false);
+      }
+      if (col.mant.size() == rowCnt) {
+        return;               // The field was already set in this row.
+      }
+      col.mant.push_back(value.mant);
+      col.scale.push_back(value.scale);
+      col.valid.push_back(value.valid);
+    }
+
+    // Fill in the fields that were not set, so that every column has rowCnt rows.
+    void finish() {
+      for (ColumnBuilder & col : columns) {
+        while (col.mant.size() < rowCnt) {
+          col.mant.push_back(0);
+          col.scale.push_back(0);
+          col.valid.push_back(false);
+        }
+      }
+    }
+
+    const string name;
+    uint32_t rowCnt = 0;
+    vector<ColumnBuilder> columns;
+
+  private:
+    size_t columnId(const string & column) {
+      for (size_t i = 0; i < columns.size(); i++) {
+        if (columns[i].name == column) {
+          return i;
+        }
+      }
+      columns.push_back(ColumnBuilder());
+      columns.back().name = column;
+      return columns.size() - 1;
+    }
+};
+
+
+/*
+ * Return the width in bytes needed to hold the values.
+ */
+template <typename T> int widthFor(T minValue, T maxValue) {
+  if (minValue >= (T) INT8_MIN && maxValue <= (T) INT8_MAX) {
+    return 1;
+  }
+  if (minValue >= (T) INT16_MIN && maxValue <= (T) INT16_MAX) {
+    return 2;
+  }
+  if (minValue >= (T) INT32_MIN && maxValue <= (T) INT32_MAX) {
+    return 4;
+  }
+  return 8;
+}
+
+
+/*
+ * Encode a column, choosing the smaller of the raw and delta encodings.
+ * data is set to the encoded rows and validMap to the bitmap, which is empty if
+ * every row holds a value.
+ */
+void encodeColumn(const ColumnBuilder & col, HabPackColumn & desc, string & data, string & validMap) {
+  int scale = 0;
+  for (size_t i = 0; i < col.mant.size(); i++) {
+    if (col.valid[i] && col.scale[i] > scale) {
+      scale = col.scale[i];
+    }
+  }
+
+  // Bring each value to the same scale. An empty row repeats the last value, so that its
+  // delta is 0.
+  vector<int64_t> values(col.mant.size());
+  int64_t last = 0;
+  bool allValid = true;
+  for (size_t i = 0; i < col.mant.size(); i++) {
+    if (col.valid[i]) {
+      last = col.mant[i];
+      for (int s = col.scale[i]; s < scale; s++) {
+        last *= 10;
+      }
+    } else {
+      allValid = false;
+    }
+    values[i] = last;
+  }
+
+  int64_t minValue = 0, maxValue = 0;
+  int64_t base = values.empty() ? 0 : values[0];
+  uint64_t maxDelta = 0;
+  for (size_t i = 0; i < values.size(); i++) {
+    minValue = i == 0 ? values[i] : min(minValue, values[i]);
+    maxValue = i == 0 ? values[i] : max(maxValue, values[i]);
+    maxDelta = max(maxDelta, habPackZigZag(values[i] - (i == 0 ? base : values[i - 1])));
+  }
+  int rawWidth = widthFor<int64_t>(minValue, maxValue);
+  // A zigzag value of up to 2^(8w) - 1 fits w bytes.
+  int deltaWidth = maxDelta <= 0xFF ? 1 : maxDelta <= 0xFFFF ? 2 : maxDelta <= 0xFFFFFFFFULL ? 4 : 8;
+
+  desc.scale = scale;
+  desc.rowCnt = values.size();
+  desc.base = base;
+  desc.encoding = deltaWidth < rawWidth ? HabPackDelta : HabPackRaw;
+  desc.width = desc.encoding == HabPackDelta ? deltaWidth : rawWidth;
+
+  data.resize(values.size() * desc.width);
+  for (size_t i = 0; i < values.size(); i++) {
+    uint64_t v = desc.encoding == HabPackDelta ? habPackZigZag(values[i] - (i == 0 ? base : values[i - 1]))
+                                                : (uint64_t) values[i];
+    memcpy(&data[i * desc.width], &v, desc.width);    // Little endian.
+  }
+
+  validMap.clear();
+  if (!allValid) {
+    validMap.assign((values.size() + 7) / 8, '\0');
+    for (size_t i = 0; i < values.size(); i++) {
+      if (col.valid[i]) {
+        validMap[i >> 3] |= 1 << (i & 7);
+      }
+    }
+  }
+}
+
+
+/*
+ * Split a text $HAB record into its fields.
+ */
+void splitFields(const char * p, const char * end, vector<NmeaField> & fields) {
+  fields.clear();
+  while (end > p && (end[-1] == '\r' || end[-1] == '\n')) {
+    end--;
+  }
+  const char * start = p;
+  for (; p <= end; p++) {
+    if (p == end || *p == ',') {
+      NmeaField fld = { start, (NmeaOffset) (p - start) };
+      fields.push_back(fld);
+      start = p + 1;
+    }
+  }
+}
+
+
+/*
+ * Converts the records of a log into the HAB, GGA and RMC tables.
+ */
+class PackBuilder {
+  public:
+    PackBuilder() : hab("HAB"), gga("GGA"), rmc("RMC") {
+      for (const char * name : defaultHabNames) {
+        binaryNames.push_back(name);
+      }
+      for (const char * timer : habTimerNames) {
+        for (const char * column : habTimerColumns) {
+          binaryNames.push_back(string(timer) + column);
+        }
+      }
+      habNames = binaryNames;
+    }
+
+    void add(const HabLogRecord & rec, const char * text) {
+      if (rec.binary) {
+        addBinary(rec, text);
+      } else if (strcmp(rec.type, "$HAB") == 0) {
+        addHab(rec, text);
+      } else if (rec.type[0] == '$' && strlen(rec.type) == 6) {
+        addNmea(rec, text);
+      }
+    }
+
+    // Write the tables to a pack.
+    bool write(const char * file) {
+      hab.finish();
+      gga.finish();
+      rmc.finish();
+
+      vector<HabPackColumn> descs;
+      vector<string> data;
+      vector<string> validMaps;
+      for (TableBuilder * table : { &hab, &gga, &rmc }) {
+        for (const ColumnBuilder & col : table->columns) {
+          HabPackColumn desc;
+          memset(&desc, 0, sizeof(desc));
+          strncpy(desc.table, table->name.c_str(), HAB_PACK_TABLE_LEN - 1);
+          strncpy(desc.name, col.name.c_str(), HAB_PACK_NAME_LEN - 1);
+          data.push_back(string());
+          validMaps.push_back(string());
+          encodeColumn(col, desc, data.back(), validMaps.back());
+          descs.push_back(desc);
+        }
+      }
+
+      // Lay out the data after the column descriptions.
+      uint64_t offset = sizeof(HabPackHeader) + descs.size() * sizeof(HabPackColumn);
+      for (size_t i = 0; i < descs.size(); i++) {
+        offset = align(offset);
+        descs[i].dataOffset = offset;
+        offset += data[i].size();
+        if (!validMaps[i].empty()) {
+          offset = align(offset);
+          descs[i].validOffset = offset;
+          offset += validMaps[i].size();
+        }
+      }
+
+      HabPackHeader header;
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, HAB_PACK_MAGIC, sizeof(header.magic));
+      header.version = HAB_PACK_VERSION;
+      header.columnCnt = descs.size();
+      header.fileSize = offset;
+
+      FILE * out = fopen(file, "wb");
+      if (!out) {
+        cerr << "Error creating " << file << endl;
+        return false;
+      }
+      string image((const char *) &header, sizeof(header));
+      image.append((const char *) descs.data(), descs.size() * sizeof(HabPackColumn));
+      for (size_t i = 0; i < descs.size(); i++) {
+        image.resize(descs[i].dataOffset, '\0');
+        image += data[i];
+        if (descs[i].validOffset) {
+          image.resize(descs[i].validOffset, '\0');
+          image += validMaps[i];
+        }
+      }
+      fwrite(image.data(), 1, image.size(), out);
+      return fclose(out) == 0;
+    }
+
+    TableBuilder hab;
+    TableBuilder gga;
+    TableBuilder rmc;
+    unsigned long badCnt = 0;         // Sentences or binary records that were not valid.
+
+  private:
+    static uint64_t align(uint64_t offset) {
+      return (offset + HAB_PACK_ALIGN - 1) & ~(uint64_t) (HAB_PACK_ALIGN - 1);
+    }
+
+    static Scaled timeOf(const HabLogRecord & rec) {
+      return rec.time == HAB_IDX_NO_TIME ? NO_VALUE : scaled(rec.time);
+    }
+
+    void addHab(const HabLogRecord & rec, const char * text) {
+      splitFields(text, text + rec.length, fields);
+      if (fields.size() < 2) {
+        return;
+      }
+      if (fields[1].len > 0 && (fields[1].ptr[0] < '0' || fields[1].ptr[0] > '9')) {
+        // A header line, which names the columns of the records that follow.
+        habTimeName = string(fields[1].ptr, fields[1].len);
+        habNames.clear();
+        for (size_t i = 2; i < fields.size(); i++) {
+          habNames.push_back(string(fields[i].ptr, fields[i].len));
+        }
+        return;
+      }
+      hab.startRow();
+      hab.set(habTimeName, timeOf(rec));
+      for (size_t i = 2; i < fields.size(); i++) {
+        const string & name = i - 2 < habNames.size() ? habNames[i - 2] : "field" + to_string(i);
+        hab.set(name, parseScaled(fields[i].ptr, fields[i].len));
+      }
+    }
+
+    void addBinary(const HabLogRecord & rec, const char * text) {
+      HabRecord r;
+      memset(&r, 0, sizeof(r));
+      memcpy(&r, text, min((size_t) rec.length, sizeof(r)));
+      unsigned int size = HAB_REC_HEADER_SIZE + r.length;
+      if (r.version != HAB_REC_VERSION || size != HAB_REC_SIZE || rec.length != size + HAB_REC_CRC_SIZE
+            || (uint16_t) ((text[size] & 0xFF) | (text[size + 1] & 0xFF) << 8) != habCrc16((const uint8_t *) text + 2, size - 2)) {
+        badCnt++;
+        return;
+      }
+
+      Scaled values[] = {
+        scaled(r.lat, 6), scaled(r.lon, 6), scaled(r.alt, 2), scaled(r.hdop, 4), scaled(r.satCnt),
+        scaled(r.temp1, 2), scaled(r.temp2, 2), scaled(r.battV, 2),
+        scaled(r.gpsOvfCnt), scaled(r.gpsHighWater), scaled(r.chkErrGP), scaled(r.chkErrGN), scaled(r.chkErrOther),
+        scaled(r.logCnt)
+      };
+      hab.startRow();
+      hab.set(habTimeName, timeOf(rec));
+      size_t i = 0;
+      for (const Scaled & value : values) {
+        hab.set(binaryNames[i++], value);
+      }
+      for (const HabTimerSummary & t : r.timers) {
+        Scaled timerValues[] = {
+          scaled(t.cnt), scaled(LatencyHistogram::bucketValue(t.p50, t.max)), scaled(LatencyHistogram::bucketValue(t.p90, t.max)),
+          scaled(LatencyHistogram::bucketValue(t.p99, t.max)), scaled(t.max)
+        };
+        for (const Scaled & value : timerValues) {
+          hab.set(binaryNames[i++], value);
+        }
+      }
+    }
+
+    void addNmea(const HabLogRecord & rec, const char * text) {
+      if (nmea.parse(text, rec.length) != NmeaOk) {
+        if (nmea.getType() == NmeaTypeGGA || nmea.getType() == NmeaTypeRMC) {
+          badCnt++;
+        }
+        return;
+      }
+      if (nmea.getType() == NmeaTypeGGA) {
+        gga.startRow();
+        gga.set("time", timeOf(rec));
+        gga.set("talker", scaled(nmea.getTalker()));
+        gga.set("lat", parseNmeaPosition(nmea.getField(2), nmea.getField(3)));
+        gga.set("lon", parseNmeaPosition(nmea.getField(4), nmea.getField(5)));
+        gga.set("quality", field(6));
+        gga.set("satCnt", field(7));
+        gga.set("hdop", field(8));
+        gga.set("alt", field(9));
+        gga.set("geoidSep", field(11));
+      } else if (nmea.getType() == NmeaTypeRMC) {
+        NmeaField status = nmea.getField(2);
+        rmc.startRow();
+        rmc.set("time", timeOf(rec));
+        rmc.set("talker", scaled(nmea.getTalker()));
+        rmc.set("status", status.len == 1 ? scaled(*status.ptr == 'A') : NO_VALUE);
+        rmc.set("lat", parseNmeaPosition(nmea.getField(3), nmea.getField(4)));
+        rmc.set("lon", parseNmeaPosition(nmea.getField(5), nmea.getField(6)));
+        rmc.set("speed", field(7));
+        rmc.set("course", field(8));
+        rmc.set("date", field(9));
+      }
+    }
+
+    Scaled field(uint8_t n) {
+      NmeaField fld = nmea.getField(n);
+      return parseScaled(fld.ptr, fld.len);
+    }
+
+    string habTimeName = "UTCTime";   // Name of the time column of the $HAB records.
+    vector<string> habNames;
+    vector<string> binaryNames;
+    vector<NmeaField> fields;
+    NmeaSentence nmea;
+};
+
+
+/*
+ * Make the name of the pack from the name of the log by replacing the extension.
+ */
+string packFileName(const char * logFile) {
+  string name = logFile;
+  size_t dot = name.find_last_of('.');
+  size_t slash = name.find_last_of('/');
+  if (dot != string::npos && (slash == string::npos || dot > slash)) {
+    name.erase(dot);
+  }
+  return name + "." HAB_PACK_EXT;
+}
+
+
+/*
+ * Convert a log to a pack.
+ */
+int packLog(const char * logFile) {
+  cerr << "Processing: " << logFile << endl;
+  auto start = chrono::steady_clock::now();
+
+  int fd = open(logFile, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    cerr << "Error opening the file." << endl;
+    return 1;
+  }
+  size_t size = st.st_size;
+  const char * log = NULL;
+  if (size > 0) {
+    void * p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    log = p == MAP_FAILED ? NULL : (const char *) p;
+  }
+  close(fd);
+  if (size > 0 && log == NULL) {
+    cerr << "Error mapping the file." << endl;
+    return 1;
+  }
+  if (log) {
+    madvise((void *) log, size, MADV_SEQUENTIAL);
+  }
+
+  // The scanner finds the records (including binary $HAB records), which are read in place.
+  HabLogScanner scanner;
+  PackBuilder pack;
+  for (size_t i = 0; i < size; i++) {
+    if (scanner.put(log[i])) {
+      pack.add(scanner.getRecord(), log + scanner.getRecord().offset);
+    }
+  }
+  if (scanner.finish()) {
+    pack.add(scanner.getRecord(), log + scanner.getRecord().offset);
+  }
+
+  string packFile = packFileName(logFile);
+  bool ok = pack.write(packFile.c_str());
+  if (log) {
+    munmap((void *) log, size);
+  }
+  if (!ok) {
+    return 1;
+  }
+
+  double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  long packSize = 0;
+  if (stat(packFile.c_str(), &st) == 0) {
+    packSize = st.st_size;
+  }
+  cerr << packFile << ": HAB " << pack.hab.rowCnt << ", GGA " << pack.gga.rowCnt << ", RMC " << pack.rmc.rowCnt
+       << " rows. " << size << " -> " << packSize << " bytes in " << (int) (secs * 1000) << " ms. Invalid: "
+       << pack.badCnt << endl;
+  return 0;
+}
+
+
+/*
+ * Open a pack, reporting the time taken.
+ */
+bool openPack(HabPack & pack, const char * file) {
+  auto start = chrono::steady_clock::now();
+  if (!pack.open(file)) {
+    cerr << "Error, " << file << " is not a valid pack." << endl;
+    return false;
+  }
+  double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "%s: %u columns, %llu bytes, opened in %.3f ms\n", file, pack.getColumnCnt(),
+          (unsigned long long) pack.getHeader().fileSize, ms);
+  return true;
+}
+
+
+/*
+ * List the columns of a pack.
+ */
+int listPack(const char * file) {
+  HabPack pack;
+  if (!openPack(pack, file)) {
+    return 1;
+  }
+  printf("%-6s %-18s %9s %-6s %5s %5s %9s\n", "table", "column", "rows", "enc", "width", "scale", "bytes");
+  for (uint16_t i = 0; i < pack.getColumnCnt(); i++) {
+    const HabPackColumn & col = pack.getColumn(i);
+    unsigned long bytes = (unsigned long) col.rowCnt * col.width + (col.validOffset ? (col.rowCnt + 7) / 8 : 0);
+    printf("%-6s %-18s %9u %-6s %5u %5d %9lu%s\n", col.table, col.name, col.rowCnt,
+           col.encoding == HabPackDelta ? "delta" : "raw", col.width, col.scale, bytes,
+           col.validOffset ? "  (has empty rows)" : "");
+  }
+  return 0;
+}
+
+
+/*
+ * Report the minimum, maximum and mean of every column.
+ */
+int statsPack(const char * file) {
+  HabPack pack;
+  if (!openPack(pack, file)) {
+    return 1;
+  }
+  auto start = chrono::steady_clock::now();
+  unsigned long long valueCnt = 0;
+  printf("%-6s %-18s %9s %16s %16s %16s\n", "table", "column", "values", "min", "max", "mean");
+  for (uint16_t i = 0; i < pack.getColumnCnt(); i++) {
+    const HabPackColumn & col = pack.getColumn(i);
+    HabPackColumnView view = pack.view(col);
+    unsigned long cnt = 0;
+    int64_t minValue = 0, maxValue = 0;
+    double sum = 0;
+    view.scan([&](uint32_t, int64_t value, bool valid) {
+      if (valid) {
+        minValue = cnt == 0 ? value : min(minValue, value);
+        maxValue = cnt == 0 ? value : max(maxValue, value);
+        sum += value;
+        cnt++;
+      }
+    });
+    valueCnt += cnt;
+    printf("%-6s %-18s %9lu %16.*f %16.*f %16.*f\n", col.table, col.name, cnt, col.scale, view.toDouble(minValue),
+           col.scale, view.toDouble(maxValue), col.scale, cnt ? view.toDouble(sum / cnt) : 0.0);
+  }
+  double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  fprintf(stderr, "%llu values scanned in %.3f ms\n", valueCnt, ms);
+  return 0;
+}
+
+
+/*
+ * Output columns of a table as CSV. Empty rows are output as empty fields.
+ */
+int columnsPack(const char * file, const char * table, int nameCnt, const char * names[]) {
+  HabPack pack;
+  if (!openPack(pack, file)) {
+    return 1;
+  }
+  vector<const HabPackColumn *> cols;
+  for (int i = 0; i < nameCnt; i++) {
+    const HabPackColumn * col = pack.findColumn(table, names[i]);
+    if (col == NULL) {
+      cerr << "No column " << table << "." << names[i] << endl;
+      return 1;
+    }
+    cols.push_back(col);
+  }
+
+  // Decode each column into text, then output the rows.
+  uint32_t rowCnt = cols[0]->rowCnt;
+  vector<vector<string>> text(cols.size(), vector<string>(rowCnt));
+  for (size_t c = 0; c < cols.size(); c++) {
+    HabPackColumnView view = pack.view(*cols[c]);
+    int scale = cols[c]->scale;
+    view.scan([&](uint32_t row, int64_t value, bool valid) {
+      if (valid) {
+        char buf[40];
+        snprintf(buf, sizeof(buf), "%.*f", scale, view.toDouble(value));
+        text[c][row] = buf;
+      }
+    });
+  }
+
+  for (int i = 0; i < nameCnt; i++) {
+    printf(i ? ",%s" : "%s", names[i]);
+  }
+  printf("\n");
+  for (uint32_t row = 0; row < rowCnt; row++) {
+    for (size_t c = 0; c < cols.size(); c++) {
+      printf(c ? ",%s" : "%s", text[c][row].c_str());
+    }
+    printf("\n");
+  }
+  return 0;
+}
+
+
+/* main
+ * ----
+ * Convert each log on the command line, or read one pack.
+ */
+int main(int argc, const char * argv[]) {
+  if (argc >= 3 && strcmp(argv[1], "-i") == 0) {
+    return listPack(argv[2]);
+  }
+  if (argc >= 3 && strcmp(argv[1], "-s") == 0) {
+    return statsPack(argv[2]);
+  }
+  if (argc >= 5 && strcmp(argv[1], "-c") == 0) {
+    return columnsPack(argv[2], argv[3], argc - 4, argv + 4);
+  }
+  if (argc < 2 || argv[1][0] == '-') {
+    cerr << "habpack v" << VERSION << endl;
+    cerr << "Usage: habpack file.log ... | -i file.hpk | -s file.hpk | -c file.hpk table col [col ...]" << endl;
+    return 1;
+  }
+
+  int rc = 0;
+  for (int i = 1; i < argc; i++) {
+    rc |= packLog(argv[i]);
+  }
+  return rc;
+}
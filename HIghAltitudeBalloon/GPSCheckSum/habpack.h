@@ -0,0 +1,228 @@
+#ifndef _HABPACK_H
+#define _HABPACK_H
+
+/*
+ * Columnar pack of a hab log, for post flight analysis.
+ *
+ * Each table ($HAB records, GGA and RMC sentences) is held as one column per field,
+ * so that a field can be read for a whole flight without parsing any text. Values
+ * are scaled integers, the value of a row is stored / 10^scale.
+ *
+ * A column is stored as whichever of these is smaller:
+ *   Raw   - the values as signed integers of width bytes. These can be read at random.
+ *   Delta - the change from the previous row, zigzag encoded as unsigned integers of
+ *           width bytes. The value before the first row is base.
+ * A column with empty fields also has a bitmap of the rows that hold a value.
+ *
+ * Layout (little endian, each column's data starts on an 8 byte boundary):
+ *   HabPackHeader
+ *   HabPackColumn[columnCnt]
+ *   The data and bitmap of each column.
+ *
+ * HabPack maps the pack into memory and the columns are read in place.
+ * Built by habpack.cpp.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HAB_PACK_MAGIC      "HPAK"
+#define HAB_PACK_VERSION    1
+#define HAB_PACK_EXT        "hpk"
+#define HAB_PACK_TABLE_LEN  8       // Including the null.
+#define HAB_PACK_NAME_LEN   24      // Including the null.
+#define HAB_PACK_ALIGN      8
+
+enum HabPackEncoding {
+  HabPackRaw, HabPackDelta
+};
+
+struct HabPackHeader {
+  char     magic[4];
+  uint16_t version;
+  uint16_t columnCnt;
+  uint64_t fileSize;
+} __attribute__((packed));
+
+struct HabPackColumn {
+  char     table[HAB_PACK_TABLE_LEN];
+  char     name[HAB_PACK_NAME_LEN];
+  uint8_t  encoding;        // HabPackEncoding.
+  uint8_t  width;           // Bytes per row: 1, 2, 4 or 8.
+  int8_t   scale;           // Decimal places.
+  uint8_t  reserved;
+  uint32_t rowCnt;
+  int64_t  base;            // Delta: the value before the first row.
+  uint64_t dataOffset;
+  uint64_t validOffset;     // Bitmap of rows with a value (LSB first), 0 if all have one.
+} __attribute__((packed));
+
+
+inline uint64_t habPackZigZag(int64_t v) {
+  return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+inline int64_t habPackUnZigZag(uint64_t v) {
+  return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+
+/*
+ * A column of a pack that has been mapped into memory.
+ */
+class HabPackColumnView {
+  public:
+    HabPackColumnView(const HabPackColumn & column, const uint8_t * pack)
+      : column(column), data(pack + column.dataOffset),
+        valid(column.validOffset ? pack + column.validOffset : NULL) {}
+
+    uint32_t size() const { return column.rowCnt; }
+
+    bool isValid(uint32_t row) const {
+      return valid == NULL || (valid[row >> 3] >> (row & 7)) & 1;
+    }
+
+    // Convert a stored value into its real value.
+    double toDouble(double value) const {
+      double d = value;
+      for (int i = 0; i < column.scale; i++) {
+        d /= 10.0;
+      }
+      return d;
+    }
+
+    /*
+     * Return the stored value of a row of a Raw column.
+     * Delta columns must be read in order with scan().
+     */
+    int64_t raw(uint32_t row) const {
+      const uint8_t * p = data + (size_t) row * column.width;
+      switch (column.width) {
+        case 1: return (int8_t) *p;
+        case 2: { int16_t v; memcpy(&v, p, sizeof(v)); return v; }
+        case 4: { int32_t v; memcpy(&v, p, sizeof(v)); return v; }
+        default: { int64_t v; memcpy(&v, p, sizeof(v)); return v; }
+      }
+    }
+
+    /*
+     * Call f(row, value, isValid) for each row in turn. value is the stored value,
+     * use toDouble() for the real value.
+     */
+    template <typename F> void scan(F f) const {
+      if (column.encoding == HabPackRaw) {
+        for (uint32_t row = 0; row < column.rowCnt; row++) {
+          f(row, raw(row), isValid(row));
+        }
+        return;
+      }
+      int64_t value = column.base;
+      for (uint32_t row = 0; row < column.rowCnt; row++) {
+        value += habPackUnZigZag((uint64_t) raw(row) & widthMask());
+        f(row, value, isValid(row));
+      }
+    }
+
+  private:
+    uint64_t widthMask() const {
+      return column.width >= 8 ? ~(uint64_t) 0 : ((uint64_t) 1 << (column.width * 8)) - 1;
+    }
+
+    const HabPackColumn & column;
+    const uint8_t * data;
+    const uint8_t * valid;
+};
+
+
+/*
+ * A pack file mapped into memory.
+ */
+class HabPack {
+  public:
+    HabPack() {}
+    ~HabPack() { close(); }
+
+    /*
+     * Map a pack and check that it is complete. Return false if it cannot be
+     * opened or is not a valid pack.
+     */
+    bool open(const char * file) {
+      close();
+      int fd = ::open(file, O_RDONLY);
+      if (fd < 0) {
+        return false;
+      }
+      struct stat st;
+      if (fstat(fd, &st) == 0 && st.st_size >= (off_t) sizeof(HabPackHeader)) {
+        size = st.st_size;
+        void * p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        base = p == MAP_FAILED ? NULL : (const uint8_t *) p;
+      }
+      ::close(fd);
+      if (base == NULL || !isValid()) {
+        close();
+        return false;
+      }
+      return true;
+    }
+
+    void close() {
+      if (base) {
+        munmap((void *) base, size);
+      }
+      base = NULL;
+      size = 0;
+    }
+
+    const HabPackHeader & getHeader() const { return *(const HabPackHeader *) base; }
+    uint16_t getColumnCnt() const { return getHeader().columnCnt; }
+
+    const HabPackColumn & getColumn(uint16_t i) const {
+      return ((const HabPackColumn *) (base + sizeof(HabPackHeader)))[i];
+    }
+
+    // Return the column of a table, or NULL if there is no such column.
+    const HabPackColumn * findColumn(const char * table, const char * name) const {
+      for (uint16_t i = 0; i < getColumnCnt(); i++) {
+        const HabPackColumn & col = getColumn(i);
+        if (strncmp(col.table, table, HAB_PACK_TABLE_LEN) == 0 && strncmp(col.name, name, HAB_PACK_NAME_LEN) == 0) {
+          return &col;
+        }
+      }
+      return NULL;
+    }
+
+    HabPackColumnView view(const HabPackColumn & column) const {
+      return HabPackColumnView(column, base);
+    }
+
+  private:
+    bool isValid() const {
+      const HabPackHeader & header = getHeader();
+      if (memcmp(header.magic, HAB_PACK_MAGIC, sizeof(header.magic)) != 0
+            || header.version != HAB_PACK_VERSION || header.fileSize != size
+            || sizeof(HabPackHeader) + (uint64_t) header.columnCnt * sizeof(HabPackColumn) > size) {
+        return false;
+      }
+      for (uint16_t i = 0; i < header.columnCnt; i++) {
+        const HabPackColumn & col = getColumn(i);
+        uint64_t dataEnd = col.dataOffset + (uint64_t) col.rowCnt * col.width;
+        uint64_t validEnd = col.validOffset + (col.rowCnt + 7) / 8;
+        if ((col.width != 1 && col.width != 2 && col.width != 4 && col.width != 8)
+              || col.encoding > HabPackDelta || dataEnd > size || (col.validOffset && validEnd > size)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    const uint8_t * base = NULL;
+    size_t size = 0;
+};
+
+#endif
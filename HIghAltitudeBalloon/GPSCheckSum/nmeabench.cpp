@@ -0,0 +1,329 @@
+/**
+  * nmeabench.cpp
+  * -------------
+  *
+  * Measure the throughput of the NMEA tokenizer (habFlightMonitor/Nmea.h) and the
+  * checksum kernels (nmeasimd.h) against the character by character checksum
+  * used by the original gpschksum and by the logger's GPS ingest (NmeaChecksum).
+  * The time taken by each sentence is also reported: the median, 99th percentile
+  * and slowest, less the cost of reading the clock.
+  *
+  * The logs are read into memory first, so only the parsing is timed.
+  * A log of generated sentences is always measured, followed by any files given
+  * (habgen makes logs of any size).
+  * Before timing, each kernel is checked against NmeaSentence::parse() line by line,
+  * and on lines with terminators in awkward places (e.g. a CR before the '$').
+  *
+  * By: G. McCall
+  *     Oct-2026
+  *
+  * Usage:
+  *   nmeabench [-n passes] [file.log ...]
+  *
+  * Build:
+  *   g++ -O2 -o nmeabench nmeabench.cpp
+  *
+  * History:
+  *
+  *  v1.03.00.00 - 17-Oct-2026
+  *    The kernels are also checked on lines with terminators in awkward places.
+  *
+  *  v1.02.00.00 - 17-Oct-2026
+  *    Added the per sentence times and the GPS ingest checksum.
+  *
+  *  v1.01.00.00 - 17-Oct-2026
+  *    Added the scalar, SSE2 and AVX2 checksum kernels. Rates are in GB/s.
+  *    Generated and real logs are measured in one run.
+  *
+  *  v1.00.00.00 - 17-Oct-2026
+  *    Initial version.
+  */
+
+#define VERSION "1.03.00.00"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+#define NMEA_MAX_LENGTH 4096
+#include "../habFlightMonitor/Nmea.h"
+#include "nmeasimd.h"
+
+using namespace std;
+
+// Nanoseconds taken to read the clock, removed from each sentence's time.
+static double clockCostNs = 0;
+
+
+/* The original conversion of a hexadecimal character to an integer. */
+unsigned int hextoint(const char digit) {
+  const char lookup [] = "0123456789ABCDEF";
+  char ch = toupper(digit);
+  unsigned int result = 0;
+
+  for (result = 0; result < sizeof(lookup); result++) {
+    if (lookup[result] == ch) {
+      break;
+    }
+  }
+  return result;
+}
+
+
+/* The original checksum calculation. Return 0 if the checksum is correct. */
+unsigned int legacyChecksum(const char * p) {
+  unsigned int parity = 0;
+  unsigned int chksum = 0;
+  bool isCheckSumTerm = false;
+  while (*p) {
+    switch (*p) {
+      case '$':
+        parity = 0;
+        isCheckSumTerm = false;
+        break;
+      case '*':
+        isCheckSumTerm = true;
+        chksum = 0;
+        break;
+      default:
+        if (!isCheckSumTerm) {
+          parity ^= (unsigned int) *p;
+        } else {
+          chksum = (chksum << 4) | hextoint(*p);
+        }
+        break;
+    }
+    p++;
+  }
+  return parity != chksum ? parity : 0;
+}
+
+
+/*
+ * Generate a log of typical sentences.
+ */
+void generateLog(vector<string> & lines, int count) {
+  const char * bodies[] = {
+    "GNRMC,%02d%02d%02d.00,A,3352.12345,S,15112.54321,E,0.012,,170926,,,A",
+    "GNGGA,%02d%02d%02d.00,3352.12345,S,15112.54321,E,1,12,0.78,21834.5,M,21.3,M,,",
+    "GPGSV,3,1,11,02,45,123,38,05,12,045,30,07,67,289,42,09,23,310,35",
+    "GNTXT,01,01,02,u-blox AG - www.u-blox.com %02d%02d%02d",
+  };
+  char body[200];
+  char line[210];
+  for (int i = 0; i < count; i++) {
+    int t = i / 4;
+    snprintf(body, sizeof(body), bodies[i % 4], (t / 3600) % 24, (t / 60) % 60, t % 60);
+    uint8_t parity = 0;
+    for (const char * p = body; *p; p++) {
+      parity ^= *p;
+    }
+    snprintf(line, sizeof(line), "$%s*%02X", body, parity);
+    lines.push_back(line);
+  }
+}
+
+
+/*
+ * Measure the cost of reading the clock.
+ */
+double measureClockCost() {
+  double best = 1e9;
+  for (int i = 0; i < 10000; i++) {
+    auto t0 = chrono::steady_clock::now();
+    auto t1 = chrono::steady_clock::now();
+    best = min(best, chrono::duration<double, nano>(t1 - t0).count());
+  }
+  return best;
+}
+
+
+/*
+ * Time passes over the lines and report the rate, then time each line on its own
+ * and report the median, 99th percentile and slowest.
+ */
+template <typename F> void bench(const char * name, const vector<string> & lines, size_t bytes, int passes, F parse) {
+  unsigned long errCnt = 0;
+  auto start = chrono::steady_clock::now();
+  for (int pass = 0; pass < passes; pass++) {
+    for (const string & line : lines) {
+      errCnt += parse(line);
+    }
+  }
+  double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  double gb = (double) bytes * passes / 1e9;
+
+  vector<double> times;
+  times.reserve(lines.size());
+  for (const string & line : lines) {
+    auto t0 = chrono::steady_clock::now();
+    errCnt += parse(line);
+    auto t1 = chrono::steady_clock::now();
+    times.push_back(max(0.0, chrono::duration<double, nano>(t1 - t0).count() - clockCostNs));
+  }
+  sort(times.begin(), times.end());
+  double p50 = times.empty() ? 0 : times[times.size() / 2];
+  double p99 = times.empty() ? 0 : times[times.size() * 99 / 100];
+  double slowest = times.empty() ? 0 : times.back();
+
+  printf("  %-12s %7.3f GB/s %10.0f sentences/s  p50 %5.0f  p99 %5.0f  max %7.0f ns  (errors: %lu)\n", name, gb / secs,
+         (double) lines.size() * passes / secs, p50, p99, slowest, errCnt / (passes + 1));
+}
+
+
+/*
+ * Check that a kernel gives the same result as the tokenizer for every line.
+ * Return the number of lines that differ.
+ */
+unsigned long verifyKernel(const vector<string> & lines, const NmeaSimdOps & ops) {
+  NmeaSentence nmea;
+  unsigned long diffCnt = 0;
+  for (const string & line : lines) {
+    uint8_t parity;
+    NmeaStatus status = nmeaVerify(line.c_str(), line.length(), parity, ops);
+    if (status != nmea.parse(line.c_str(), line.length()) || (status != NmeaTooLong && parity != nmea.getParity())) {
+      if (diffCnt++ < 5) {
+        printf("  **** %s differs: %s\n", ops.name, line.c_str());
+      }
+    }
+  }
+  return diffCnt;
+}
+
+
+/*
+ * Lines with terminators and delimiters in awkward places, which each kernel is also
+ * checked against. The lines of a log have had their terminators removed.
+ */
+const vector<string> & edgeLines() {
+  static const vector<string> lines = {
+    "\r$GNTXT,01,01,02,ANTSTATUS=OK*25\r\n",
+    "\r\n$GNTXT,01,01,02,ANTSTATUS=OK*25",
+    "\n$GNTXT,01,01,02,ANTSTATUS=OK*25\r\n$GPGGA,1*00",
+    "xx*\r$GNTXT,01,01,02,ANTSTATUS=OK*25\n",
+    "$GNTXT,01,01,02,ANTSTATUS=OK\r*25\n",
+    "$GNTXT,01,$GNTXT,01,01,02,ANTSTATUS=OK*25\r\n",
+    "GNTXT,01,01,02,ANTSTATUS=OK*25\r\n",
+    "\r\n",
+    ""
+  };
+  return lines;
+}
+
+
+/*
+ * Run each of the parsers over a log.
+ */
+void runBenchmarks(const char * name, const vector<string> & lines, int passes) {
+  size_t bytes = 0;
+  for (const string & line : lines) {
+    bytes += line.length();
+  }
+  printf("%s: %zu lines, %zu bytes, %d passes\n", name, lines.size(), bytes, passes);
+
+  bench("legacy", lines, bytes, passes, [](const string & line) {
+    return legacyChecksum(line.c_str()) != 0 ? 1 : 0;
+  });
+
+  // The checksum as the logger's GPS ingest calculates it, a character at a time
+  // as the characters arrive.
+  NmeaChecksum checksum;
+  bench("ingest", lines, bytes, passes, [&checksum](const string & line) {
+    checksum.reset();
+    for (char ch : line) {
+      checksum.update(ch);
+    }
+    return checksum.isOk() ? 0 : 1;
+  });
+
+  NmeaSentence nmea;
+  bench("Nmea.h", lines, bytes, passes, [&nmea](const string & line) {
+    return nmea.parse(line.c_str(), line.length()) != NmeaOk ? 1 : 0;
+  });
+
+  // Also touch every field, as a consumer of the tokenizer would.
+  bench("Nmea.h+flds", lines, bytes, passes, [&nmea](const string & line) {
+    int bad = nmea.parse(line.c_str(), line.length()) != NmeaOk ? 1 : 0;
+    unsigned int len = 0;
+    for (uint8_t i = 0; i < nmea.getFieldCnt(); i++) {
+      len += nmea.getField(i).len;
+    }
+    return len == 0 ? 1 : bad;
+  });
+
+  // The checksum kernels. One the CPU cannot run is reported as its fallback.
+  for (int k = 0; k < NmeaKernelCnt; k++) {
+    const NmeaSimdOps & ops = nmeaSimdOps((NmeaKernel) k);
+    if (verifyKernel(lines, ops) + verifyKernel(edgeLines(), ops) != 0) {
+      continue;
+    }
+    bench(ops.name, lines, bytes, passes, [&ops](const string & line) {
+      uint8_t parity;
+      return nmeaVerify(line.c_str(), line.length(), parity, ops) != NmeaOk ? 1 : 0;
+    });
+  }
+}
+
+
+/*
+ * Load the lines of a log, without their line terminators.
+ */
+bool loadLog(const char * file, vector<string> & lines) {
+  ifstream datafile(file);
+  if (!datafile) {
+    return false;
+  }
+  string inLine;
+  while (getline(datafile, inLine)) {
+    if (!inLine.empty() && inLine.back() == '\r') {
+      inLine.pop_back();
+    }
+    if (!inLine.empty()) {
+      lines.push_back(inLine);
+    }
+  }
+  return true;
+}
+
+
+/* main
+ * ----
+ * Measure a generated log, then each of the logs on the command line.
+ */
+int main(int argc, const char * argv[]) {
+  int passes = 20;
+  vector<const char *> files;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      passes = atoi(argv[++i]);
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (passes < 1) {
+    passes = 1;
+  }
+  clockCostNs = measureClockCost();
+  printf("nmeabench v%s, best kernel: %s, clock cost %.0f ns\n", VERSION, nmeaSimdBest().name, clockCostNs);
+
+  vector<string> lines;
+  generateLog(lines, 200000);
+  runBenchmarks("generated", lines, passes);
+
+  for (const char * file : files) {
+    lines.clear();
+    if (!loadLog(file, lines)) {
+      cerr << "Error opening " << file << endl;
+      continue;
+    }
+    runBenchmarks(file, lines, passes);
+  }
+  return 0;
+}
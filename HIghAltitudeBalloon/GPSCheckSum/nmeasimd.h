@@ -0,0 +1,234 @@
+#ifndef _NMEASIMD_H
+#define _NMEASIMD_H
+
+/*
+ * Vectorised NMEA checksum verification for the host side tools.
+ *
+ * nmeaVerify() gives the same status and parity as NmeaSentence::parse() (see
+ * habFlightMonitor/Nmea.h), but it does not find the fields. The delimiters are
+ * found and the data is XORed 16 (SSE2) or 32 (AVX2) bytes at a time.
+ *
+ * The kernel is chosen when the program starts from what the CPU supports.
+ * The scalar kernel is used on other processors and gives identical results.
+ *
+ * Nmea.h must be included first, so that NMEA_MAX_LENGTH is the caller's value.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NMEA_SIMD_X86
+#endif
+
+enum NmeaKernel {
+  NmeaKernelScalar, NmeaKernelSSE2, NmeaKernelAVX2, NmeaKernelCnt
+};
+
+/*
+ * The primitives used by nmeaVerify. Each works on the range [p, end).
+ */
+struct NmeaSimdOps {
+  const char * name;
+  // Return the first occurrence of ch, or end.
+  const char * (*find)(const char * p, const char * end, char ch);
+  // Return the first CR or LF, or end.
+  const char * (*findEol)(const char * p, const char * end);
+  // Return the XOR of all of the bytes.
+  uint8_t (*xorBytes)(const char * p, const char * end);
+};
+
+
+/****************************************************
+ * Scalar kernel.
+ ****************************************************/
+inline const char * nmeaScalarFind(const char * p, const char * end, char ch) {
+  while (p < end && *p != ch) {
+    p++;
+  }
+  return p;
+}
+
+inline const char * nmeaScalarFindEol(const char * p, const char * end) {
+  while (p < end && *p != '\r' && *p != '\n') {
+    p++;
+  }
+  return p;
+}
+
+inline uint8_t nmeaScalarXor(const char * p, const char * end) {
+  uint8_t x = 0;
+  while (p < end) {
+    x ^= *p++;
+  }
+  return x;
+}
+
+
+#if defined(NMEA_SIMD_X86)
+/****************************************************
+ * SSE2 kernel.
+ ****************************************************/
+__attribute__((target("sse2")))
+inline const char * nmeaSse2Find(const char * p, const char * end, char ch) {
+  __m128i needle = _mm_set1_epi8(ch);
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) p);
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return nmeaScalarFind(p, end, ch);
+}
+
+__attribute__((target("sse2")))
+inline const char * nmeaSse2FindEol(const char * p, const char * end) {
+  __m128i cr = _mm_set1_epi8('\r');
+  __m128i lf = _mm_set1_epi8('\n');
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) p);
+    int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)));
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return nmeaScalarFindEol(p, end);
+}
+
+__attribute__((target("sse2")))
+inline uint8_t nmeaSse2Reduce(__m128i acc) {
+  acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+  acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 4));
+  acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 2));
+  acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 1));
+  return (uint8_t) _mm_cvtsi128_si32(acc);
+}
+
+__attribute__((target("sse2")))
+inline uint8_t nmeaSse2Xor(const char * p, const char * end) {
+  __m128i acc = _mm_setzero_si128();
+  for (; end - p >= 16; p += 16) {
+    acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i *) p));
+  }
+  return nmeaSse2Reduce(acc) ^ nmeaScalarXor(p, end);
+}
+
+
+/****************************************************
+ * AVX2 kernel. The remainder of less than 32 bytes is handled by SSE2.
+ ****************************************************/
+__attribute__((target("avx2")))
+inline const char * nmeaAvx2Find(const char * p, const char * end, char ch) {
+  __m256i needle = _mm256_set1_epi8(ch);
+  for (; end - p >= 32; p += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) p);
+    unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle));
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return nmeaSse2Find(p, end, ch);
+}
+
+__attribute__((target("avx2")))
+inline const char * nmeaAvx2FindEol(const char * p, const char * end) {
+  __m256i cr = _mm256_set1_epi8('\r');
+  __m256i lf = _mm256_set1_epi8('\n');
+  for (; end - p >= 32; p += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) p);
+    unsigned int mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf)));
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return nmeaSse2FindEol(p, end);
+}
+
+__attribute__((target("avx2")))
+inline uint8_t nmeaAvx2Xor(const char * p, const char * end) {
+  __m256i acc = _mm256_setzero_si256();
+  for (; end - p >= 32; p += 32) {
+    acc = _mm256_xor_si256(acc, _mm256_loadu_si256((const __m256i *) p));
+  }
+  __m128i acc128 = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  return nmeaSse2Reduce(acc128) ^ nmeaSse2Xor(p, end);
+}
+#endif
+
+
+/*
+ * Return the primitives for a kernel. A kernel the CPU cannot run falls back to scalar.
+ */
+inline const NmeaSimdOps & nmeaSimdOps(NmeaKernel kernel) {
+  static const NmeaSimdOps scalar = { "scalar", nmeaScalarFind, nmeaScalarFindEol, nmeaScalarXor };
+#if defined(NMEA_SIMD_X86)
+  static const NmeaSimdOps sse2 = { "sse2", nmeaSse2Find, nmeaSse2FindEol, nmeaSse2Xor };
+  static const NmeaSimdOps avx2 = { "avx2", nmeaAvx2Find, nmeaAvx2FindEol, nmeaAvx2Xor };
+
+  __builtin_cpu_init();
+  if (kernel == NmeaKernelAVX2 && __builtin_cpu_supports("avx2")) {
+    return avx2;
+  }
+  if (kernel >= NmeaKernelSSE2 && __builtin_cpu_supports("sse2")) {
+    return sse2;
+  }
+#endif
+  return scalar;
+}
+
+
+/*
+ * Return the primitives for the best kernel that the CPU supports.
+ */
+inline const NmeaSimdOps & nmeaSimdBest() {
+  static const NmeaSimdOps & best = nmeaSimdOps(NmeaKernelAVX2);
+  return best;
+}
+
+
+/*
+ * Verify the checksum of a line of len characters.
+ * parity is set to the XOR of the data, which is the checksum the line should contain.
+ * Returns the same status as NmeaSentence::parse().
+ */
+inline NmeaStatus nmeaVerify(const char * line, size_t len, uint8_t & parity,
+                             const NmeaSimdOps & ops = nmeaSimdBest()) {
+  parity = 0;
+  if (len > NMEA_MAX_LENGTH) {
+    return NmeaTooLong;
+  }
+  // The sentence starts at the first '$' in the line, a terminator before it is skipped.
+  const char * lineEnd = line + len;
+  const char * start = ops.find(line, lineEnd, '$');
+  if (start == lineEnd) {
+    parity = ops.xorBytes(line, lineEnd);
+    return NmeaNoStart;
+  }
+
+  // The data ends at the first '*' or terminator, a '$' before it restarts the sentence.
+  const char * end = ops.findEol(start + 1, lineEnd);
+  const char * star = ops.find(start + 1, end, '*');
+  const char * restart;
+  while ((restart = ops.find(start + 1, star, '$')) != star) {
+    start = restart;
+  }
+  parity = ops.xorBytes(start + 1, star);
+  if (star == end) {
+    return NmeaNoChecksum;
+  }
+
+  // The checksum digits, which end at the terminator.
+  if (end - star != 3) {
+    return NmeaBadChecksum;
+  }
+  uint8_t hi = nmeaHexValue(star[1]);
+  uint8_t lo = nmeaHexValue(star[2]);
+  if (hi == NMEA_NOT_HEX || lo == NMEA_NOT_HEX || ((hi << 4) | lo) != parity) {
+    return NmeaBadChecksum;
+  }
+  return NmeaOk;
+}
+
+#endif
@@ -0,0 +1,372 @@
+/**
+  * nmeatest.cpp
+  * ------------
+  *
+  * Unit tests for the NMEA tokenizer shared by the loggers and the host tools
+  * (habFlightMonitor/Nmea.h): NmeaSentence::parse(), the field views, nmeaClassify()
+  * and NmeaChecksum, the character at a time checksum used by the GPS ingest.
+  * Each checksum kernel of nmeasimd.h (used by gpschksum) is checked against parse() too.
+  *
+  * The edge cases are checked first: a missing '$' or '*', bad, missing, extra and
+  * lowercase checksum digits, CR/LF handling, empty fields, too many fields and an
+  * over-long sentence. Then random corruptions of valid sentences are checked to give
+  * the same result from NmeaChecksum and the kernels as from NmeaSentence::parse().
+  *
+  * NMEA_MAX_LENGTH is left at the value the sketches use.
+  * nmeabench measures the speed of the same code.
+  *
+  * By: G. McCall
+  *     Oct-2026
+  *
+  * Usage:
+  *   nmeatest [-n count] [--seed n]
+  *
+  *   -n count    Random sentences checked (default 100000).
+  *
+  *   The exit status is 0 if every check passed, otherwise 1.
+  *
+  * Build:
+  *   g++ -O2 -o nmeatest nmeatest.cpp
+  *
+  * History:
+  *
+  *  v1.01.00.00 - 17-Oct-2026
+  *    The nmeasimd.h kernels are checked against parse(), including a terminator
+  *    before the '$'.
+  *
+  *  v1.00.00.00 - 17-Oct-2026
+  *    Initial version.
+  */
+
+#define VERSION "1.01.00.00"
+
+#include <iostream>
+#include <string>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../habFlightMonitor/Nmea.h"
+#include "nmeasimd.h"
+
+using namespace std;
+
+
+static unsigned long checkCnt = 0;
+static unsigned long errCnt = 0;
+
+/*
+ * Record the result of a check. what and text describe it if it failed.
+ */
+void check(bool ok, const string & what, const string & text) {
+  checkCnt++;
+  if (!ok && ++errCnt <= 20) {
+    cerr << "**** " << what << ": \"" << text << "\"" << endl;
+  }
+}
+
+
+/* The text of a field. */
+string fieldText(const NmeaSentence & s, uint8_t n) {
+  NmeaField fld = s.getField(n);
+  return string(fld.ptr, fld.len);
+}
+
+
+/* A sentence with the correct checksum (in uppercase) for the data, and a terminator. */
+string withChecksum(const string & data, const char * eol = "\r\n") {
+  uint8_t parity = 0;
+  for (char ch : data) {
+    parity ^= ch;
+  }
+  char buf[8];
+  snprintf(buf, sizeof(buf), "*%02X", parity);
+  return "$" + data + buf + eol;
+}
+
+
+/* Parse a sentence held in a string. */
+NmeaStatus parse(NmeaSentence & s, const string & text) {
+  return s.parse(text.data(), text.size());
+}
+
+
+/* Feed a sentence through NmeaChecksum one character at a time. */
+bool streamOk(const string & text, uint8_t * parity = NULL) {
+  NmeaChecksum chk;
+  chk.reset();
+  for (char ch : text) {
+    chk.update(ch);
+  }
+  if (parity) {
+    *parity = chk.getParity();
+  }
+  return chk.isOk();
+}
+
+
+/*
+ * Check that every kernel gives the status and parity that parse() gave s for text.
+ */
+void checkKernels(const NmeaSentence & s, const string & text, const string & what) {
+  for (int k = 0; k < NmeaKernelCnt; k++) {
+    const NmeaSimdOps & ops = nmeaSimdOps((NmeaKernel) k);
+    uint8_t parity;
+    NmeaStatus status = nmeaVerify(text.data(), text.size(), parity, ops);
+    check(status == s.getStatus() && (status == NmeaTooLong || parity == s.getParity()),
+          what + " (" + ops.name + " kernel)", text);
+  }
+}
+
+
+/*
+ * Check the status of a sentence from parse() and that NmeaChecksum and the kernels agree.
+ */
+void checkStatus(const string & text, NmeaStatus expected, const char * what) {
+  NmeaSentence s;
+  check(parse(s, text) == expected, what, text);
+  check(s.getStatus() == expected && s.isValid() == (expected == NmeaOk), what, text);
+  if (expected != NmeaTooLong) {
+    check(streamOk(text) == (expected == NmeaOk), string(what) + " (NmeaChecksum)", text);
+  }
+  checkKernels(s, text, what);
+}
+
+
+void testParse() {
+  const string gga = withChecksum("GPGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,");
+  NmeaSentence s;
+  check(parse(s, gga) == NmeaOk, "GGA parses", gga);
+  check(s.getTalker() == NmeaTalkerGP && s.getType() == NmeaTypeGGA, "GGA talker and type", gga);
+  check(s.getFieldCnt() == 15, "GGA field count", gga);
+  check(fieldText(s, 0) == "GPGGA", "GGA address field", gga);
+  check(fieldText(s, 1) == "092725.00", "GGA time field", gga);
+  check(fieldText(s, 9) == "499.6", "GGA altitude field", gga);
+  check(fieldText(s, 13) == "" && fieldText(s, 14) == "", "GGA trailing empty fields", gga);
+  check(s.getField(15).len == 0 && s.getField(255).len == 0, "Field out of range is empty", gga);
+  check(s.getChecksum() == s.getParity(), "Checksum matches parity", gga);
+  check(s.getField(9).ptr == gga.data() + gga.find("499.6"), "Field points into the buffer", gga);
+
+  // Line terminators, and text before the '$'.
+  const string rmc = "GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A";
+  checkStatus(withChecksum(rmc, ""), NmeaOk, "No terminator");
+  checkStatus(withChecksum(rmc, "\n"), NmeaOk, "LF only");
+  checkStatus(withChecksum(rmc, "\r"), NmeaOk, "CR only");
+  checkStatus(withChecksum(rmc, "\r\n\r\n"), NmeaOk, "Two terminators");
+  checkStatus("xx,*" + withChecksum(rmc), NmeaOk, "Text before the '$'");
+  checkStatus("\r\n" + withChecksum(rmc), NmeaOk, "Terminator before the '$'");
+  checkStatus("\r$GNTXT,01,01,02,ANTSTATUS=OK*25\r\n", NmeaOk, "CR before the '$'");
+  checkStatus(withChecksum(rmc) + "xx*00", NmeaOk, "Text after the terminator");
+  checkStatus("$GPR$" + withChecksum(rmc).substr(1), NmeaOk, "Restart at a second '$'");
+  string crInData = withChecksum(rmc);
+  crInData.insert(10, "\r");
+  checkStatus(crInData, NmeaNoChecksum, "CR within the data ends the sentence");
+
+  // The '$' and '*'.
+  string noStart = withChecksum(rmc).substr(1);
+  checkStatus(noStart, NmeaNoStart, "Missing '$'");
+  checkStatus("", NmeaNoStart, "Empty");
+  checkStatus("\r\n", NmeaNoStart, "Terminator only");
+  string noStar = "$" + rmc + "\r\n";
+  checkStatus(noStar, NmeaNoChecksum, "Missing '*'");
+  parse(s, noStar);
+  check(s.getType() == NmeaTypeRMC && s.getFieldCnt() == 13 && fieldText(s, 12) == "A",
+        "Fields without a checksum", noStar);
+  checkStatus("*00$" + rmc + "\r\n", NmeaNoChecksum, "'*' before the '$'");
+
+  // The checksum digits.
+  string good = withChecksum(rmc, "");
+  string digits = good.substr(good.size() - 2);
+  checkStatus(good.substr(0, good.size() - 1) + "\r\n", NmeaBadChecksum, "One checksum digit");
+  checkStatus(good.substr(0, good.size() - 2) + "\r\n", NmeaBadChecksum, "No checksum digits");
+  checkStatus(good + "0\r\n", NmeaBadChecksum, "Three checksum digits");
+  checkStatus(good + " \r\n", NmeaBadChecksum, "Space after the checksum");
+  checkStatus(good.substr(0, good.size() - 1) + "G\r\n", NmeaBadChecksum, "Checksum digit 'G'");
+  checkStatus(good.substr(0, good.size() - 2) + "-1\r\n", NmeaBadChecksum, "Checksum digit '-'");
+  string wrong = good;
+  wrong[wrong.size() - 1] = wrong[wrong.size() - 1] == '0' ? '1' : '0';
+  checkStatus(wrong + "\r\n", NmeaBadChecksum, "Incorrect checksum");
+  string upper = withChecksum("GPTXT,01,01,02,ANTSTATUS=OK", "");   // Checksum with letters.
+  string lower = upper;
+  for (size_t i = lower.size() - 2; i < lower.size(); i++) {
+    lower[i] = tolower(lower[i]);
+  }
+  check(lower != upper, "Lowercase test sentence has letters in its checksum", upper);
+  checkStatus(lower + "\r\n", NmeaOk, "Lowercase checksum digits");
+  checkStatus(good + "*", NmeaBadChecksum, "Second '*'");
+  parse(s, good);
+  check(s.getChecksum() == (uint8_t) strtoul(digits.c_str(), NULL, 16), "Checksum value", good);
+
+  // Empty fields.
+  string empty = withChecksum("GPGLL,,,,,,V,N");
+  checkStatus(empty, NmeaOk, "Empty fields");
+  parse(s, empty);
+  check(s.getFieldCnt() == 8, "Empty field count", empty);
+  for (int i = 1; i <= 5; i++) {
+    check(s.getField(i).len == 0, "Empty field length", empty);
+  }
+  check(fieldText(s, 6) == "V" && fieldText(s, 7) == "N", "Fields after empty fields", empty);
+  string noFields = withChecksum("");
+  checkStatus(noFields, NmeaOk, "No data");
+  parse(s, noFields);
+  check(s.getFieldCnt() == 1 && s.getField(0).len == 0, "Empty address field", noFields);
+  check(s.getTalker() == NmeaTalkerUnknown && s.getType() == NmeaTypeUnknown, "No data is unknown", noFields);
+
+  // More fields than NMEA_MAX_FIELDS, the rest are part of the last one.
+  string many = "GPGSV";
+  for (int i = 1; i <= NMEA_MAX_FIELDS + 5; i++) {
+    many += "," + to_string(i);
+  }
+  string manySentence = withChecksum(many);
+  checkStatus(manySentence, NmeaOk, "Too many fields");
+  parse(s, manySentence);
+  string last = fieldText(s, NMEA_MAX_FIELDS - 1);
+  check(s.getFieldCnt() == NMEA_MAX_FIELDS, "Field count is limited", manySentence);
+  string rest = to_string(NMEA_MAX_FIELDS - 1);
+  for (int i = NMEA_MAX_FIELDS; i <= NMEA_MAX_FIELDS + 5; i++) {
+    rest += "," + to_string(i);
+  }
+  check(last == rest, "Last field holds the rest, up to the '*'", last);
+
+  // Length limit, the terminator counts.
+  string longData = "GPTXT,01,01,02,";
+  string longest = withChecksum(longData + string(NMEA_MAX_LENGTH - longData.size() - 6, 'x'), "\r\n");
+  check(longest.size() == NMEA_MAX_LENGTH, "Longest sentence test length", to_string(longest.size()));
+  checkStatus(longest, NmeaOk, "Longest sentence");
+  parse(s, longest);
+  check(s.getField(4).len == NMEA_MAX_LENGTH - longData.size() - 6, "Longest field length", longest);
+  string tooLong = longest + "\n";
+  checkStatus(tooLong, NmeaTooLong, "Over-long sentence");
+  parse(s, tooLong);
+  check(s.getFieldCnt() == 0 && s.getType() == NmeaTypeUnknown, "Over-long sentence has no fields", tooLong);
+  check(streamOk(tooLong), "NmeaChecksum has no length limit", tooLong);
+}
+
+
+void checkClassify(const char * addr, NmeaTalker expTalker, NmeaType expType) {
+  NmeaTalker talker;
+  NmeaType type;
+  nmeaClassify(addr, strlen(addr), talker, type);
+  check(talker == expTalker && type == expType, "nmeaClassify", addr);
+}
+
+
+void testClassify() {
+  checkClassify("GPRMC", NmeaTalkerGP, NmeaTypeRMC);
+  checkClassify("GNGGA", NmeaTalkerGN, NmeaTypeGGA);
+  checkClassify("GLGSV", NmeaTalkerGL, NmeaTypeGSV);
+  checkClassify("GAGSA", NmeaTalkerGA, NmeaTypeGSA);
+  checkClassify("GBGLL", NmeaTalkerGB, NmeaTypeGLL);
+  checkClassify("GQVTG", NmeaTalkerGQ, NmeaTypeVTG);
+  checkClassify("GPZDA", NmeaTalkerGP, NmeaTypeZDA);
+  checkClassify("GNTXT", NmeaTalkerGN, NmeaTypeTXT);
+  checkClassify("GPXYZ", NmeaTalkerGP, NmeaTypeUnknown);
+  checkClassify("GZRMC", NmeaTalkerOther, NmeaTypeRMC);
+  checkClassify("BDGSV", NmeaTalkerOther, NmeaTypeGSV);
+  checkClassify("PUBX", NmeaTalkerProprietary, NmeaTypeUnknown);
+  checkClassify("PGRMZ", NmeaTalkerProprietary, NmeaTypeUnknown);
+  checkClassify("P", NmeaTalkerProprietary, NmeaTypeUnknown);
+  checkClassify("GPGG", NmeaTalkerUnknown, NmeaTypeUnknown);
+  checkClassify("", NmeaTalkerUnknown, NmeaTypeUnknown);
+  checkClassify("gprmc", NmeaTalkerOther, NmeaTypeUnknown);
+
+  // Only the first addrLen characters are examined.
+  NmeaTalker talker;
+  NmeaType type;
+  nmeaClassify("GPRMC,123", 5, talker, type);
+  check(talker == NmeaTalkerGP && type == NmeaTypeRMC, "nmeaClassify with following text", "GPRMC,123");
+  nmeaClassify("GPRMC", 4, talker, type);
+  check(talker == NmeaTalkerUnknown && type == NmeaTypeUnknown, "nmeaClassify of a short address", "GPRM");
+}
+
+
+void testChecksum() {
+  const string gsa = withChecksum("GNGSA,A,3,80,71,73,79,69,,,,,,,,1.83,1.09,1.47");
+  uint8_t parity;
+  check(streamOk(gsa, &parity), "NmeaChecksum of a valid sentence", gsa);
+  NmeaSentence s;
+  parse(s, gsa);
+  check(parity == s.getParity(), "NmeaChecksum parity matches parse()", gsa);
+
+  // A '$' starts again, as the GPS ingest sees a sentence cut short by a lost byte,
+  // but not once the checksum has started.
+  check(streamOk("$GPGGA,1234" + gsa), "NmeaChecksum restarts at '$'", gsa);
+  check(!streamOk("$GPGGA,1234*" + gsa), "NmeaChecksum '$' in the checksum", gsa);
+  check(!streamOk("$GPGGA,1"), "NmeaChecksum of a sentence in progress", "$GPGGA,1");
+  check(streamOk(gsa + "$GPGGA,1*00"), "NmeaChecksum ignores text after the terminator", gsa);
+
+  // Reset between sentences.
+  NmeaChecksum chk;
+  chk.reset();
+  check(!chk.isOk(), "NmeaChecksum after reset", "");
+  for (char ch : gsa) {
+    chk.update(ch);
+  }
+  chk.reset();
+  check(!chk.isOk() && chk.getParity() == 0, "NmeaChecksum reset clears the sentence", gsa);
+}
+
+
+/*
+ * Corrupt valid sentences at random and check that NmeaChecksum, the kernels and parse() agree.
+ */
+void testRandom(unsigned long count, unsigned long seed) {
+  static const char * const bodies[] = {
+    "GPGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,",
+    "GNRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A",
+    "GPGSV,3,1,10,23,38,230,44,29,71,156,47,07,29,116,41,08,09,081,36",
+    "GPTXT,01,01,02,ANTSTATUS=OK",
+    "PUBX,00,081350.00,4717.113210,N,00833.915187,E,546.589,G3,2.1,2.0,0.007,77.52,0.007,,0.92,1.19,0.77,9,0,0",
+  };
+  static const char specials[] = "$*,\r\n0aF";
+  mt19937 rnd(seed);
+  unsigned long before = errCnt;
+  for (unsigned long n = 0; n < count; n++) {
+    string text = withChecksum(bodies[rnd() % (sizeof(bodies) / sizeof(bodies[0]))], rnd() % 4 ? "\r\n" : "");
+    int edits = rnd() % 3;
+    for (int e = 0; e < edits && !text.empty(); e++) {
+      size_t pos = rnd() % text.size();
+      char ch = rnd() % 2 ? specials[rnd() % (sizeof(specials) - 1)] : (char) (rnd() % 256);
+      switch (rnd() % 3) {
+        case 0: text[pos] = ch; break;
+        case 1: text.insert(pos, 1, ch); break;
+        default: text.erase(pos, 1); break;
+      }
+    }
+    NmeaSentence s;
+    uint8_t parity;
+    bool ok = parse(s, text) == NmeaOk;
+    check(streamOk(text, &parity) == ok, "Random: NmeaChecksum and parse() disagree", text);
+    if (s.getStatus() != NmeaNoStart && s.getStatus() != NmeaTooLong) {
+      check(parity == s.getParity(), "Random: parity differs", text);
+    }
+    checkKernels(s, text, "Random");
+  }
+  cout << "Random sentences: " << count << ", failures: " << errCnt - before << endl;
+}
+
+
+int main(int argc, char * argv[]) {
+  unsigned long count = 100000;
+  unsigned long seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      count = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 10);
+    } else {
+      cerr << "nmeatest v" VERSION << endl;
+      cerr << "Usage: nmeatest [-n count] [--seed n]" << endl;
+      return 1;
+    }
+  }
+
+  testParse();
+  testClassify();
+  testChecksum();
+  testRandom(count, seed);
+
+  cout << "Checks: " << checkCnt << ", failures: " << errCnt << endl;
+  return errCnt == 0 ? 0 : 1;
+}
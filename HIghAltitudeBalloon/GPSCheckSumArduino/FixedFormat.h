@@ -0,0 +1,214 @@
+#ifndef _FIXEDFORMAT_H
+#define _FIXEDFORMAT_H
+
+/*
+ * Integer only number formatting.
+ *
+ * A number with a fractional part is given as a scaled integer: value / 10^scale
+ * (e.g. a latitude of -33.800012 is -33800012 with a scale of 6), so no floating point
+ * (and no printf float support) is needed. Converting a double to a scaled integer is
+ * left to the caller, e.g. lround(lat * 1000000.0), as the binary $HAB record does.
+ * When fewer decimal places are printed than the value holds, it is rounded half away
+ * from zero using the discarded digits, so the result is exact.
+ *
+ * Numbers are appended to a caller supplied buffer through an FmtCursor, which keeps
+ * the end of the text so nothing is rescanned, and never writes past the end of the
+ * buffer. Text that does not fit is cut short and the cursor is marked as truncated.
+ * The text is always null terminated.
+ *
+ * A width right justifies the number with a fill character. A '0' fill goes after the
+ * sign, as printf's "%05d" does. A separator (e.g. ',') is placed between each group of
+ * three digits of the integer part.
+ *
+ * This file is shared by the logger, the SD console and the host side tools, so it
+ * must not depend upon Arduino.h. On AVR, 16 bit division is used once the value is
+ * small enough, as 32 bit division is several times slower.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Largest scale (decimal places) of a value.
+#define FMT_MAX_SCALE   9
+// Enough for the digits and separators of any 32 bit value.
+#define FMT_DIGIT_BUF   16
+
+
+/* Return 10^n, for n up to FMT_MAX_SCALE. */
+inline uint32_t fmtPow10(uint8_t n) {
+  static const uint32_t pow10[FMT_MAX_SCALE + 1] = {
+    1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+  };
+  return pow10[n <= FMT_MAX_SCALE ? n : FMT_MAX_SCALE];
+}
+
+
+/*
+ * Write the decimal digits of v backwards, ending just before end, with leading zeros
+ * to make at least minDigits. Return the number of digits written.
+ */
+inline uint8_t fmtDigits(char * end, uint32_t v, uint8_t minDigits) {
+  char * p = end;
+  while (v > 0xFFFFUL) {
+    uint32_t q = v / 10;
+    *--p = '0' + (char) (v - q * 10);
+    v = q;
+  }
+  uint16_t w = (uint16_t) v;
+  do {
+    uint16_t q = w / 10;
+    *--p = '0' + (char) (w - q * 10);
+    w = q;
+  } while (w);
+  while (end - p < minDigits) {
+    *--p = '0';
+  }
+  return (uint8_t) (end - p);
+}
+
+
+class FmtCursor {
+  public:
+    /*
+     * Start appending at buf. size includes the null terminator, so must be at least 1.
+     */
+    FmtCursor(char * buf, size_t size) : start(buf), pos(buf), last(buf + size - 1), truncated(false) {
+      *pos = '\0';
+    }
+
+    FmtCursor & appendChar(char ch) {
+      if (pos < last) {
+        *pos++ = ch;
+        *pos = '\0';
+      } else {
+        truncated = true;
+      }
+      return *this;
+    }
+
+    FmtCursor & appendText(const char * text) {
+      while (*text && pos < last) {
+        *pos++ = *text++;
+      }
+      terminate(*text != '\0');
+      return *this;
+    }
+
+    FmtCursor & appendText(const char * text, size_t len) {
+      while (len > 0 && pos < last) {
+        *pos++ = *text++;
+        len--;
+      }
+      terminate(len > 0);
+      return *this;
+    }
+
+    FmtCursor & appendUnsigned(uint32_t value, uint8_t width = 0, char fill = ' ', char sep = '\0') {
+      return appendNumber(false, value, 0, 0, width, fill, sep);
+    }
+
+    FmtCursor & appendSigned(int32_t value, uint8_t width = 0, char fill = ' ', char sep = '\0') {
+      return appendNumber(value < 0, magnitude(value), 0, 0, width, fill, sep);
+    }
+
+    /*
+     * Append value / 10^scale with dp decimal places.
+     */
+    FmtCursor & appendFixed(int32_t value, uint8_t scale, uint8_t dp, uint8_t width = 0, char fill = ' ', char sep = '\0') {
+      uint32_t mag = magnitude(value);
+      if (scale > FMT_MAX_SCALE) {
+        scale = FMT_MAX_SCALE;
+      }
+      if (dp < scale) {
+        uint32_t divisor = fmtPow10(scale - dp);
+        uint32_t rem = mag % divisor;
+        mag /= divisor;
+        if (rem >= divisor - rem) {
+          mag++;                  // Half or more, away from zero.
+        }
+        scale = dp;
+      }
+      return appendNumber(value < 0, mag, scale, dp - scale, width, fill, sep);
+    }
+
+    /*
+     * Append a time of day as h:mm:ss.
+     */
+    FmtCursor & appendTime(uint8_t hour, uint8_t minute, uint8_t second) {
+      appendUnsigned(hour).appendChar(':');
+      appendUnsigned(minute, 2, '0').appendChar(':');
+      return appendUnsigned(second, 2, '0');
+    }
+
+    /*
+     * Append the separator between the fields of a record.
+     */
+    FmtCursor & appendSeparator(char sep = ',') {
+      return appendChar(sep);
+    }
+
+    const char * getText() const { return start; }
+    size_t getLength() const { return pos - start; }
+    bool isTruncated() const { return truncated; }
+
+  private:
+    static uint32_t magnitude(int32_t value) {
+      return value < 0 ? 0UL - (uint32_t) value : (uint32_t) value;
+    }
+
+    void terminate(bool cut) {
+      *pos = '\0';
+      truncated |= cut;
+    }
+
+    /*
+     * Append mag, which has scale decimal places, followed by zeroCnt zeros.
+     */
+    FmtCursor & appendNumber(bool negative, uint32_t mag, uint8_t scale, uint8_t zeroCnt, uint8_t width, char fill, char sep) {
+      char digits[FMT_DIGIT_BUF];
+      char * end = digits + sizeof(digits);
+      uint8_t digitCnt = fmtDigits(end, mag, scale + 1);
+      uint8_t intCnt = digitCnt - scale;
+      uint8_t sepCnt = sep ? (intCnt - 1) / 3 : 0;
+      unsigned int len = negative + intCnt + sepCnt + (scale + zeroCnt > 0 ? 1 + scale + zeroCnt : 0);
+
+      if (fill != '0') {
+        padTo(len, width, fill);
+      }
+      if (negative) {
+        appendChar('-');
+      }
+      if (fill == '0') {
+        padTo(len, width, fill);
+      }
+      const char * p = end - digitCnt;
+      for (uint8_t i = intCnt; i > 0; i--) {
+        appendChar(*p++);
+        if (sepCnt && i > 1 && (i - 1) % 3 == 0) {
+          appendChar(sep);
+        }
+      }
+      if (scale + zeroCnt > 0) {
+        appendChar('.');
+        appendText(p, scale);
+        while (zeroCnt--) {
+          appendChar('0');
+        }
+      }
+      return *this;
+    }
+
+    void padTo(unsigned int len, uint8_t width, char fill) {
+      while (len < width) {
+        appendChar(fill);
+        len++;
+      }
+    }
+
+    char * start;
+    char * pos;
+    char * last;              // Where the null terminator goes when the buffer is full.
+    bool truncated;
+};
+
+#endif
@@ -4,6 +4,29 @@
  * By: G. McCall
  *     May 2024
  *
+ *  v1.06.00.00 17-10-2026
+ *    * Added the get command, which sends a file to the host as CRC checked
+ *      binary frames with windowed acknowledgements (HabXfer.h). A transfer
+ *      can be resumed from an offset. See GPSCheckSum/habget.
+ *
+ *  v1.05.00.00 17-10-2026
+ *    * head, cat and chk read the file in whole sectors through a shared
+ *      line scanner (LineScanner.h) instead of fgets. Lines longer than the
+ *      old 500 and 200 byte line buffers are no longer split, and the read
+ *      rate (KB/s) is shown at the end of each command.
+ *
+ *  v1.04.00.00 17-10-2026
+ *    * Added the fmt command, which times the integer number formatting
+ *      (FixedFormat.h) against dtostrf on the device.
+ *
+ *  v1.03.00.00 17-10-2026
+ *    * Added the idx and range commands, which use a sidecar index (HabIndex.h)
+ *      to print the records of a type and/or time range without reading the
+ *      whole log.
+ *
+ *  v1.02.00.00 17-10-2026
+ *    * Checksums are verified by the shared NMEA tokenizer (Nmea.h).
+ *
  *  v1.01.00.00 28-05-2024
  *    * Added ability to submit a sentence for checksum verification
  *      via the Console.
@@ -13,13 +36,18 @@
  */
 
 
-#define VERSION "v1.01.01.00"
+#define VERSION "v1.06.00.00"
 
 // Baud rate of the Serial (PC USB connection) device.
 #define CONSOLE_BAUD 115200
 
 #include "Buffer.h"
 #include "utility.h"
+#include "Nmea.h"
+#include "HabIndex.h"
+#include "FixedFormat.h"
+#include "LineScanner.h"
+#include "HabXfer.h"
 
 
 #include <SdFat.h>
@@ -43,18 +71,22 @@ bool echoConsoleInput = true;
 SdFat sd;
 File file;
 File root;
+File idxFile;
 #elif SD_FAT_TYPE == 1
 SdFat32 sd;
 File32 file;
 File32 root;
+File32 idxFile;
 #elif SD_FAT_TYPE == 2
 SdExFat sd;
 ExFile file;
 ExFile root;
+ExFile idxFile;
 #elif SD_FAT_TYPE == 3
 SdFs sd;
 FsFile file;
 FsFile root;
+FsFile idxFile;
 #endif  // SD_FAT_TYPE
 
 
@@ -109,6 +141,34 @@ void ls(const char * cmd, const char *tokens[], int tokenCnt) {
   listFiles(currDir);
 }
 
+/************************************
+ * File scanning
+ ************************************/
+
+// Buffer that head, cat and chk read a file into (see LineScanner.h).
+#if defined(__AVR__)
+#define LINE_SCAN_SIZE (2 * LINE_SCAN_BLOCK)
+#else
+#define LINE_SCAN_SIZE (8 * LINE_SCAN_BLOCK)
+#endif
+
+char lineScanBuf[LINE_SCAN_SIZE];
+
+
+/*
+ * Print the amount of a file read by a command and the rate it was read at.
+ */
+void printThroughput(uint32_t bytes, uint32_t ms) {
+  Serial.print(F("Read ")); Serial.print(bytes); Serial.print(F(" bytes in "));
+  Serial.print(ms); Serial.print(F(" ms ("));
+  Serial.print(ms > 0 ? bytes / 1.024 / ms : 0.0, 1);
+  Serial.println(F(" KB/s)"));
+}
+
+
+/*
+ * Print a file, or the first headSize lines of it (0 = all of it).
+ */
 void outputFile(const char * fileName, unsigned long headSize) {
 
   if (!file.open(fileName, FILE_READ)) {
@@ -116,24 +176,24 @@ void outputFile(const char * fileName, unsigned long headSize) {
     return;
   }
 
-  char inLine[500];
-  unsigned long lineNo = 0;
-
-  while (file.available() && ((headSize > 0 && lineNo < headSize) || headSize == 0)) {
-    int n = file.fgets(inLine, sizeof(inLine));
-    if (n <= 0) {
-      Serial.println("Error reading file");
-    }
-    lineNo++;
-    if (inLine[n - 1] != '\n' && n == (sizeof(inLine) - 1)) {
-      Serial.println("Line too long:");
-      Serial.println(inLine);
-    } else {
-      Serial.print(inLine);
+  uint32_t startMs = millis();
+  LineScanner lines(lineScanBuf, sizeof(lineScanBuf));
+  bool lineEnded = true;
+  while (lines.next(file)) {
+    if (headSize > 0 && lines.getLineNo() > headSize) {
+      break;
     }
+    Serial.write(lines.getText(), lines.getLength());
+    lineEnded = lines.getText()[lines.getLength() - 1] == '\n';
+  }
+  if (!lineEnded) {
+    Serial.println();
+  }
+  if (lines.isReadError()) {
+    Serial.println("Error reading file");
   }
-
   file.close();
+  printThroughput(lines.getBytesRead(), millis() - startMs);
 }
 
 
@@ -169,64 +229,16 @@ void catFile(const char * cmd, char const *tokens[], int tokenCnt) {
 
 
 
-/* Convert a hexadecimal character to an integer. */
-unsigned int hextoint(const char digit) {
-  const char lookup [] = "0123456789ABCDEF";
-  char ch = toupper(digit);
-  unsigned int result = 0;
-
-  for (result = 0; result < sizeof(lookup); result++) {
-    if (lookup[result] == ch) {
-      break;
-    }
-  }
-  return result;
-}
-
-
 /*
- * Calculate and check the checksum in the GPS sentence
- * Return 0 if checksum is correct, or
- *        the checksum that the record *should* contain (but does not).
+ * Calculate and check the checksum in the GPS sentence.
+ * Return the result of the check. expected is set to the checksum that the
+ * sentence should contain.
  */
-unsigned int chkSentence(const char * sentence) {
-  const char * p = sentence;
-
-  unsigned int parity = 0;
-  unsigned int chksum = 0;
-  bool isCheckSumTerm = false;
-  while (*p) {
-    switch (*p) {
-      case '$' :        // Start of sentence.
-        parity = 0;
-        isCheckSumTerm = false;
-        break;
-      case '*':         // End of data, start of checksum.
-        isCheckSumTerm = true;
-        chksum = 0;
-        break;
-      case '\n':
-      case '\r':
-        break;
-      default:          // regular data character, so simply process it.
-        if (!isCheckSumTerm) {
-          parity ^= (unsigned int) *p;
-        } else {
-          chksum = (chksum << 4) | hextoint(*p);
-        }
-        break;
-    }
-    p++;
-  }
-//  cout << endl << uppercase << hex << "Parity: " << parity << " checksum: " << chksum << dec << endl;
- 
-  if (parity != chksum) {
-    return parity;
-  } else if (!isCheckSumTerm) {
-    return -1;
-  } else {
-    return 0;
-  }
+NmeaStatus chkSentence(const char * sentence, size_t len, uint8_t & expected) {
+  NmeaSentence nmea;
+  NmeaStatus status = nmea.parse(sentence, len);
+  expected = nmea.getParity();
+  return status;
 }
 
 
@@ -247,8 +259,6 @@ void chkFile(const char * cmd, char const *tokens[], int tokenCnt) {
   }
 
 
-  char inLine[200];
-  unsigned long lineNo = 0;
   unsigned long errCnt = 0;
 
   if (!file.open(fileName, FILE_READ)) {
@@ -256,49 +266,56 @@ void chkFile(const char * cmd, char const *tokens[], int tokenCnt) {
     return;
   }
 
-  while (file.available()) {
-    int n = file.fgets(inLine, sizeof(inLine));
-    if (n <= 0) {
-      Serial.println("Error reading file");
-      continue;
-    }
-    if (lineNo++ < headSize) {  // Skip the first n lines.
-      continue;
+  uint32_t startMs = millis();
+  LineScanner lines(lineScanBuf, sizeof(lineScanBuf));
+  while (lines.next(file)) {
+    unsigned long lineNo = lines.getLineNo();
+    if (lineNo <= headSize || lines.isContinued()) {
+      continue;         // Skip the first n lines, and the rest of a line that is too long.
     }
-    if (strncmp("$HAB", inLine, 4) == 0) {
+    const char * text = lines.getText();
+    size_t len = lines.getLength();
+    if (len >= 4 && strncmp("$HAB", text, 4) == 0) {
       continue;         // Skip the $HAB records.
     }
-    if (inLine[n - 1] != '\n' && n == (sizeof(inLine) - 1)) {
-      Serial.print("line "); Serial.print(lineNo); Serial.println(" too long:");
-      Serial.println(inLine);
+    if (!lines.isComplete()) {
+      Serial.print("line "); Serial.print(lineNo); Serial.println(" too long");
+      errCnt++;
+      continue;
     }
 
-    unsigned int checksum = chkSentence(inLine);
-    if (checksum != 0) {
+    uint8_t checksum;
+    if (chkSentence(text, len, checksum) != NmeaOk) {
       Serial.print(lineNo); Serial.print(": ");
-      Serial.print(inLine);
+      Serial.write(text, len);
       Serial.print("*** invalid checskum. Should be: 0x"); Serial.println(checksum, HEX);
       Serial.println();
       errCnt++;
     }
   }
+  if (lines.isReadError()) {
+    Serial.println("Error reading file");
+  }
 
   file.close();
 
+  unsigned long lineNo = lines.getLineNo();
   Serial.print("Lines checked: "); Serial.println(lineNo);
   Serial.print("Checksum errors: "); Serial.println(errCnt);
   if (lineNo > 0) {
     Serial.print("Percentage error: "); Serial.print((double) errCnt / (double)(lineNo) * 100.0); Serial.println("%");
   }
+  printThroughput(lines.getBytesRead(), millis() - startMs);
 }
 
 
 void validateSentence(const char * sentence) {
     Serial.println(sentence);
-    unsigned int checksum = chkSentence(sentence);
-    if (checksum == 0xffffffff) {
+    uint8_t checksum;
+    NmeaStatus status = chkSentence(sentence, strlen(sentence), checksum);
+    if (status == NmeaNoChecksum) {
       Serial.println(F("*** GPS sentence does not seem to include a checksum sequence"));
-    } else if (checksum != 0) {
+    } else if (status != NmeaOk) {
       Serial.print(F("*** invalid checskum. Should be: 0x")); Serial.println(checksum, HEX);
       Serial.println();
     } else {
@@ -307,6 +324,395 @@ void validateSentence(const char * sentence) {
 }
 
 
+/************************************
+ * Log index
+ ************************************/
+
+// Size of the blocks read from the SD card when scanning a log.
+#define SCAN_BLOCK_SIZE 512
+
+// Longest part of a text record that is printed by the range command.
+#define MAX_RANGE_LINE 200
+
+
+/*
+ * Scan a log and write its index (see HabIndex.h).
+ * The header is written last, so an index that was not completed is not used.
+ * Return true if the index was written, in which case header is that of the new index.
+ */
+bool buildIndex(const char * fileName, const char * idxName, HabIndexHeader & header) {
+  if (!file.open(fileName, FILE_READ)) {
+    Serial.print("Failed to open: "); Serial.println(fileName);
+    return false;
+  }
+  if (!idxFile.open(idxName, O_WRONLY | O_CREAT | O_TRUNC)) {
+    Serial.print("Failed to create: "); Serial.println(idxName);
+    file.close();
+    return false;
+  }
+
+  HabLogScanner scanner;
+  HabIndexBuilder builder;
+  HabIndexEntry entry;
+  memset(&header, 0, sizeof(header));
+  idxFile.write(&header, sizeof(header));     // Placeholder until the header is known.
+
+  uint8_t block[SCAN_BLOCK_SIZE];
+  int n;
+  while ((n = file.read(block, sizeof(block))) > 0) {
+    for (int i = 0; i < n; i++) {
+      if (scanner.put(block[i]) && builder.add(scanner.getRecord(), entry)) {
+        idxFile.write(&entry, sizeof(entry));
+      }
+    }
+  }
+  if (scanner.finish() && builder.add(scanner.getRecord(), entry)) {
+    idxFile.write(&entry, sizeof(entry));
+  }
+  file.close();
+
+  header = builder.getHeader();
+  idxFile.seekSet(0);
+  bool ok = idxFile.write(&header, sizeof(header)) == sizeof(header);
+  idxFile.close();
+  return ok;
+}
+
+
+/*
+ * Open the index of a log, building it first if it is missing or out of date.
+ * On success idxFile is positioned at the first entry.
+ */
+bool openIndex(const char * fileName, HabIndexHeader & header) {
+  char idxName[80];
+  habIndexFileName(fileName, idxName, sizeof(idxName));
+
+  if (!file.open(fileName, FILE_READ)) {
+    Serial.print("Failed to open: "); Serial.println(fileName);
+    return false;
+  }
+  uint32_t logSize = file.size();
+  file.close();
+
+  if (idxFile.open(idxName, FILE_READ)) {
+    if (idxFile.read(&header, sizeof(header)) == sizeof(header) && habIndexIsCurrent(header, logSize)) {
+      return true;
+    }
+    idxFile.close();
+  }
+
+  Serial.print("Building "); Serial.println(idxName);
+  if (!buildIndex(fileName, idxName, header) || !idxFile.open(idxName, FILE_READ)) {
+    return false;
+  }
+  idxFile.seekSet(sizeof(header));
+  return true;
+}
+
+
+/*
+ * idx file
+ * Build the index of a log and list the record types that it holds.
+ */
+void indexFile(const char * cmd, char const *tokens[], int tokenCnt) {
+  if (tokenCnt != 2) {
+    Serial.println("Error, specify one file only.");
+    return;
+  }
+  char idxName[80];
+  habIndexFileName(tokens[1], idxName, sizeof(idxName));
+
+  unsigned long startMs = millis();
+  HabIndexHeader header;
+  if (!buildIndex(tokens[1], idxName, header)) {
+    return;
+  }
+  Serial.print(idxName); Serial.print(": ");
+  Serial.print(header.entryCnt); Serial.print(" entries for ");
+  Serial.print(header.logSize); Serial.print(" bytes in ");
+  Serial.print(millis() - startMs); Serial.println(" ms");
+  Serial.print("Types:");
+  for (int i = 0; i < header.typeCnt; i++) {
+    Serial.print(" "); Serial.print(header.typeNames[i]);
+  }
+  Serial.println();
+}
+
+
+/*
+ * Parse a time given as h:mm[:ss]. Return HAB_IDX_NO_TIME if it is invalid.
+ */
+int32_t parseRangeTime(const char * text) {
+  int32_t parts[3] = { 0, 0, 0 };
+  int partCnt = 0;
+  for (const char * p = text; *p; p++) {
+    if (*p == ':' && partCnt < 2) {
+      partCnt++;
+    } else if (isdigit(*p)) {
+      parts[partCnt] = parts[partCnt] * 10 + (*p - '0');
+    } else {
+      return HAB_IDX_NO_TIME;
+    }
+  }
+  if (partCnt == 0 || parts[1] > 59 || parts[2] > 59) {
+    return HAB_IDX_NO_TIME;
+  }
+  return parts[0] * 3600L + parts[1] * 60L + parts[2];
+}
+
+
+/*
+ * Print a record found by the range command. Binary records are summarised.
+ */
+void printRangeRecord(const HabLogRecord & rec, const char * text, int textLen) {
+  if (rec.binary) {
+    Serial.print(rec.lineNo); Serial.print(": binary $HAB record, ");
+    Serial.print(rec.length); Serial.println(" bytes");
+    return;
+  }
+  Serial.write(text, textLen);
+  if (textLen < (int) rec.length) {
+    Serial.println(" ...");
+  }
+}
+
+
+/*
+ * range file type|* [from [to]]
+ * Print the records of a type (* for all) between two UTC times (h:mm[:ss]).
+ * The index is used to start reading the log at the first record of interest.
+ */
+void rangeFile(const char * cmd, char const *tokens[], int tokenCnt) {
+  if (tokenCnt < 3 || tokenCnt > 5) {
+    Serial.println("Error, specify a file, a record type (or *) and an optional time range.");
+    return;
+  }
+  const char * fileName = tokens[1];
+  const char * typeName = strcmp(tokens[2], "*") == 0 ? NULL : tokens[2];
+  int32_t from = tokenCnt >= 4 ? parseRangeTime(tokens[3]) : HAB_IDX_NO_TIME;
+  int32_t to = tokenCnt >= 5 ? parseRangeTime(tokens[4]) : INT32_MAX;
+  if ((tokenCnt >= 4 && from == HAB_IDX_NO_TIME) || to == HAB_IDX_NO_TIME) {
+    Serial.println("Error, times are h:mm[:ss].");
+    return;
+  }
+
+  HabIndexHeader header;
+  if (!openIndex(fileName, header)) {
+    return;
+  }
+  int type = -1;
+  if (typeName) {
+    for (int i = 0; i < header.typeCnt; i++) {
+      if (strncmp(header.typeNames[i], typeName, HAB_IDX_TYPE_LEN) == 0) {
+        type = i;
+      }
+    }
+    if (type < 0) {
+      Serial.print("No "); Serial.print(typeName); Serial.println(" records.");
+      idxFile.close();
+      return;
+    }
+  }
+
+  HabIndexRange range(header, type, from, to);
+  HabIndexEntry entry;
+  while (!range.ended && idxFile.read(&entry, sizeof(entry)) == sizeof(entry)) {
+    range.add(entry);
+  }
+  idxFile.close();
+  if (!range.found) {
+    Serial.println("No records in that range.");
+    return;
+  }
+
+  if (!file.open(fileName, FILE_READ) || !file.seekSet(range.startOffset)) {
+    Serial.print("Failed to open: "); Serial.println(fileName);
+    return;
+  }
+
+  HabLogScanner scanner;
+  scanner.reset(range.startOffset, range.startLineNo, range.startTime);
+  char text[MAX_RANGE_LINE];
+  int textLen = 0;
+  unsigned long recCnt = 0;
+  uint32_t offset = range.startOffset;
+  uint8_t block[SCAN_BLOCK_SIZE];
+  int n = 0;
+  bool done = false;
+  while (!done && (n = file.read(block, sizeof(block))) > 0) {
+    for (int i = 0; i < n; i++, offset++) {
+      if (range.ended && offset >= range.endOffset) {
+        done = true;
+        break;
+      }
+      if (textLen < (int) sizeof(text)) {
+        text[textLen++] = block[i];
+      }
+      if (scanner.put(block[i])) {
+        if (range.matches(scanner.getRecord(), typeName)) {
+          printRangeRecord(scanner.getRecord(), text, textLen);
+          recCnt++;
+        }
+        textLen = 0;
+      }
+    }
+  }
+  if (!done && scanner.finish() && range.matches(scanner.getRecord(), typeName)) {
+    printRangeRecord(scanner.getRecord(), text, textLen);
+    Serial.println();
+    recCnt++;
+  }
+  file.close();
+
+  Serial.print("Records: "); Serial.print(recCnt);
+  Serial.print(" from line "); Serial.println(range.startLineNo);
+}
+
+
+/************************************
+ * File transfer
+ ************************************/
+
+// Data sent before it must be acknowledged (see HabXfer.h).
+#if defined(__AVR__)
+#define XFER_WINDOW (2 * LINE_SCAN_SIZE)
+#else
+#define XFER_WINDOW (8 * LINE_SCAN_SIZE)
+#endif
+
+
+/*
+ * get file [offset]
+ * Send a file, from offset, to the host receiver (GPSCheckSum/habget) as CRC checked
+ * binary frames (see HabXfer.h), rather than as text. The frames are built in the
+ * line scanning buffer. Nothing else is printed until the transfer is over.
+ */
+void getFile(const char * cmd, char const *tokens[], int tokenCnt) {
+  if (tokenCnt < 2 || tokenCnt > 3 || (tokenCnt == 3 && !isNumeric(tokens[2]))) {
+    Serial.println("Error, specify a file and an optional offset.");
+    return;
+  }
+  const char * fileName = tokens[1];
+  uint32_t offset = tokenCnt == 3 ? strtoul(tokens[2], NULL, 10) : 0;
+
+  HabXferSender<decltype(Serial), decltype(file)> sender(Serial, file, (uint8_t *) lineScanBuf, sizeof(lineScanBuf), XFER_WINDOW);
+  if (!file.open(fileName, FILE_READ)) {
+    sender.fail("Failed to open");
+    Serial.println();
+    Serial.print("Failed to open: "); Serial.println(fileName);
+    return;
+  }
+
+  uint32_t startMs = millis();
+  uint32_t size = file.fileSize();
+  sender.start(offset, size, startMs);
+  while (sender.poll(millis())) {
+  }
+  file.close();
+  uint32_t ms = millis() - startMs;
+
+  Serial.println();
+  switch (sender.getResult()) {
+    case HabXferOk:         Serial.print("Sent: "); break;
+    case HabXferCancelled:  Serial.print("Cancelled: "); break;
+    case HabXferTimedOut:   Serial.print("Timed out: "); break;
+    default:                Serial.print("Read error: "); break;
+  }
+  Serial.print(fileName);
+  Serial.print(" CRC-32: 0x"); Serial.print(sender.getFileCrc(), HEX);
+  Serial.print(" resent: "); Serial.println(sender.getResentCnt());
+  printThroughput(offset < size ? size - offset : 0, ms);
+}
+
+
+/************************************
+ * Formatting benchmark
+ ************************************/
+
+// Values formatted by the fmt command, unless a count is given.
+#define FMT_BENCH_CNT 1000
+
+// Keeps the formatted lengths, so the formatting is not optimised away.
+volatile unsigned long fmtBenchSink = 0;
+
+/*
+ * Print the cost of one field, in us and CPU cycles.
+ */
+void printFmtBench(const char * name, unsigned long us, unsigned long cnt) {
+  Serial.print(F("  "));
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print((double) us / cnt, 2);
+  Serial.print(F(" us, "));
+  Serial.print((double) us * (F_CPU / 1000000UL) / cnt, 0);
+  Serial.println(F(" cycles/field"));
+}
+
+
+/*
+ * Measure the cost of formatting $HAB record fields on this processor with the integer
+ * formatting (FixedFormat.h) and with the library's floating point dtostrf().
+ * GPSCheckSum/fmtbench.cpp checks the formatting against printf and times it on the host.
+ * command:
+ *   fmt [n]         -> format n values of each kind (n = FMT_BENCH_CNT).
+ */
+void fmtBench(const char * cmd, char const *tokens[], int tokenCnt) {
+  unsigned long cnt = FMT_BENCH_CNT;
+  if (tokenCnt == 2 && isNumeric(tokens[1]) && atol(tokens[1]) > 0) {
+    cnt = atol(tokens[1]);
+  }
+  char buf[24];
+  unsigned long startUs;
+
+  Serial.print(F("Formatting ")); Serial.print(cnt); Serial.println(F(" values:"));
+
+  startUs = micros();
+  for (unsigned long i = 0; i < cnt; i++) {
+    FmtCursor out(buf, sizeof(buf));
+    out.appendFixed(-33800012L - (int32_t) i, 6, 6);
+    fmtBenchSink += out.getLength();
+  }
+  printFmtBench("fixed lat (6 dp)", micros() - startUs, cnt);
+
+  startUs = micros();
+  for (unsigned long i = 0; i < cnt; i++) {
+    dtostrf(-33.800012 - i * 0.000001, 1, 6, buf);
+    fmtBenchSink += buf[0];
+  }
+  printFmtBench("dtostrf lat", micros() - startUs, cnt);
+
+  startUs = micros();
+  for (unsigned long i = 0; i < cnt; i++) {
+    fmtBenchSink += rightJustifyF(buf, 12, -33.800012 - i * 0.000001, 6)[0];
+  }
+  printFmtBench("rightJustifyF lat", micros() - startUs, cnt);
+
+  startUs = micros();
+  for (unsigned long i = 0; i < cnt; i++) {
+    FmtCursor out(buf, sizeof(buf));
+    out.appendFixed(3504321L + (int32_t) i, 2, 2);
+    fmtBenchSink += out.getLength();
+  }
+  printFmtBench("fixed alt (2 dp)", micros() - startUs, cnt);
+
+  startUs = micros();
+  for (unsigned long i = 0; i < cnt; i++) {
+    dtostrf(35043.21 + i * 0.01, 1, 2, buf);
+    fmtBenchSink += buf[0];
+  }
+  printFmtBench("dtostrf alt", micros() - startUs, cnt);
+
+  startUs = micros();
+  for (unsigned long i = 0; i < cnt; i++) {
+    FmtCursor out(buf, sizeof(buf));
+    out.appendUnsigned(i * 7);
+    fmtBenchSink += out.getLength();
+  }
+  printFmtBench("unsigned count", micros() - startUs, cnt);
+}
+
+
+
 /************************************
  * Command Processing
  ************************************/
@@ -326,6 +732,22 @@ void usage() {
 
   Serial.println(F("  $sentence*chk   Verify the checksum of the provided GPS sentence."));
 
+  Serial.println();
+
+  Serial.println(F("  idx file        Build the index of a log (file.idx)."));
+  Serial.println(F("  range file type|* [from [to]]"));
+  Serial.println(F("                  Print the records of a type (* = all) between"));
+  Serial.println(F("                  two UTC times (h:mm[:ss]). The index is built"));
+  Serial.println(F("                  if needed. After midnight, times continue at 24:00."));
+
+  Serial.println();
+  Serial.println(F("  get file [offset]"));
+  Serial.println(F("                  Send the file from offset (0) as binary frames"));
+  Serial.println(F("                  to the host receiver (GPSCheckSum/habget)."));
+
+  Serial.println();
+  Serial.println(F("  fmt [n]         Time the number formatting (n values of each kind)."));
+
   Serial.println();
   Serial.println(F("  echo on|off     set command echo."));
   Serial.println(F("  help|usage      show commands."));
@@ -458,6 +880,14 @@ void processConsoleCommand(const char *cmd) {
     catFile(cmd, tokens, tokenCount);
   } else if (stricmp(tokens[0], "chk") == 0) {
     chkFile(cmd, tokens, tokenCount);
+  } else if (stricmp(tokens[0], "idx") == 0) {
+    indexFile(cmd, tokens, tokenCount);
+  } else if (stricmp(tokens[0], "range") == 0) {
+    rangeFile(cmd, tokens, tokenCount);
+  } else if (stricmp(tokens[0], "get") == 0) {
+    getFile(cmd, tokens, tokenCount);
+  } else if (stricmp(tokens[0], "fmt") == 0) {
+    fmtBench(cmd, tokens, tokenCount);
   } else if (stricmp(tokens[0], "help") == 0 || strcmp(tokens[0], "usage") == 0) {
     usage();
   } else {
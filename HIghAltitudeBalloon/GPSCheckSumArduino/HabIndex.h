@@ -0,0 +1,421 @@
+#ifndef _HABINDEX_H
+#define _HABINDEX_H
+
+/*
+ * Sidecar index for hab log files.
+ *
+ * The index (habNNNN.idx next to habNNNN.log) records, for each record type and each
+ * UTC time bucket, the byte offset and line number of the first such record. A reader
+ * can then seek straight to a time range or record type rather than read the whole log.
+ *
+ * Index layout:
+ *   HabIndexHeader              - including the record type names.
+ *   HabIndexEntry[entryCnt]     - in log file order.
+ *
+ * Time is seconds since 00:00 UTC on the day the log started. A flight that crosses
+ * midnight continues past 86400, so that the time always increases.
+ *
+ * This file is shared by GPSCheckSumArduino and the host side tools, so it must not
+ * depend upon Arduino.h. The host tools include it from here.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "HabRecord.h"
+
+#define HAB_IDX_MAGIC       "HIDX"
+#define HAB_IDX_VERSION     1
+#define HAB_IDX_EXT         "idx"
+
+#define HAB_IDX_MAX_TYPES   16      // Record types that are indexed, any others share one entry.
+#define HAB_IDX_TYPE_LEN    8       // Including the null, e.g. "$GPGGA".
+#define HAB_IDX_OTHER_TYPE  "?"     // Records that are not NMEA sentences, or once the table is full.
+#define HAB_IDX_NO_TIME     (-1)    // A record before the first time in the log.
+#define HAB_IDX_DEFAULT_BUCKET 60   // Seconds.
+
+// Number of characters of a text line that are kept to find its type and time.
+#define HAB_IDX_PREFIX_LEN  24
+
+
+struct HabIndexHeader {
+  char     magic[4];
+  uint8_t  version;
+  uint8_t  typeCnt;
+  uint16_t bucketSecs;
+  uint32_t logSize;         // Size of the log when the index was built. A larger log means the index is stale.
+  uint32_t entryCnt;
+  char     typeNames[HAB_IDX_MAX_TYPES][HAB_IDX_TYPE_LEN];
+} __attribute__((packed));
+
+struct HabIndexEntry {
+  uint32_t offset;          // Byte offset of the first record of this type in the bucket.
+  uint32_t lineNo;          // Its line (or binary record) number, starting at 1.
+  int32_t  bucket;          // Start time of the bucket, or HAB_IDX_NO_TIME.
+  uint8_t  type;            // Index into typeNames.
+  uint8_t  reserved[3];
+} __attribute__((packed));
+
+
+/*
+ * A record found by HabLogScanner.
+ */
+struct HabLogRecord {
+  uint32_t offset;
+  uint32_t length;          // Including the line terminator.
+  uint32_t lineNo;
+  int32_t  time;            // Time of this record or, if it has none, of the last one that did.
+  bool     binary;          // A binary $HAB record (see HabRecord.h).
+  char     type[HAB_IDX_TYPE_LEN];
+};
+
+
+/*
+ * Parse a UTC time of the form "hhmmss[.ss]" (NMEA) or "h:mm:ss" ($HAB).
+ * Return the seconds since midnight, or HAB_IDX_NO_TIME.
+ */
+inline int32_t habParseTime(const char * p, const char * end) {
+  int32_t parts[3] = { 0, 0, 0 };
+  int partCnt = 0;
+  int digitCnt = 0;
+  int32_t value = 0;
+  for (; p < end && *p != ',' && *p != '.'; p++) {
+    if (*p >= '0' && *p <= '9') {
+      value = value * 10 + (*p - '0');
+      digitCnt++;
+    } else if (*p == ':' && partCnt < 2 && digitCnt > 0) {
+      parts[partCnt++] = value;
+      value = 0;
+      digitCnt = 0;
+    } else {
+      return HAB_IDX_NO_TIME;
+    }
+  }
+  if (partCnt == 2 && digitCnt > 0) {
+    parts[2] = value;
+  } else if (partCnt == 0 && digitCnt == 6) {
+    parts[0] = value / 10000;
+    parts[1] = value / 100 % 100;
+    parts[2] = value % 100;
+  } else {
+    return HAB_IDX_NO_TIME;
+  }
+  if (parts[1] > 59 || parts[2] > 60) {
+    return HAB_IDX_NO_TIME;
+  }
+  return parts[0] * 3600L + parts[1] * 60L + parts[2];
+}
+
+
+/*
+ * Split a log into records, one byte at a time, so that it can be used on a stream
+ * of any block size. A record is a line of text or a binary $HAB record.
+ * Binary records are skipped using their length, as they may contain LF bytes.
+ */
+class HabLogScanner {
+  public:
+    HabLogScanner() { reset(0, 1, HAB_IDX_NO_TIME); }
+
+    /*
+     * Start scanning at a record boundary. time is the time of that point in the log,
+     * normally the bucket of the index entry that was used to find it.
+     */
+    void reset(uint32_t offset, uint32_t lineNo, int32_t time) {
+      nextOffset = offset;
+      nextLineNo = lineNo;
+      lastTime = time;
+      dayOffset = time >= 0 ? time - time % 86400L : 0;
+      startRecord();
+    }
+
+    /*
+     * Process the next byte. Return true if it completes a record, which is then
+     * available from getRecord() until the next call.
+     */
+    bool put(uint8_t b) {
+      recLength++;
+      switch (state) {
+        case ScanStart:
+          if (b == HAB_REC_SYNC1) {
+            state = ScanBinHeader;
+            binHeader[0] = b;
+            return false;
+          }
+          state = ScanText;
+          return putText(b);
+
+        case ScanBinHeader:
+          binHeader[recLength - 1] = b;
+          if (recLength == 2 && b != HAB_REC_SYNC2) {
+            // Not a binary record after all, treat the bytes as text.
+            state = ScanText;
+            addPrefix(binHeader[0]);
+            return putText(b);
+          }
+          if (recLength < sizeof(binHeader)) {
+            return false;
+          }
+          if (binHeader[3] + HAB_REC_HEADER_SIZE < (int) sizeof(binHeader)) {
+            return endRecord(true);     // Too short to be valid, end it here.
+          }
+          binRemaining = HAB_REC_HEADER_SIZE + binHeader[3] + HAB_REC_CRC_SIZE - sizeof(binHeader);
+          state = ScanBinBody;
+          return false;
+
+        case ScanBinBody:
+          return --binRemaining == 0 ? endRecord(true) : false;
+
+        default:
+          return putText(b);
+      }
+    }
+
+    /*
+     * Finish the last record if the log does not end with a line terminator.
+     */
+    bool finish() {
+      return recLength > 0 ? endRecord(state != ScanText) : false;
+    }
+
+    const HabLogRecord & getRecord() const { return record; }
+
+  private:
+    enum ScanState { ScanStart, ScanText, ScanBinHeader, ScanBinBody };
+
+    void startRecord() {
+      state = ScanStart;
+      recLength = 0;
+      prefixLen = 0;
+    }
+
+    void addPrefix(uint8_t b) {
+      if (prefixLen < HAB_IDX_PREFIX_LEN) {
+        prefix[prefixLen++] = b;
+      }
+    }
+
+    bool putText(uint8_t b) {
+      if (b == '\n') {
+        return endRecord(false);
+      }
+      addPrefix(b);
+      return false;
+    }
+
+    /*
+     * Advance the clock to a time of day, allowing for the flight crossing midnight.
+     */
+    void setTime(int32_t secs) {
+      int32_t t = secs + dayOffset;
+      if (lastTime >= 0 && t < lastTime - 43200L) {
+        dayOffset += 86400L;
+        t += 86400L;
+      }
+      lastTime = t;
+    }
+
+    bool endRecord(bool binary) {
+      record.offset = nextOffset;
+      record.length = recLength;
+      record.lineNo = nextLineNo;
+      record.binary = binary;
+
+      if (binary) {
+        // hour, minute and second follow the header.
+        strcpy(record.type, "$HAB");
+        if (recLength >= sizeof(binHeader)) {
+          setTime(binHeader[4] * 3600L + binHeader[5] * 60L + binHeader[6]);
+        }
+      } else {
+        // The type is the first field. A sentence tagged as invalid ("!$") is typed as the sentence.
+        const char * p = prefix;
+        const char * end = prefix + prefixLen;
+        if (p < end && *p == '!') {
+          p++;
+        }
+        const char * comma = (const char *) memchr(p, ',', end - p);
+        size_t typeLen = comma ? comma - p : 0;
+        if (p < end && *p == '$' && typeLen > 1 && typeLen < HAB_IDX_TYPE_LEN) {
+          memcpy(record.type, p, typeLen);
+          record.type[typeLen] = '\0';
+          bool hasTime = strcmp(record.type, "$HAB") == 0;
+          if (typeLen == 6) {           // $ttFFF, the time is the first field of GGA, RMC and ZDA.
+            const char * fmt = record.type + 3;
+            hasTime = strcmp(fmt, "GGA") == 0 || strcmp(fmt, "RMC") == 0 || strcmp(fmt, "ZDA") == 0;
+          }
+          if (hasTime) {
+            int32_t secs = habParseTime(comma + 1, end);
+            if (secs != HAB_IDX_NO_TIME) {
+              setTime(secs);
+            }
+          }
+        } else {
+          strcpy(record.type, HAB_IDX_OTHER_TYPE);
+        }
+      }
+      record.time = lastTime;
+
+      nextOffset += recLength;
+      nextLineNo++;
+      startRecord();
+      return true;
+    }
+
+    ScanState state;
+    uint32_t recLength;
+    char prefix[HAB_IDX_PREFIX_LEN];
+    uint8_t prefixLen;
+    uint8_t binHeader[HAB_REC_HEADER_SIZE + 4];   // Header plus hour, minute, second, flags.
+    uint16_t binRemaining;
+
+    uint32_t nextOffset;
+    uint32_t nextLineNo;
+    int32_t lastTime;
+    int32_t dayOffset;
+    HabLogRecord record;
+};
+
+
+/*
+ * Builds the index from the records of a log, in order.
+ */
+class HabIndexBuilder {
+  public:
+    HabIndexBuilder(uint16_t bucketSecs = HAB_IDX_DEFAULT_BUCKET) {
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, HAB_IDX_MAGIC, sizeof(header.magic));
+      header.version = HAB_IDX_VERSION;
+      header.bucketSecs = bucketSecs > 0 ? bucketSecs : 1;
+    }
+
+    /*
+     * Add a record. Return true if it starts a new bucket for its type, in which
+     * case entry is filled in and must be written to the index.
+     */
+    bool add(const HabLogRecord & rec, HabIndexEntry & entry) {
+      header.logSize = rec.offset + rec.length;
+      uint8_t type = typeId(rec.type);
+      int32_t bucket = rec.time == HAB_IDX_NO_TIME ? HAB_IDX_NO_TIME : rec.time - rec.time % header.bucketSecs;
+      if (seen[type] && lastBucket[type] == bucket) {
+        return false;
+      }
+      seen[type] = true;
+      lastBucket[type] = bucket;
+
+      memset(&entry, 0, sizeof(entry));
+      entry.offset = rec.offset;
+      entry.lineNo = rec.lineNo;
+      entry.bucket = bucket;
+      entry.type = type;
+      header.entryCnt++;
+      return true;
+    }
+
+    // The header to write once all of the records have been added.
+    const HabIndexHeader & getHeader() const { return header; }
+
+  private:
+    uint8_t typeId(const char * name) {
+      for (uint8_t i = 0; i < header.typeCnt; i++) {
+        if (strncmp(header.typeNames[i], name, HAB_IDX_TYPE_LEN) == 0) {
+          return i;
+        }
+      }
+      if (header.typeCnt < HAB_IDX_MAX_TYPES - 1 || strcmp(name, HAB_IDX_OTHER_TYPE) == 0) {
+        memcpy(header.typeNames[header.typeCnt], name, strnlen(name, HAB_IDX_TYPE_LEN - 1));
+        return header.typeCnt++;
+      }
+      return typeId(HAB_IDX_OTHER_TYPE);  // The last slot is kept for this.
+    }
+
+    HabIndexHeader header;
+    bool seen[HAB_IDX_MAX_TYPES] = { false };
+    int32_t lastBucket[HAB_IDX_MAX_TYPES];
+};
+
+
+/*
+ * Check that an index header is valid and is up to date for a log of logSize bytes.
+ */
+inline bool habIndexIsCurrent(const HabIndexHeader & header, uint32_t logSize) {
+  return memcmp(header.magic, HAB_IDX_MAGIC, sizeof(header.magic)) == 0
+      && header.version == HAB_IDX_VERSION && header.logSize == logSize
+      && header.typeCnt <= HAB_IDX_MAX_TYPES && header.bucketSecs > 0;
+}
+
+
+/*
+ * Find the part of a log that holds the records of a type (or any type) in a time range.
+ * The index entries are added in order, after which the scan starts at
+ * startOffset/startLineNo/startTime and stops at endOffset.
+ */
+class HabIndexRange {
+  public:
+    /*
+     * type is the type's index in the header, or -1 for any type.
+     * from and to are inclusive. A from of HAB_IDX_NO_TIME also selects records
+     * before the first time in the log.
+     */
+    HabIndexRange(const HabIndexHeader & header, int type, int32_t from, int32_t to)
+      : bucketSecs(header.bucketSecs), type(type), from(from), to(to) {}
+
+    void add(const HabIndexEntry & entry) {
+      if (!found) {
+        if ((type < 0 || entry.type == type) && overlaps(entry.bucket)) {
+          found = true;
+          startOffset = entry.offset;
+          startLineNo = entry.lineNo;
+          startTime = entry.bucket;
+        }
+      } else if (!ended && entry.offset > startOffset && entry.bucket != HAB_IDX_NO_TIME && entry.bucket > to) {
+        ended = true;
+        endOffset = entry.offset;
+      }
+    }
+
+    // Whether a record found by the scan is one that was asked for.
+    bool matches(const HabLogRecord & rec, const char * typeName) const {
+      bool inRange = rec.time == HAB_IDX_NO_TIME ? from == HAB_IDX_NO_TIME : rec.time >= from && rec.time <= to;
+      return inRange && (typeName == NULL || strcmp(rec.type, typeName) == 0);
+    }
+
+    bool found = false;
+    bool ended = false;         // If false, scan to the end of the log.
+    uint32_t startOffset = 0;
+    uint32_t startLineNo = 1;
+    int32_t startTime = HAB_IDX_NO_TIME;
+    uint32_t endOffset = 0;
+
+  private:
+    bool overlaps(int32_t bucket) const {
+      if (bucket == HAB_IDX_NO_TIME) {
+        return from == HAB_IDX_NO_TIME;
+      }
+      return bucket + bucketSecs > from && bucket <= to;
+    }
+
+    uint16_t bucketSecs;
+    int type;
+    int32_t from;
+    int32_t to;
+};
+
+
+/*
+ * Make the index file name from the log file name by replacing the extension.
+ */
+inline void habIndexFileName(const char * logName, char * idxName, size_t size) {
+  strncpy(idxName, logName, size - 1);
+  idxName[size - 1] = '\0';
+  char * dot = strrchr(idxName, '.');
+  char * slash = strrchr(idxName, '/');
+  if (dot == NULL || (slash != NULL && dot < slash)) {
+    dot = idxName + strlen(idxName);
+  }
+  if ((size_t) (dot - idxName) + 1 + strlen(HAB_IDX_EXT) < size) {
+    strcpy(dot, "." HAB_IDX_EXT);
+  }
+}
+
+#endif
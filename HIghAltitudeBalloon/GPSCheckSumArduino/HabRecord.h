@@ -0,0 +1,154 @@
+#ifndef _HABRECORD_H
+#define _HABRECORD_H
+
+/*
+ * Binary $HAB record.
+ *
+ * A fixed layout alternative to the text $HAB record (see LOG_BINARY_HAB in hab_config.h).
+ * The record is written into the log between the NMEA sentences and is converted back to
+ * the text $HAB layout by GPSCheckSum/habdecode.cpp.
+ *
+ * This file is shared by the logger and the host side decoder, so it must not depend
+ * upon Arduino.h. All of the targets (AVR, Teensy and x86) are little endian.
+ *
+ * Layout:
+ *   sync1, sync2      - HAB_REC_SYNC1, HAB_REC_SYNC2. Neither is a valid ASCII character.
+ *   version           - HAB_REC_VERSION
+ *   length            - number of bytes after the length byte, excluding the CRC.
+ *   ...               - the fields below.
+ *   crc               - CRC-16/CCITT of version through to the last field (LSB first).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "LatencyHist.h"
+
+#define HAB_REC_SYNC1     0xA5
+#define HAB_REC_SYNC2     0xB6
+#define HAB_REC_VERSION   4
+
+// Number of latency timers summarised in the record (see Instrument.h), and the names
+// of their columns in the text record. Each timer has a count, p50, p90, p99 and max (us).
+#define HAB_REC_TIMER_CNT 5
+#define HAB_TIMER_COLUMNS(name) name "Cnt," name "P50," name "P90," name "P99," name "Max"
+
+// Column names of the text $HAB record, written at the start of each log by logHeader().
+// The binary record holds the same fields in the same order.
+#define HAB_LOG_HEADER "$HAB,UTCTime,lat,lon,alt,hdop,satCnt,T1,T2,battV," \
+  "gpsOvfCnt,gpsHighWater,chkErrGP,chkErrGN,chkErrOther,logCnt," \
+  HAB_TIMER_COLUMNS("loop") "," HAB_TIMER_COLUMNS("gps") "," HAB_TIMER_COLUMNS("temp") "," \
+  HAB_TIMER_COLUMNS("oled") "," HAB_TIMER_COLUMNS("sd")
+
+// Text record that marks a warm restart, where logging resumed in the same log after a
+// reset (see LOG_WARM_RESTART in hab_config.h). resumeMs is the time from the reset to
+// the record, discarded the number of bytes of the torn record removed from the log.
+#define HAB_RESTART_HEADER "$HABRS,resumeMs,discarded,phase,version"
+
+// Bits in the flags field.
+#define HAB_FLAG_TIME_VALID     0x01
+#define HAB_FLAG_LOC_VALID      0x02
+#define HAB_FLAG_ALT_VALID      0x04
+#define HAB_FLAG_HDOP_VALID     0x08
+#define HAB_FLAG_SAT_VALID      0x10
+#define HAB_FLAG_RECORD_BROKEN  0x20
+#define HAB_FLAG_HEATER_ON      0x40
+
+/*
+ * Summary of a latency histogram. The percentiles are LatencyHistogram buckets,
+ * LatencyHistogram::bucketValue(p50, max) gives the time (us).
+ */
+struct HabTimerSummary {
+  uint32_t cnt;
+  uint8_t  p50;
+  uint8_t  p90;
+  uint8_t  p99;
+  uint32_t max;               // Microseconds.
+} __attribute__((packed));
+
+struct HabRecord {
+  uint8_t  sync1;
+  uint8_t  sync2;
+  uint8_t  version;
+  uint8_t  length;
+
+  uint8_t  hour;
+  uint8_t  minute;
+  uint8_t  second;
+  uint8_t  flags;
+
+  int32_t  lat;               // Degrees * 1,000,000.
+  int32_t  lon;               // Degrees * 1,000,000.
+  int32_t  alt;               // Centimetres.
+  uint32_t hdop;              // HDOP * 10,000.
+  uint8_t  satCnt;
+  int16_t  temp1;             // Centi-degrees C.
+  int16_t  temp2;             // Centi-degrees C.
+  uint16_t battV;             // Centi-volts.
+
+  // Counts saturate at 65535.
+  uint16_t gpsOvfCnt;         // Sentences dropped by the GPS receive buffer.
+  uint16_t gpsHighWater;      // Most bytes held in the GPS receive buffer.
+  uint16_t chkErrGP;          // GPS sentences with an incorrect checksum, by talker ID.
+  uint16_t chkErrGN;
+  uint16_t chkErrOther;
+  uint32_t logCnt;
+
+  HabTimerSummary timers[HAB_REC_TIMER_CNT];
+  uint8_t  crc[2];            // LSB first.
+} __attribute__((packed));
+
+// Size of the record, excluding the CRC.
+#define HAB_REC_SIZE        offsetof(HabRecord, crc)
+// Size of the sync, version and length bytes.
+#define HAB_REC_HEADER_SIZE 4
+#define HAB_REC_CRC_SIZE    2
+
+
+/*
+ * CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF).
+ */
+inline uint16_t habCrc16(const uint8_t * data, size_t len, uint16_t crc = 0xFFFF) {
+  while (len--) {
+    crc ^= (uint16_t) *data++ << 8;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+
+/* Saturate a value into a uint16_t counter. */
+inline uint16_t habSat16(uint32_t value) {
+  return value > 0xFFFF ? 0xFFFF : (uint16_t) value;
+}
+
+
+/* Summarise a latency histogram. */
+inline void habSummariseTimer(HabTimerSummary & summary, const LatencyHistogram & hist) {
+  summary.cnt = hist.getCount();
+  summary.p50 = hist.percentileBucket(50);
+  summary.p90 = hist.percentileBucket(90);
+  summary.p99 = hist.percentileBucket(99);
+  summary.max = hist.getMax();
+}
+
+
+/*
+ * Complete a record once its fields have been set.
+ * Fills in the header and the CRC and returns the number of bytes to be written.
+ */
+inline unsigned int habFinishRecord(HabRecord & rec) {
+  rec.sync1 = HAB_REC_SYNC1;
+  rec.sync2 = HAB_REC_SYNC2;
+  rec.version = HAB_REC_VERSION;
+  rec.length = HAB_REC_SIZE - HAB_REC_HEADER_SIZE;
+
+  uint16_t crc = habCrc16((const uint8_t *) &rec + 2, HAB_REC_SIZE - 2);
+  rec.crc[0] = crc & 0xFF;
+  rec.crc[1] = crc >> 8;
+  return HAB_REC_SIZE + HAB_REC_CRC_SIZE;
+}
+
+#endif
@@ -0,0 +1,422 @@
+#ifndef _HABXFER_H
+#define _HABXFER_H
+
+/*
+ * Framed file transfer over the console serial port (the "get" command of
+ * GPSCheckSumArduino, received by GPSCheckSum/habget).
+ *
+ * Frame layout (multi byte values are LSB first):
+ *   sync      - HAB_XFER_SYNC1, HAB_XFER_SYNC2.
+ *   type      - HabXferType.
+ *   length    - (2 bytes) number of payload bytes.
+ *   offset    - (4 bytes) file offset, see HabXferType.
+ *   payload   - length bytes.
+ *   crc       - (4 bytes) CRC-32 of type through to the end of the payload.
+ * A receiver looks for the sync bytes, so any console text before a frame is skipped,
+ * and drops a frame with an incorrect CRC.
+ *
+ * The sender (the device) sends a Start frame, then once it is acknowledged, Data
+ * frames, without waiting, until it has sent window bytes that have not been
+ * acknowledged. The receiver acknowledges (Ack) each frame that continues the file,
+ * with the offset of the next byte it needs. If it sees a gap, or hears nothing for a
+ * while, it sends a Nak with that offset and the sender goes back to it. The sender
+ * also goes back to the last acknowledged offset if it hears nothing for
+ * HAB_XFER_TIMEOUT_MS. Once everything has been acknowledged, the sender sends an End
+ * frame with the CRC-32 of the whole file, so that a transfer resumed from an offset
+ * can be checked too, and the receiver replies Finish.
+ *
+ * This file is shared by GPSCheckSumArduino and the host side tools, so it must not
+ * depend upon Arduino.h. habget includes it from here.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define HAB_XFER_SYNC1        0xA5
+#define HAB_XFER_SYNC2        0x5A
+// Bytes before the payload, and the CRC after it.
+#define HAB_XFER_HDR_SIZE     9
+#define HAB_XFER_CRC_SIZE     4
+#define HAB_XFER_OVERHEAD     (HAB_XFER_HDR_SIZE + HAB_XFER_CRC_SIZE)
+// Size of a frame without a payload (the frames sent by the receiver).
+#define HAB_XFER_CTRL_SIZE    HAB_XFER_OVERHEAD
+// Data is read from the file in blocks of this size, aligned to the file.
+#define HAB_XFER_BLOCK        512
+
+// No progress for this long (ms) and the sender goes back to the last acknowledged offset.
+#define HAB_XFER_TIMEOUT_MS   1000
+// Timeouts in a row before the transfer is abandoned.
+#define HAB_XFER_MAX_RETRIES  10
+
+enum HabXferType {
+  // Sender to receiver.
+  HabXferStart = 'S',     // offset = first offset sent, payload = file size (4 bytes).
+  HabXferData  = 'D',     // offset = file offset of the payload.
+  HabXferEnd   = 'E',     // offset = file size, payload = CRC-32 of the file (4 bytes).
+  HabXferError = 'X',     // payload = message text, the transfer is over.
+  // Receiver to sender.
+  HabXferAck   = 'A',     // offset = next offset needed.
+  HabXferNak   = 'N',     // offset = next offset needed, resend from there.
+  HabXferFinish = 'F',    // End received.
+  HabXferCancel = 'C'     // Stop the transfer.
+};
+
+enum HabXferResult {
+  HabXferBusy,
+  HabXferOk,
+  HabXferCancelled,
+  HabXferTimedOut,
+  HabXferReadFailed
+};
+
+
+inline void habXferPut16(uint8_t * p, uint16_t v) {
+  p[0] = (uint8_t) v;
+  p[1] = (uint8_t) (v >> 8);
+}
+
+inline void habXferPut32(uint8_t * p, uint32_t v) {
+  habXferPut16(p, (uint16_t) v);
+  habXferPut16(p + 2, (uint16_t) (v >> 16));
+}
+
+inline uint16_t habXferGet16(const uint8_t * p) {
+  return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+inline uint32_t habXferGet32(const uint8_t * p) {
+  return habXferGet16(p) | ((uint32_t) habXferGet16(p + 2) << 16);
+}
+
+
+/*
+ * CRC-32 (as zlib's crc32()). Pass the previous result to continue it over more data.
+ * Uses a 16 entry table, 4 bits at a time, to keep the table small on AVR.
+ */
+inline uint32_t habCrc32(const uint8_t * data, size_t len, uint32_t crc = 0) {
+  static const uint32_t nibbleTable[16] = {
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL, 0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+    0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL, 0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+  };
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    crc = (crc >> 4) ^ nibbleTable[crc & 0x0F];
+    crc = (crc >> 4) ^ nibbleTable[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+
+/*
+ * Fill in the header and CRC of a frame whose payload is already at
+ * frame + HAB_XFER_HDR_SIZE. Return the size of the frame.
+ */
+inline size_t habXferFinishFrame(uint8_t * frame, HabXferType type, uint16_t length, uint32_t offset) {
+  frame[0] = HAB_XFER_SYNC1;
+  frame[1] = HAB_XFER_SYNC2;
+  frame[2] = (uint8_t) type;
+  habXferPut16(frame + 3, length);
+  habXferPut32(frame + 5, offset);
+  habXferPut32(frame + HAB_XFER_HDR_SIZE + length, habCrc32(frame + 2, HAB_XFER_HDR_SIZE - 2 + length));
+  return HAB_XFER_HDR_SIZE + length + HAB_XFER_CRC_SIZE;
+}
+
+
+/*
+ * Collect frames from a byte stream. Bytes that are not part of a frame with a
+ * correct CRC are skipped.
+ */
+class HabXferParser {
+  public:
+    /*
+     * Frames are assembled in buf, so the longest payload accepted is
+     * size - HAB_XFER_OVERHEAD.
+     */
+    HabXferParser(uint8_t * buf, size_t size) : buf(buf), size(size), pos(0), errCnt(0) {
+    }
+
+    /*
+     * Add the next byte. Return true if it completes a frame.
+     */
+    bool put(uint8_t b) {
+      if (pos == 0) {
+        if (b == HAB_XFER_SYNC1) {
+          buf[pos++] = b;
+        }
+        return false;
+      }
+      if (pos == 1) {
+        if (b == HAB_XFER_SYNC2) {
+          buf[pos++] = b;
+        } else if (b != HAB_XFER_SYNC1) {
+          pos = 0;
+        }
+        return false;
+      }
+      buf[pos++] = b;
+      if (pos == HAB_XFER_HDR_SIZE && getLength() > size - HAB_XFER_OVERHEAD) {
+        errCnt++;
+        pos = 0;
+      } else if (pos >= HAB_XFER_HDR_SIZE && pos == (size_t) HAB_XFER_OVERHEAD + getLength()) {
+        pos = 0;
+        if (habCrc32(buf + 2, HAB_XFER_HDR_SIZE - 2 + getLength()) == habXferGet32(buf + HAB_XFER_HDR_SIZE + getLength())) {
+          return true;
+        }
+        errCnt++;
+      }
+      return false;
+    }
+
+    // The frame, once put() has returned true.
+    HabXferType getType() const { return (HabXferType) buf[2]; }
+    uint16_t getLength() const { return habXferGet16(buf + 3); }
+    uint32_t getOffset() const { return habXferGet32(buf + 5); }
+    const uint8_t * getPayload() const { return buf + HAB_XFER_HDR_SIZE; }
+    // Frames dropped because of an incorrect CRC or length.
+    unsigned long getErrorCnt() const { return errCnt; }
+
+  private:
+    uint8_t * buf;
+    size_t size;
+    size_t pos;
+    unsigned long errCnt;
+};
+
+
+/*
+ * The sending side of a transfer.
+ *
+ * Port is the serial port, with int available(), int read() and
+ * write(const uint8_t *, size_t) methods (e.g. Serial). File is an open file with
+ * int read(void *, size_t) and seekSet(offset) methods (e.g. FsFile).
+ *
+ * Example:
+ *   HabXferSender<decltype(Serial), FsFile> sender(Serial, file, buf, sizeof(buf), window);
+ *   sender.start(offset, file.fileSize(), millis());
+ *   while (sender.poll(millis())) {
+ *   }
+ */
+template <class Port, class File>
+class HabXferSender {
+  public:
+    /*
+     * frame is used to build the frames. The payload of a Data frame is the largest
+     * multiple of HAB_XFER_BLOCK that fits. window is the amount of data that can be
+     * sent before it is acknowledged.
+     */
+    HabXferSender(Port & port, File & file, uint8_t * frame, size_t frameSize, uint32_t window)
+        : port(port), file(file), frame(frame), window(window),
+          ctrlParser(ctrlBuf, sizeof(ctrlBuf)) {
+      payloadSize = frameSize - HAB_XFER_OVERHEAD;
+      if (payloadSize >= HAB_XFER_BLOCK) {
+        payloadSize -= payloadSize % HAB_XFER_BLOCK;
+      }
+      if (payloadSize > 0xFFFF) {
+        payloadSize = 0xFFFF - 0xFFFF % HAB_XFER_BLOCK;
+      }
+      result = HabXferBusy;
+    }
+
+    /*
+     * Start sending the file of size bytes from offset. The CRC of the part of the
+     * file before offset is calculated first, for the End frame.
+     */
+    void start(uint32_t offset, uint32_t size, uint32_t now) {
+      fileSize = size;
+      firstOffset = offset <= size ? offset : size;
+      acked = sent = crcOffset = 0;
+      fileCrc = 0;
+      resentCnt = 0;
+      retries = 0;
+      lastProgress = now;
+      started = ended = false;
+      result = HabXferBusy;
+      while (crcOffset < firstOffset && result == HabXferBusy) {
+        uint32_t n = nextLength(crcOffset, firstOffset);
+        if (file.read(frame + HAB_XFER_HDR_SIZE, n) != (int) n) {
+          fail("read error");
+        }
+        fileCrc = habCrc32(frame + HAB_XFER_HDR_SIZE, n, fileCrc);
+        crcOffset += n;
+      }
+      acked = sent = firstOffset;
+      if (result == HabXferBusy && !file.seekSet(firstOffset)) {
+        fail("seek error");
+      }
+      if (result == HabXferBusy) {
+        sendStart();
+      }
+    }
+
+    /*
+     * Handle the receiver's replies and send what the window allows. Call until it
+     * returns false, then see getResult().
+     */
+    bool poll(uint32_t now) {
+      while (result == HabXferBusy && port.available() > 0) {
+        if (ctrlParser.put((uint8_t) port.read())) {
+          handle(now);
+        }
+      }
+      if (result != HabXferBusy) {
+        return false;
+      }
+
+      if (started && !ended) {
+        if (sent < fileSize && sent - acked < window) {
+          sendData();
+          return result == HabXferBusy;
+        }
+        if (acked == fileSize) {
+          ended = true;
+          sendEnd();
+          lastProgress = now;
+        }
+      }
+
+      if (now - lastProgress >= HAB_XFER_TIMEOUT_MS) {
+        lastProgress = now;
+        if (++retries > HAB_XFER_MAX_RETRIES) {
+          result = HabXferTimedOut;
+          return false;
+        }
+        if (!started) {
+          sendStart();
+        } else if (ended) {
+          sendEnd();
+        } else {
+          goBack(acked);
+        }
+      }
+      return result == HabXferBusy;
+    }
+
+    /*
+     * Send an Error frame with a message, e.g. if the file cannot be opened.
+     */
+    void fail(const char * msg) {
+      size_t len = strlen(msg);
+      if (len > payloadSize) {
+        len = payloadSize;
+      }
+      memcpy(frame + HAB_XFER_HDR_SIZE, msg, len);
+      port.write(frame, habXferFinishFrame(frame, HabXferError, len, 0));
+      result = HabXferReadFailed;
+    }
+
+    HabXferResult getResult() const { return result; }
+    // Bytes sent again after a Nak or timeout.
+    uint32_t getResentCnt() const { return resentCnt; }
+    uint32_t getFileCrc() const { return fileCrc; }
+
+  private:
+    /*
+     * Length of the next read from offset: up to the next block boundary, so that
+     * later reads are aligned, then whole payloads.
+     */
+    uint32_t nextLength(uint32_t offset, uint32_t end) {
+      uint32_t n = payloadSize;
+      if (offset % HAB_XFER_BLOCK != 0 && payloadSize >= HAB_XFER_BLOCK) {
+        n = HAB_XFER_BLOCK - offset % HAB_XFER_BLOCK;
+      }
+      return n < end - offset ? n : end - offset;
+    }
+
+    void handle(uint32_t now) {
+      uint32_t offset = ctrlParser.getOffset();
+      switch (ctrlParser.getType()) {
+        case HabXferAck:
+          if (!started && offset == firstOffset) {
+            started = true;
+            progress(now);
+          } else if (started && offset > acked && offset <= sent) {
+            acked = offset;
+            progress(now);
+          }
+          break;
+        case HabXferNak:
+          if (ended && offset == fileSize) {
+            sendEnd();
+          } else if (started && !ended && offset >= acked && offset <= sent) {
+            acked = offset;
+            goBack(offset);
+          }
+          break;
+        case HabXferFinish:
+          if (ended) {
+            result = HabXferOk;
+          }
+          break;
+        case HabXferCancel:
+          result = HabXferCancelled;
+          break;
+        default:
+          break;
+      }
+    }
+
+    void progress(uint32_t now) {
+      lastProgress = now;
+      retries = 0;
+    }
+
+    void goBack(uint32_t offset) {
+      resentCnt += sent - offset;
+      sent = offset;
+      if (!file.seekSet(offset)) {
+        fail("seek error");
+      }
+    }
+
+    void sendStart() {
+      habXferPut32(frame + HAB_XFER_HDR_SIZE, fileSize);
+      port.write(frame, habXferFinishFrame(frame, HabXferStart, 4, firstOffset));
+    }
+
+    void sendData() {
+      uint8_t * payload = frame + HAB_XFER_HDR_SIZE;
+      uint32_t n = nextLength(sent, fileSize);
+      if (file.read(payload, n) != (int) n) {
+        fail("read error");
+        return;
+      }
+      // The file CRC is only continued by data that has not been sent before.
+      if (sent <= crcOffset && sent + n > crcOffset) {
+        fileCrc = habCrc32(payload + (crcOffset - sent), sent + n - crcOffset, fileCrc);
+        crcOffset = sent + n;
+      }
+      port.write(frame, habXferFinishFrame(frame, HabXferData, n, sent));
+      sent += n;
+    }
+
+    void sendEnd() {
+      habXferPut32(frame + HAB_XFER_HDR_SIZE, fileCrc);
+      port.write(frame, habXferFinishFrame(frame, HabXferEnd, 4, fileSize));
+    }
+
+    Port & port;
+    File & file;
+    uint8_t * frame;
+    uint32_t payloadSize;
+    uint32_t window;
+
+    uint8_t ctrlBuf[HAB_XFER_CTRL_SIZE];
+    HabXferParser ctrlParser;
+
+    uint32_t fileSize;
+    uint32_t firstOffset;
+    uint32_t acked;           // Everything before this has been received.
+    uint32_t sent;            // The next offset to send.
+    uint32_t crcOffset;       // fileCrc covers the file up to here.
+    uint32_t fileCrc;
+    uint32_t resentCnt;
+    uint32_t lastProgress;
+    unsigned int retries;
+    bool started;             // The Start frame has been acknowledged.
+    bool ended;               // The End frame has been sent.
+    HabXferResult result;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef _LINESCANNER_H
+#define _LINESCANNER_H
+
+/*
+ * Split a text file into lines, reading it in whole blocks.
+ *
+ * The file is read into a buffer owned by the caller, in multiples of LINE_SCAN_BLOCK
+ * so that every read starts on a sector boundary and SdFat can transfer the sectors
+ * straight into the buffer. The lines are found in place and returned as a pointer and
+ * length into the buffer, including the line terminator, so they are only valid until
+ * the next call to next().
+ *
+ * A line of up to size - LINE_SCAN_BLOCK bytes is always returned whole. A longer
+ * line that does not fit in the buffer is returned in pieces. isComplete() is false
+ * for every piece but the last, and isContinued() is true for every piece but the first.
+ *
+ * Example:
+ *   LineScanner lines(buf, sizeof(buf));
+ *   while (lines.next(file)) {
+ *     Serial.write(lines.getText(), lines.getLength());
+ *   }
+ *
+ * The file can be any type with an int read(void *, size_t) method (FsFile, File32,
+ * ...), so this file does not depend upon Arduino.h.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Size of the blocks read from the file (an SD card sector).
+#define LINE_SCAN_BLOCK 512
+
+
+class LineScanner {
+  public:
+    /*
+     * Scan using buf, whose size should be a multiple of LINE_SCAN_BLOCK and at least
+     * two blocks, so that a line that starts in one block can be completed.
+     */
+    LineScanner(char * buf, size_t size) : buf(buf), size(size) {
+      reset();
+    }
+
+    void reset() {
+      start = end = scan = fill = 0;
+      lineNo = 0;
+      bytesRead = 0;
+      complete = true;
+      continued = false;
+      eof = false;
+      readError = false;
+    }
+
+    /*
+     * Move to the next line (or piece of a line), reading more of the file as needed.
+     * Return false at the end of the file.
+     */
+    template <class F> bool next(F & file) {
+      start = end;
+      continued = !complete;
+      bool found = false;
+      while (!found) {
+        const char * nl = (const char *) memchr(buf + scan, '\n', fill - scan);
+        if (nl) {
+          end = scan = nl + 1 - buf;
+          complete = found = true;
+          break;
+        }
+        scan = fill;
+        if (eof) {
+          end = fill;
+          complete = true;
+          found = end > start;
+          break;
+        }
+
+        // No line terminator, move the start of the line to the front and read more.
+        if (start > 0) {
+          memmove(buf, buf + start, fill - start);
+          fill -= start;
+          scan = fill;
+          end = start = 0;
+        }
+        size_t room = (size - fill) / LINE_SCAN_BLOCK * LINE_SCAN_BLOCK;
+        if (room == 0) {
+          end = fill;               // Longer than the buffer, return what we have.
+          complete = false;
+          found = true;
+          break;
+        }
+        int n = file.read(buf + fill, room);
+        if (n <= 0) {
+          eof = true;
+          readError = n < 0;
+        } else {
+          fill += n;
+          bytesRead += n;
+        }
+      }
+      if (found && !continued) {
+        lineNo++;
+      }
+      return found;
+    }
+
+    const char * getText() const { return buf + start; }
+    size_t getLength() const { return end - start; }
+    // Line number (from 1) of the line the text belongs to.
+    unsigned long getLineNo() const { return lineNo; }
+    // The text ends the line.
+    bool isComplete() const { return complete; }
+    // The text is not the start of the line.
+    bool isContinued() const { return continued; }
+    uint32_t getBytesRead() const { return bytesRead; }
+    bool isReadError() const { return readError; }
+
+  private:
+    char * buf;
+    size_t size;
+    size_t start;             // The current line.
+    size_t end;
+    size_t scan;              // Where to continue looking for the end of the line.
+    size_t fill;              // Amount of the buffer that has been read.
+    unsigned long lineNo;
+    uint32_t bytesRead;
+    bool complete;
+    bool continued;
+    bool eof;
+    bool readError;
+};
+
+#endif
@@ -0,0 +1,369 @@
+#ifndef _NMEA_H
+#define _NMEA_H
+
+/*
+ * NMEA 0183 sentence tokenizer.
+ *
+ * Works in place on a buffer owned by the caller: nothing is copied or allocated.
+ * A single pass over the sentence finds the fields, calculates the checksum and
+ * identifies the talker and sentence type. Fields are returned as a pointer and
+ * length into the caller's buffer, so the buffer must not change while they are used.
+ *
+ * This file is used by the sketches and the host side tools, so it must not depend
+ * upon Arduino.h. The master copy is in habFlightMonitor; GPSCheckSumArduino has a
+ * copy because a sketch can only include files from its own folder.
+ *
+ * Example:
+ *   NmeaSentence s;
+ *   if (s.parse(buf, len) == NmeaOk && s.getType() == NmeaTypeGGA) {
+ *     NmeaField alt = s.getField(9);
+ *     ...
+ *   }
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define NMEA_PROGMEM PROGMEM
+#define NMEA_READ_BYTE(p) pgm_read_byte(p)
+#else
+#define NMEA_PROGMEM
+#define NMEA_READ_BYTE(p) (*(p))
+#endif
+
+// Longest sentence that can be parsed (the standard allows 82 characters).
+// The host tools define a larger value before including this file.
+#ifndef NMEA_MAX_LENGTH
+#define NMEA_MAX_LENGTH   255
+#endif
+
+// Offset of a character within a sentence.
+#if NMEA_MAX_LENGTH > 255
+typedef uint16_t NmeaOffset;
+#else
+typedef uint8_t NmeaOffset;
+#endif
+// Maximum number of fields, including the address field ("GPGGA").
+// Any further fields are returned as part of the last one.
+#ifndef NMEA_MAX_FIELDS
+#define NMEA_MAX_FIELDS   24
+#endif
+
+// Value returned by nmeaHexValue for a character that is not a hexadecimal digit.
+#define NMEA_NOT_HEX      0xFF
+
+
+enum NmeaStatus {
+  NmeaOk,                 // The sentence has a correct checksum.
+  NmeaNoStart,            // There is no '$'.
+  NmeaNoChecksum,         // There is no '*' followed by the checksum.
+  NmeaBadChecksum,        // The checksum is incorrect or is not 2 hexadecimal digits.
+  NmeaTooLong             // The sentence is longer than NMEA_MAX_LENGTH.
+};
+
+enum NmeaTalker {
+  NmeaTalkerUnknown,
+  NmeaTalkerGP,           // GPS, SBAS, QZSS.
+  NmeaTalkerGL,           // GLONASS.
+  NmeaTalkerGA,           // Galileo.
+  NmeaTalkerGB,           // BeiDou.
+  NmeaTalkerGQ,           // QZSS.
+  NmeaTalkerGN,           // Any combination of GNSS.
+  NmeaTalkerProprietary,  // "P" followed by a manufacturer code (e.g. PUBX).
+  NmeaTalkerOther
+};
+
+enum NmeaType {
+  NmeaTypeUnknown,
+  NmeaTypeRMC, NmeaTypeGGA, NmeaTypeGLL, NmeaTypeGSA,
+  NmeaTypeGSV, NmeaTypeVTG, NmeaTypeZDA, NmeaTypeTXT
+};
+
+
+// A field within a sentence. The text is not null terminated.
+struct NmeaField {
+  const char * ptr;
+  NmeaOffset len;
+};
+
+
+// Character information held in nmeaCharTable.
+#define NMEA_CHAR_VALUE   0x0F      // Value of a hexadecimal digit.
+#define NMEA_CHAR_NOT_HEX 0x10      // Not a hexadecimal digit.
+#define NMEA_CHAR_DELIM   0x20      // One of '$', '*', ',', CR or LF.
+
+/*
+ * Return the information about a character. A single table lookup both converts
+ * checksum digits and lets the tokenizer skip over ordinary characters.
+ */
+inline uint8_t nmeaCharInfo(char ch) {
+  static const uint8_t charTable[256] NMEA_PROGMEM = {
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x30, 0x10, 0x10, 0x30, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x30, 0x10, 0x10, 0x10, 0x10, 0x10, 0x30, 0x10, 0x30, 0x10, 0x10, 0x10,
+       0,    1,    2,    3,    4,    5,    6,    7,    8,    9, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10,   10,   11,   12,   13,   14,   15, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10,   10,   11,   12,   13,   14,   15, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+  };
+  return NMEA_READ_BYTE(&charTable[(uint8_t) ch]);
+}
+
+
+/*
+ * Return the value of a hexadecimal digit (either case), or NMEA_NOT_HEX.
+ */
+inline uint8_t nmeaHexValue(char ch) {
+  uint8_t info = nmeaCharInfo(ch);
+  return (info & NMEA_CHAR_NOT_HEX) ? NMEA_NOT_HEX : info;
+}
+
+
+/*
+ * Identify the talker and sentence type from the address field, e.g. "GPGGA".
+ * The address may be followed by other text, only the first addrLen characters are examined.
+ */
+inline void nmeaClassify(const char * addr, size_t addrLen, NmeaTalker & talker, NmeaType & type) {
+  talker = NmeaTalkerUnknown;
+  type = NmeaTypeUnknown;
+  if (addrLen < 1) {
+    return;
+  }
+  if (addr[0] == 'P') {
+    talker = NmeaTalkerProprietary;
+    return;
+  }
+  if (addrLen < 5) {
+    return;
+  }
+
+  if (addr[0] != 'G') {
+    talker = NmeaTalkerOther;
+  } else {
+    switch (addr[1]) {
+      case 'P': talker = NmeaTalkerGP; break;
+      case 'L': talker = NmeaTalkerGL; break;
+      case 'A': talker = NmeaTalkerGA; break;
+      case 'B': talker = NmeaTalkerGB; break;
+      case 'Q': talker = NmeaTalkerGQ; break;
+      case 'N': talker = NmeaTalkerGN; break;
+      default:  talker = NmeaTalkerOther; break;
+    }
+  }
+
+  // The formatter is three letters, compare them as a single value.
+#define NMEA_FORMATTER(a, b, c) (((uint32_t) (a) << 16) | ((uint32_t) (b) << 8) | (uint32_t) (c))
+  switch (NMEA_FORMATTER(addr[2], addr[3], addr[4])) {
+    case NMEA_FORMATTER('R', 'M', 'C'): type = NmeaTypeRMC; break;
+    case NMEA_FORMATTER('G', 'G', 'A'): type = NmeaTypeGGA; break;
+    case NMEA_FORMATTER('G', 'L', 'L'): type = NmeaTypeGLL; break;
+    case NMEA_FORMATTER('G', 'S', 'A'): type = NmeaTypeGSA; break;
+    case NMEA_FORMATTER('G', 'S', 'V'): type = NmeaTypeGSV; break;
+    case NMEA_FORMATTER('V', 'T', 'G'): type = NmeaTypeVTG; break;
+    case NMEA_FORMATTER('Z', 'D', 'A'): type = NmeaTypeZDA; break;
+    case NMEA_FORMATTER('T', 'X', 'T'): type = NmeaTypeTXT; break;
+    default: break;
+  }
+#undef NMEA_FORMATTER
+}
+
+
+/*
+ * A parsed sentence.
+ */
+class NmeaSentence {
+  public:
+    /*
+     * Parse a sentence of len characters in buf. The buffer need not be null terminated.
+     * Any text before the '$' is ignored, as is the CR or LF that ends the sentence
+     * and anything after it. The fields,
+     * talker and type are available even if the checksum is incorrect.
+     */
+    NmeaStatus parse(const char * buf, size_t len) {
+      text = buf;
+      fieldCnt = 0;
+      dataEnd = 0;
+      parity = 0;
+      checksum = 0;
+      talker = NmeaTalkerUnknown;
+      type = NmeaTypeUnknown;
+      if (len > NMEA_MAX_LENGTH) {
+        return status = NmeaTooLong;
+      }
+
+      // Find the data, the characters between the '$' and the '*' (or the end of the line).
+      // The loop works on local copies, as writes through buf could alias the members.
+      bool inData = false;
+      uint8_t xorSum = 0;
+      uint8_t cnt = 0;
+      size_t i;
+      for (i = 0; i < len; i++) {
+        char ch = buf[i];
+        if (nmeaCharInfo(ch) & NMEA_CHAR_DELIM) {
+          if (inData && (ch == '*' || ch == '\r' || ch == '\n')) {
+            break;
+          }
+          if (ch == '$') {                // Start (or restart) of a sentence.
+            inData = true;
+            xorSum = 0;
+            fieldStart[0] = i + 1;
+            cnt = 1;
+            continue;
+          }
+          if (ch == ',' && inData && cnt < NMEA_MAX_FIELDS) {
+            fieldStart[cnt++] = i + 1;
+          }
+        }
+        xorSum ^= ch;
+      }
+      parity = xorSum;
+      fieldCnt = cnt;
+      dataEnd = i;
+      bool inChecksum = i < len && buf[i] == '*';
+
+      // The checksum digits, which end at the line terminator.
+      bool badDigit = false;
+      uint8_t digitCnt = 0;
+      uint8_t value = 0;
+      if (inChecksum) {
+        for (i++; i < len && buf[i] != '\r' && buf[i] != '\n'; i++) {
+          uint8_t digit = nmeaHexValue(buf[i]);
+          if (digit == NMEA_NOT_HEX) {
+            badDigit = true;
+          }
+          value = (value << 4) | (digit & 0x0F);
+          digitCnt++;
+        }
+      }
+      checksum = value;
+      if (!inData) {
+        return status = NmeaNoStart;
+      }
+      nmeaClassify(text + fieldStart[0], getField(0).len, talker, type);
+
+      if (!inChecksum) {
+        status = NmeaNoChecksum;
+      } else if (digitCnt != 2 || badDigit || checksum != parity) {
+        status = NmeaBadChecksum;
+      } else {
+        status = NmeaOk;
+      }
+      return status;
+    }
+
+    NmeaStatus getStatus() const { return status; }
+    bool isValid() const { return status == NmeaOk; }
+    // XOR of the characters between the '$' and the '*'.
+    uint8_t getParity() const { return parity; }
+    // Checksum in the sentence.
+    uint8_t getChecksum() const { return checksum; }
+    NmeaTalker getTalker() const { return talker; }
+    NmeaType getType() const { return type; }
+
+    // Number of fields, including the address field.
+    uint8_t getFieldCnt() const { return fieldCnt; }
+
+    // Field n (0 is the address). An empty field is returned if n is out of range.
+    NmeaField getField(uint8_t n) const {
+      NmeaField fld = { text, 0 };
+      if (n < fieldCnt) {
+        NmeaOffset end = (n + 1 < fieldCnt) ? fieldStart[n + 1] - 1 : dataEnd;
+        fld.ptr = text + fieldStart[n];
+        fld.len = end - fieldStart[n];
+      }
+      return fld;
+    }
+
+  private:
+    const char * text = NULL;
+    NmeaOffset fieldStart[NMEA_MAX_FIELDS]; // Offset of each field in text.
+    uint8_t fieldCnt = 0;
+    NmeaOffset dataEnd = 0;               // Offset of the '*' (or the end of the data).
+    uint8_t parity = 0;
+    uint8_t checksum = 0;
+    NmeaTalker talker = NmeaTalkerUnknown;
+    NmeaType type = NmeaTypeUnknown;
+    NmeaStatus status = NmeaNoStart;
+};
+
+
+/*
+ * Checksum of a sentence that arrives one character at a time, e.g. from a UART.
+ * The result is the same as NmeaSentence::parse() gives for the same characters,
+ * without the sentence having to be held in one buffer.
+ */
+class NmeaChecksum {
+  public:
+    // Start a new sentence.
+    void reset() {
+      inData = false;
+      inChecksum = false;
+      ended = false;
+      badDigit = false;
+      digitCnt = 0;
+      checksum = 0;
+      parity = 0;
+    }
+
+    // Include a received character in the checksum calculation. As for parse(), a '$'
+    // in the data starts the sentence again, a '$' or '*' in the checksum is not a
+    // hexadecimal digit, and a CR or LF ends the sentence (anything after it is ignored
+    // until reset()).
+    void update(char ch) {
+      if (ended) {
+        // Not part of the sentence.
+      } else if (inChecksum) {
+        if (ch == '\r' || ch == '\n') {
+          ended = true;
+          return;
+        }
+        uint8_t digit = nmeaHexValue(ch);
+        if (digit == NMEA_NOT_HEX) {
+          badDigit = true;
+        }
+        checksum = (checksum << 4) | (digit & 0x0F);
+        digitCnt++;
+      } else if (ch == '$') {
+        reset();
+        inData = true;
+      } else if (!inData) {
+        // Before the '$'.
+      } else if (ch == '\r' || ch == '\n') {
+        ended = true;
+      } else if (ch == '*') {
+        inChecksum = true;
+      } else {
+        parity ^= ch;
+      }
+    }
+
+    // Return true if the sentence so far has a correct checksum.
+    bool isOk() const {
+      return inChecksum && digitCnt == 2 && !badDigit && checksum == parity;
+    }
+
+    // XOR of the data characters.
+    uint8_t getParity() const { return parity; }
+
+  private:
+    uint8_t parity = 0;               // XOR of the data characters.
+    uint8_t checksum = 0;             // Value of the checksum digits.
+    uint8_t digitCnt = 0;             // Number of checksum digits seen.
+    bool inData = false;              // A '$' has been seen.
+    bool inChecksum = false;          // A '*' has been seen.
+    bool badDigit = false;            // A checksum digit was not hexadecimal.
+    bool ended = false;               // A CR or LF has been seen.
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include <Print.h>
 
 #include "utility.h"
+#include "FixedFormat.h"
+
+#include <math.h>
 
 /* Checks whether a given string is numeric or not
  * return 0 for no, 1 for yes.
@@ -116,6 +119,7 @@ char * twoDigits(unsigned int num, char * buf) {
  *   fieldSize - the number of characters into which the number is formatted.
  *   x - the number to convert.
  *   filler - the character used to pad out the converted number.
+ *   seperator - if not '\0', placed between each group of three digits.
  * 
  * @return
  *   a pointer to the buffer.
@@ -125,71 +129,28 @@ char * twoDigits(unsigned int num, char * buf) {
  * 
  * If the fieldSize is too small for the converted integer, then the buffer will not contain
  * all of the digits representing the number.
- * 
+ *
+ * The number is formatted by FixedFormat.h.
  */
 char * rightJustify(char *buf, int fieldSize, long x, char filler, char seperator) {
-  bool negativeSign = false;
-
-  // Check for a -ve sign and remember this for later.
-  // ensure we have |x| for conversion.
-  if ((negativeSign = x < 0)) {
-    x = -x;
-  }
-
-  // NULL terminate the string.
-  char *p = buf + fieldSize;
-  *p-- = '\0';
-
-  // Load up the characters representing the number.
-  int digitCount = 0;
-  do {
-    *p-- = x % 10 + '0';
-    x /= 10;
-    digitCount++;
-    if (seperator && digitCount % 3 == 0 && x && p >= buf) {
-      *p-- = seperator;
-    }
-  } while (x && p >= buf);
-
-  // Do we need a negative sign? If so, put it in.
-  if (p >= buf && negativeSign) {
-    *p-- = '-';
-  }
-
-  // Pad out the string.
-  while (p >= buf) {
-    *p-- = filler;
-  }
+  FmtCursor out(buf, fieldSize + 1);
+  out.appendSigned(x, fieldSize, filler, seperator);
   return buf;
 }
 
 
-
+/**
+ * rightJustifyF
+ *
+ * Right justify a number with dpCnt decimal places (default 2) into a buffer that is
+ * size fieldSize + 1, as rightJustify() does.
+ *
+ * The number is rounded once to a scaled integer (x * 10^dpCnt), which is then formatted
+ * with integer arithmetic, so there are no rounding artifacts in the fraction digits.
+ */
 char * rightJustifyF(char *buf, int fieldSize, double x, int dpCnt, char filler, char seperator) {
-
-  long iPart = (long) x;
-
-  double fPart = x - (double) iPart;
-
-  rightJustify(buf, fieldSize - 1 - dpCnt, iPart, filler, seperator);
-  char *p = buf + fieldSize - 1 - dpCnt;
-  if (p < buf + fieldSize) {
-    *p++ = '.';
-  }
-
-  // When outputing the fractional component, we need our number to be positive.
-  if (fPart < 0) {
-    fPart = -fPart;
-  }
-
-  while (p < buf + fieldSize && dpCnt--) {
-    double tmp = fPart * 10.0;
-    int digit = (int)tmp;
-    *p++ = digit + '0';
-    fPart = tmp - digit;
-  }
-
-  buf[fieldSize] = '\0';
+  FmtCursor out(buf, fieldSize + 1);
+  out.appendFixed(lround(x * fmtPow10(dpCnt)), dpCnt, dpCnt, fieldSize, filler, seperator);
   return buf;
 }
 
@@ -0,0 +1,161 @@
+#include "GpsIngest.h"
+#include "Nmea.h"
+
+#ifdef ARDUINO_AVR_UNO
+#include <SoftwareSerial.h>
+#define RX 2
+#define TX 3
+SoftwareSerial GPS_PORT(RX, TX);
+#endif
+
+#if defined(GPS_INGEST_ISR)
+IntervalTimer gpsIngestTimer;
+#endif
+
+// Prevent the compiler from moving memory accesses across this point.
+// The processors we use are single core, so this is all that is needed to publish an index.
+#define GPS_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+#define GPS_RING_MASK   (GPS_RING_SIZE - 1)
+#define GPS_QUEUE_MASK  (GPS_QUEUE_SIZE - 1)
+
+// Ring buffer of received bytes. The indices are free running, they are masked when used.
+char gpsRing[GPS_RING_SIZE];
+volatile uint16_t gpsRingHead = 0;        // Updated by the producer.
+volatile uint16_t gpsRingTail = 0;        // Updated by the consumer.
+
+// Queue of the ring index just past the end of each complete sentence,
+// and whether its checksum was correct.
+volatile uint16_t gpsQueue[GPS_QUEUE_SIZE];
+volatile bool gpsQueueChecksumOk[GPS_QUEUE_SIZE];
+volatile uint16_t gpsQueueHead = 0;       // Updated by the producer.
+volatile uint16_t gpsQueueTail = 0;       // Updated by the consumer.
+
+// Producer state.
+uint16_t gpsSentenceStart = 0;            // Ring index of the start of the current sentence.
+bool gpsDiscarding = false;               // Set while the rest of a dropped sentence is skipped.
+
+// Checksum of the current sentence.
+NmeaChecksum gpsChecksum;
+
+// Metrics.
+volatile unsigned int gpsOverflowCnt = 0; // Number of sentences dropped because the ring or queue was full.
+volatile unsigned int gpsHighWater = 0;   // Most bytes held in the ring.
+
+
+/**
+ * Start the GPS receive path.
+ */
+void gpsIngestBegin() {
+  GPS_PORT.begin(GPS_BAUD);
+#if defined(GPS_INGEST_ISR)
+  gpsIngestTimer.begin(gpsIngestPoll, GPS_INGEST_POLL_US);
+#endif
+}
+
+
+/**
+ * Move any received bytes into the ring buffer.
+ * If there is no room for a sentence, the whole sentence is dropped so the loop never
+ * sees a partial sentence.
+ */
+void gpsIngestPoll() {
+  while (GPS_PORT.available()) {
+    char ch = GPS_PORT.read();
+    if (gpsDiscarding) {
+      gpsDiscarding = ch != '\n';
+      if (!gpsDiscarding) {
+        gpsChecksum.reset();
+      }
+      continue;
+    }
+
+    uint16_t head = gpsRingHead;
+    unsigned int used = (uint16_t) (head - gpsRingTail);    // Ring occupancy, allowing for wrap.
+    if (used >= GPS_RING_SIZE) {
+      // Ring is full, drop this sentence.
+      gpsRingHead = gpsSentenceStart;
+      gpsDiscarding = ch != '\n';
+      gpsChecksum.reset();
+      gpsOverflowCnt++;
+      continue;
+    }
+    gpsRing[head & GPS_RING_MASK] = ch;
+    head++;
+    gpsChecksum.update(ch);
+    if (used + 1 > gpsHighWater) {
+      gpsHighWater = used + 1;
+    }
+
+    if (ch == '\n' || (uint16_t) (head - gpsSentenceStart) >= GPS_MAX_SENTENCE) {
+      if ((uint16_t) (gpsQueueHead - gpsQueueTail) >= GPS_QUEUE_SIZE) {
+        // Queue is full, drop this sentence.
+        gpsRingHead = gpsSentenceStart;
+        gpsDiscarding = ch != '\n';
+        gpsChecksum.reset();
+        gpsOverflowCnt++;
+        continue;
+      }
+      gpsQueue[gpsQueueHead & GPS_QUEUE_MASK] = head;
+      gpsQueueChecksumOk[gpsQueueHead & GPS_QUEUE_MASK] = gpsChecksum.isOk();
+      gpsChecksum.reset();
+      gpsSentenceStart = head;
+      GPS_BARRIER();
+      gpsRingHead = head;
+      GPS_BARRIER();
+      gpsQueueHead = gpsQueueHead + 1;
+    } else {
+      GPS_BARRIER();
+      gpsRingHead = head;
+    }
+  }
+}
+
+
+/**
+ * Copy the next complete sentence, including its line terminator, into buf.
+ * If checksumOk is supplied, it is set to whether the sentence's checksum was correct.
+ *
+ * Return - the number of bytes copied, or 0 if there is no complete sentence.
+ * Bytes that do not fit in buf are discarded.
+ */
+int gpsReadSentence(char * buf, unsigned int bufSize, bool * checksumOk) {
+  uint16_t queueTail = gpsQueueTail;
+  if (queueTail == gpsQueueHead) {
+    return 0;
+  }
+  GPS_BARRIER();
+  uint16_t end = gpsQueue[queueTail & GPS_QUEUE_MASK];
+  if (checksumOk) {
+    *checksumOk = gpsQueueChecksumOk[queueTail & GPS_QUEUE_MASK];
+  }
+  uint16_t tail = gpsRingTail;
+  unsigned int n = 0;
+  while (tail != end) {
+    char ch = gpsRing[tail & GPS_RING_MASK];
+    tail++;
+    if (n < bufSize) {
+      buf[n++] = ch;
+    }
+  }
+  GPS_BARRIER();
+  gpsRingTail = tail;
+  gpsQueueTail = queueTail + 1;
+  return n;
+}
+
+
+unsigned int gpsGetOverflowCnt() {
+  return gpsOverflowCnt;
+}
+
+unsigned int gpsGetHighWater() {
+  return gpsHighWater;
+}
+
+void gpsResetMetrics() {
+  noInterrupts();
+  gpsOverflowCnt = 0;
+  gpsHighWater = 0;
+  interrupts();
+}
@@ -0,0 +1,48 @@
+#ifndef _GPSINGEST_H
+#define _GPSINGEST_H
+
+#include <Arduino.h>
+
+#include "hab_config.h"
+
+/*
+ * GPS receive path.
+ *
+ * Bytes received on GPS_PORT are moved into a ring buffer by gpsIngestPoll(), which
+ * also finds the end of each sentence and queues it. The loop collects complete
+ * sentences with gpsReadSentence().
+ *
+ * On a Teensy gpsIngestPoll() is run from a timer interrupt, so slow SD card or OLED
+ * operations in the loop do not cause the UART's receive buffer to overflow.
+ * On other boards it must be called from the loop.
+ *
+ * There is one producer (gpsIngestPoll) and one consumer (gpsReadSentence), so no locking
+ * is required. Each side only updates its own index.
+ *
+ * The NMEA checksum (XOR of the characters between the '$' and the '*') is calculated as
+ * each byte is added to the ring, and the result is queued with the sentence.
+ */
+
+#if defined(TEENSYDUINO)
+#define GPS_INGEST_ISR
+#endif
+
+// Maximum length of a sentence (including the CR/LF). Longer sentences are split.
+#define GPS_MAX_SENTENCE  200
+
+#if (GPS_RING_SIZE & (GPS_RING_SIZE - 1)) != 0 || GPS_RING_SIZE > 32768
+#error "GPS_RING_SIZE must be a power of 2 no larger than 32768"
+#endif
+
+// Number of complete sentences that can be queued.
+#define GPS_QUEUE_SIZE    64
+
+extern void gpsIngestBegin();
+extern void gpsIngestPoll();
+extern int gpsReadSentence(char *, unsigned int, bool * checksumOk = NULL);
+
+extern unsigned int gpsGetOverflowCnt();
+extern unsigned int gpsGetHighWater();
+extern void gpsResetMetrics();
+
+#endif
@@ -0,0 +1,40 @@
+#include "Instrument.h"
+
+const char * const timerNames[TimerCnt] = { "loop", "gps", "temp", "oled", "sd" };
+
+LatencyHistogram timerHist[TimerCnt];
+uint32_t timerStartUs[TimerCnt];
+
+
+void timerStart(enum InstrTimer timer) {
+  timerStartUs[timer] = micros();
+}
+
+
+/**
+ * Record the time since timerStart() in the timer's histogram.
+ *
+ * Return - the time (us).
+ */
+uint32_t timerStop(enum InstrTimer timer) {
+  uint32_t us = micros() - timerStartUs[timer];
+  timerHist[timer].record(us);
+  return us;
+}
+
+
+const char * getTimerName(enum InstrTimer timer) {
+  return timerNames[timer];
+}
+
+
+const LatencyHistogram & getTimerHistogram(enum InstrTimer timer) {
+  return timerHist[timer];
+}
+
+
+void resetTimers() {
+  for (int i = 0; i < TimerCnt; i++) {
+    timerHist[i].reset();
+  }
+}
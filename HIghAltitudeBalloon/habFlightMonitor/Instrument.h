@@ -0,0 +1,37 @@
+#ifndef _INSTRUMENT_H
+#define _INSTRUMENT_H
+
+#include <Arduino.h>
+
+#include "LatencyHist.h"
+
+/*
+ * Loop latency instrumentation.
+ *
+ * Each stage of the loop has a named timer which records how long the stage took (us)
+ * in a LatencyHistogram. A stage is timed with timerStart() and timerStop(). A stage that
+ * found nothing to do can skip timerStop(), so that idle passes do not hide the real
+ * work in the histogram (the next timerStart() discards the timing).
+ *
+ * The histograms are summarised in each $HAB record and then reset with resetTimers().
+ * Timers may be nested (e.g. TimerSd within TimerGps), but a timer must not be
+ * restarted before it is stopped.
+ */
+
+// The order of the timers is the order they appear in the $HAB record (see HabRecord.h).
+enum InstrTimer {
+  TimerLoop,            // The whole of loop().
+  TimerGps,             // Draining and logging the received GPS sentences.
+  TimerTemp,            // A step of the temperature sensor state machine.
+  TimerOled,            // Updating the display.
+  TimerSd,              // Logging a record or syncing the log file.
+  TimerCnt
+};
+
+extern void timerStart(enum InstrTimer);
+extern uint32_t timerStop(enum InstrTimer);
+extern const char * getTimerName(enum InstrTimer);
+extern const LatencyHistogram & getTimerHistogram(enum InstrTimer);
+extern void resetTimers();
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef _LATENCYHIST_H
+#define _LATENCYHIST_H
+
+/*
+ * Fixed memory log-linear latency histogram.
+ *
+ * Each power of 2 is split into LATENCY_SUB_BUCKETS equal buckets, so a value is held
+ * to within 1/8 (12.5%) whatever its size, and values below LATENCY_SUB_BUCKETS are
+ * held exactly. A percentile is reported as the upper bound of the bucket that holds
+ * it (but never more than the largest value recorded, which is kept exactly).
+ *
+ * A bucket number fits in a byte, which is how percentiles are held in the binary
+ * $HAB record (see HabRecord.h). bucketValue() converts them back. The buckets are
+ * the same on every target, so that the host tools can convert them.
+ *
+ * This file is shared by the logger and the host side tools, so it must not depend
+ * upon Arduino.h.
+ */
+
+#include <stdint.h>
+
+#define LATENCY_SUB_BITS      3
+#define LATENCY_SUB_BUCKETS   (1 << LATENCY_SUB_BITS)
+
+// Values up to 2^24 us (16.7s) have their own bucket, larger values share the last one.
+#define LATENCY_RANGE_BITS    24
+#define LATENCY_BUCKET_CNT    ((LATENCY_RANGE_BITS - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+// The bucket counts are 16 bits on AVR, to save RAM (5 timers use 1.7KB rather than
+// 3.5KB). The loop timer alone can put more than 65535 values in one bucket between
+// resets, so when a bucket fills every bucket is halved. The percentiles are found from
+// the bucket counts, so they keep the shape of the distribution. The total count is
+// always 32 bits and exact.
+#if defined(__AVR__)
+typedef uint16_t LatencyCount;
+#define LATENCY_COUNT_MAX     0xFFFFU
+#else
+typedef uint32_t LatencyCount;
+#define LATENCY_COUNT_MAX     0xFFFFFFFFUL
+#endif
+
+class LatencyHistogram {
+  public:
+    LatencyHistogram() {
+      reset();
+    }
+
+    void reset() {
+      for (int i = 0; i < LATENCY_BUCKET_CNT; i++) {
+        counts[i] = 0;
+      }
+      count = 0;
+      max = 0;
+    }
+
+    void record(uint32_t us) {
+      unsigned int b = bucketOf(us);
+      LatencyCount & bucket = counts[b < LATENCY_BUCKET_CNT ? b : LATENCY_BUCKET_CNT - 1];
+      if (bucket == LATENCY_COUNT_MAX) {
+        halve();
+      }
+      bucket++;
+      count++;
+      if (us > max) {
+        max = us;
+      }
+    }
+
+    uint32_t getCount() const { return count; }
+    uint32_t getMax() const { return max; }
+
+    /*
+     * Return the bucket that holds the pct'th percentile (0 if nothing was recorded).
+     */
+    uint8_t percentileBucket(unsigned int pct) const {
+      // The buckets may have been halved, so their total rather than count is used.
+      uint32_t total = 0;
+      for (int i = 0; i < LATENCY_BUCKET_CNT; i++) {
+        total += counts[i];
+      }
+      // The rank of the percentile, rounded up so that p100 is the last value.
+      uint32_t rank = (uint32_t) (((uint64_t) total * pct + 99) / 100);
+      uint32_t seen = 0;
+      for (int i = 0; i < LATENCY_BUCKET_CNT; i++) {
+        seen += counts[i];
+        if (seen >= rank && seen > 0) {
+          return i;
+        }
+      }
+      return 0;
+    }
+
+    uint32_t percentile(unsigned int pct) const {
+      return bucketValue(percentileBucket(pct), max);
+    }
+
+    /*
+     * Return the bucket that holds a value.
+     */
+    static unsigned int bucketOf(uint32_t us) {
+      if (us < LATENCY_SUB_BUCKETS) {
+        return us;
+      }
+      // Most significant bit. unsigned int may be 16 bits (AVR), unsigned long is at least 32.
+      int e = (int) (sizeof(unsigned long) * 8 - 1) - __builtin_clzl(us);
+      return (e - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS + ((us >> (e - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+    }
+
+    /*
+     * Return the largest value held by a bucket, limited to max. The last bucket holds
+     * everything out of range, so it is reported as max.
+     */
+    static uint32_t bucketValue(unsigned int bucket, uint32_t max) {
+      if (bucket >= LATENCY_BUCKET_CNT - 1) {
+        return max;
+      }
+      uint32_t value = bucket;
+      if (bucket >= LATENCY_SUB_BUCKETS) {
+        int shift = bucket / LATENCY_SUB_BUCKETS - 1;
+        uint32_t lower = (uint32_t) (LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) << shift;
+        value = lower + (1UL << shift) - 1;
+      }
+      return value < max ? value : max;
+    }
+
+  private:
+    /*
+     * Halve every bucket, rounding up so that a bucket that held a value still does.
+     */
+    void halve() {
+      for (int i = 0; i < LATENCY_BUCKET_CNT; i++) {
+        counts[i] -= counts[i] / 2;
+      }
+    }
+
+    LatencyCount counts[LATENCY_BUCKET_CNT];
+    uint32_t count;
+    uint32_t max;
+};
+
+#endif
@@ -1,6 +1,8 @@
 #include "Logger.h"
 #include "Utility.h"
+#include "Instrument.h"
 #include "hab_config.h"
+#include "HabRecord.h"
 
 #include <Arduino.h>
 
@@ -9,6 +11,11 @@ char logFileName[MAX_LOG_FILE_NAME_SIZE];
 // Set to true if we could successfully create a log file.
 bool loggingEnabled = false;
 
+bool sdStarted = false;
+long logSeq = -1;                         // Number of the current log file.
+int restartState = LOG_STATE_NONE;        // State saved for the previous log.
+uint32_t logDiscarded = 0;                // Bytes of torn records removed by logResume().
+
 
 // For Teensy 3.5 & 3.6 & 4.1 on-board: BUILTIN_SDCARD
 #define SD_CD_PIN = BUILTIN_SDCARD;
@@ -17,18 +24,22 @@ bool loggingEnabled = false;
 SdFat sd;
 File file;
 File root;
+File seqFile;
 #elif SD_FAT_TYPE == 1
 SdFat32 sd;
 File32 file;
 File32 root;
+File32 seqFile;
 #elif SD_FAT_TYPE == 2
 SdExFat sd;
 ExFile file;
 ExFile root;
+ExFile seqFile;
 #elif SD_FAT_TYPE == 3
 SdFs sd;
 FsFile file;
 FsFile root;
+FsFile seqFile;
 #endif  // SD_FAT_TYPE
 
 
@@ -44,62 +55,577 @@ FsFile root;
 
 
 
-int logTimeHistory [MAX_LOG_HISTORY] = {};
-int logTimeIndex = 0;
+#if defined(LOG_GROUP_COMMIT)
+/*
+ * Ring buffer of log data that has not yet been written to the card.
+ * The buffer is kept aligned with the file such that logBufTail is always the file
+ * position modulo LOG_BUFFER_SIZE. Since the buffer size is a multiple of the sector
+ * size, a sector never wraps around the end of the buffer.
+ * A text record is built in place at logBufHead (see logMessageBegin()). The extra
+ * LOG_MAX_RECORD_SIZE bytes at the end take the part of a record that runs past the
+ * end of the ring, which is moved to the start of the ring when the record is logged.
+ */
+char logBuffer[LOG_BUFFER_SIZE + LOG_MAX_RECORD_SIZE];
+unsigned int logBufHead = 0;        // Where the next logged byte will be placed.
+unsigned int logBufTail = 0;        // The next byte to be written to the card.
+unsigned int logBufCnt = 0;         // Number of bytes waiting to be written to the card.
+uint32_t unsyncedBytes = 0;         // Number of bytes logged since the last sync.
+uint32_t lastSyncTime = 0;
+#endif
+
+#if defined(LOG_PREALLOCATE)
+// Set if the log file was preallocated and log sectors are written directly to the card.
+bool logPreallocated = false;
+uint32_t logFirstSector = 0;        // First sector of the contiguous log file.
+uint32_t logSectorCnt = 0;          // Number of sectors allocated to the log file.
+uint32_t logHighWater = 0;          // Number of bytes written to the card in whole sectors.
+#endif
 
-void recordLogTimeinHistory(int logTime) {
-  // Record the log time in the history (if there is space).
-  if (logTimeIndex < MAX_LOG_HISTORY) {
-    logTimeHistory[logTimeIndex++] = logTime;
+
+/**
+ * Follow the records in a log from pos. A text record starts with '$' (or '!', see
+ * INVALID_SENTENCE_TAG) and ends with its LF. A binary $HAB record's length is taken from its header and its CRC must be correct, so that a
+ * record boundary that is really part of another record is found out.
+ *
+ * The records end at the end of the data, at zero padding that runs to the end of the
+ * data (the unused part of a sector written by logSectorDrain()), or at a record that
+ * runs past the end of the data, i.e. was torn when the power was lost.
+ *
+ * complete - set to the end of the last complete record.
+ * dataEnd - set to the end of the data, that is, the start of any padding.
+ *
+ * Return - false if pos is not a record boundary, i.e. something that is not a record
+ *          was found.
+ */
+bool logWalkRecords(const uint8_t * data, unsigned int len, unsigned int pos,
+                    unsigned int * complete, unsigned int * dataEnd) {
+  while (pos < len) {
+    if (data[pos] == 0x00) {
+      for (unsigned int i = pos + 1; i < len; i++) {
+        if (data[i] != 0x00) {
+          return false;
+        }
+      }
+      *complete = *dataEnd = pos;
+      return true;
+    }
+    if (data[pos] == HAB_REC_SYNC1) {
+      if (len - pos < HAB_REC_HEADER_SIZE) {
+        break;              // Torn in the header.
+      }
+      if (data[pos + 1] != HAB_REC_SYNC2) {
+        return false;
+      }
+      unsigned int size = HAB_REC_HEADER_SIZE + data[pos + 3] + HAB_REC_CRC_SIZE;
+      if (len - pos < size) {
+        break;
+      }
+      uint16_t crc = habCrc16(data + pos + 2, size - 2 - HAB_REC_CRC_SIZE);
+      if (data[pos + size - 2] != (crc & 0xFF) || data[pos + size - 1] != (crc >> 8)) {
+        return false;
+      }
+      pos += size;
+    } else if (data[pos] == '$' || data[pos] == '!') {
+      const uint8_t * eol = (const uint8_t *) memchr(data + pos, '\n', len - pos);
+      if (eol == NULL) {
+        // A line that was torn runs to the end of the data, one that runs into padding
+        // was not a line.
+        if (data[len - 1] == 0x00) {
+          return false;
+        }
+        break;
+      }
+      pos = eol - data + 1;
+    } else {
+      return false;
+    }
   }
+  *complete = pos;
+  *dataEnd = len;
+  return true;
 }
 
-void resetLogTimeHistory() {
-  for (int i = 0; i < MAX_LOG_HISTORY; i++) {
-    logTimeHistory[i] = -1;
+
+/**
+ * Find the records in the tail of a log (see logWalkRecords()). They are followed from
+ * the start of the tail if it is the whole log, otherwise from the first place that
+ * they can be followed from: the start of a line (a LF followed by '$' or '!'), or a
+ * binary $HAB record.
+ *
+ * Return - false if the records could not be followed from anywhere in the tail.
+ */
+bool logFindTail(const uint8_t * tail, unsigned int len, bool wholeLog,
+                 unsigned int * complete, unsigned int * dataEnd) {
+  if (wholeLog) {
+    return logWalkRecords(tail, len, 0, complete, dataEnd);
+  }
+  for (unsigned int i = 1; i < len; i++) {
+    bool boundary = (tail[i - 1] == '\n' && (tail[i] == '$' || tail[i] == '!'))
+        || (tail[i] == HAB_REC_SYNC1 && i + 1 < len && tail[i + 1] == HAB_REC_SYNC2);
+    if (boundary && logWalkRecords(tail, len, i, complete, dataEnd)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/**
+ * Find the end of the last complete record in the tail of a log (see logFindTail()).
+ * Anything after that is a record that was torn when the power was lost.
+ *
+ * Return - the number of bytes of the tail to keep.
+ */
+unsigned int logTailLength(const uint8_t * tail, unsigned int len, bool wholeLog) {
+  unsigned int complete, dataEnd;
+  if (!logFindTail(tail, len, wholeLog, &complete, &dataEnd)) {
+    return len;             // The records cannot be followed, so nothing can be checked.
+  }
+  return complete;
+}
+
+
+#if defined(LOG_PREALLOCATE)
+/*
+ * A preallocated log file is erased when it is created, so a sector that has not been
+ * written holds nothing but the card's erased value (0x00 or 0xFF). A written sector
+ * always holds part of a record that is not all 0x00 or 0xFF, since every record is
+ * shorter than a sector and starts with '$', '!' or HAB_REC_SYNC1. Any single byte,
+ * including the first, may be 0x00 or 0xFF in a binary record.
+ */
+bool isErasedSector(const uint8_t * sector) {
+  uint8_t erased = sector[0];
+  if (erased != 0x00 && erased != 0xFF) {
+    return false;
+  }
+  for (unsigned int i = 1; i < LOG_SECTOR_SIZE; i++) {
+    if (sector[i] != erased) {
+      return false;
+    }
   }
-  logTimeIndex = 0;
+  return true;
+}
+
+
+/**
+ * Allocate and erase a contiguous extent for the (empty) log file.
+ *
+ * Return - true if the file is ready for direct sector writes.
+ */
+bool preallocateLogFile() {
+  uint32_t firstSector, lastSector;
+  if (file.fileSize() != 0 || !file.preAllocate(LOG_PREALLOCATE_SIZE)) {
+    return false;
+  }
+  // exFAT does not report preallocated space as part of the file size, so we could
+  // not truncate the file later. Only FAT16/FAT32 is supported.
+  if (file.fileSize() != LOG_PREALLOCATE_SIZE
+        || !file.contiguousRange(&firstSector, &lastSector)
+        || !file.sync()
+        || !sd.card()->erase(firstSector, lastSector)) {
+    file.truncate(0);
+    return false;
+  }
+  logFirstSector = firstSector;
+  logSectorCnt = lastSector - firstSector + 1;
+  logHighWater = 0;
+  return true;
+}
+
+
+/**
+ * Find the length of the data written to a preallocated log file that was not closed.
+ * The log buffer is used as a sector buffer, so this must be done before logging starts.
+ *
+ * The written sectors are found by a binary search for the first erased sector. The
+ * last sector written may be a partial sector that was padded with zeros (see
+ * logSectorDrain()), so the end of the data in it is found by following the records
+ * (see logFindTail()). If the records cannot be followed, all of the sector is kept.
+ *
+ * Return - true if the sectors could be read.
+ */
+bool findLogLength(uint32_t firstSector, uint32_t lastSector, uint32_t * length) {
+  uint8_t * sector = (uint8_t *) logBuffer;
+
+  // Binary search for the first sector that has not been written.
+  uint32_t lo = 0;
+  uint32_t hi = lastSector - firstSector + 1;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (!sd.card()->readSector(firstSector + mid, sector)) {
+      return false;
+    }
+    if (isErasedSector(sector)) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+
+  // Then follow the records in the last one or two sectors written to find the padding.
+  *length = 0;
+  if (lo > 0) {
+    uint32_t tailSector = lo > LOG_RESUME_TAIL_SIZE / LOG_SECTOR_SIZE ? lo - LOG_RESUME_TAIL_SIZE / LOG_SECTOR_SIZE : 0;
+    unsigned int tailLen = (lo - tailSector) * LOG_SECTOR_SIZE;
+    for (uint32_t i = tailSector; i < lo; i++) {
+      if (!sd.card()->readSector(firstSector + i, sector + (i - tailSector) * LOG_SECTOR_SIZE)) {
+        return false;
+      }
+    }
+    unsigned int complete, dataEnd;
+    if (!logFindTail(sector, tailLen, tailSector == 0, &complete, &dataEnd)) {
+      dataEnd = tailLen;
+    }
+    *length = tailSector * LOG_SECTOR_SIZE + dataEnd;
+  }
+  return true;
+}
+
+
+/**
+ * Truncate a preallocated log file that was not closed (e.g. power was lost)
+ * to the length of the data that was written to it. Any other file is left alone.
+ * This must be done before logging starts (see findLogLength()).
+ *
+ * Return - true if the file was truncated.
+ */
+bool recoverLogFile(const char * fileName) {
+  uint32_t firstSector, lastSector;
+  uint32_t length = 0;
+  bool result = false;
+
+  if (!file.open(fileName, O_RDWR)) {
+    return false;
+  }
+  // A log file that is still the preallocated size was not closed.
+  if (file.fileSize() == LOG_PREALLOCATE_SIZE && file.contiguousRange(&firstSector, &lastSector)) {
+    if (findLogLength(firstSector, lastSector, &length)) {
+      result = file.truncate(length);
+    }
+    Serial.print(F("Recovered: ")); Serial.print(fileName);
+    Serial.print(F(" length: ")); Serial.println(length);
+  }
+  file.close();
+  return result;
+}
+#endif
+
+
+/**
+ * Build the name of log file number seq.
+ */
+void makeLogFileName(char * name, long seq) {
+  char wrkBuf[LOG_SEQ_DIGITS + 1];
+  strcpy(name, LOG_FILE_NAME_PREFIX);
+  strcat(name, rightJustify(wrkBuf, LOG_SEQ_DIGITS, seq, '0'));
+  strcat(name, ".");
+  strcat(name, LOG_FILE_NAME_EXT);
 }
 
-int getLogTimeFromHistory(int index) {
-  if (index < 0 || index > MAX_LOG_HISTORY) {
+
+/**
+ * Read the number of the next log file from LOG_SEQUENCE_FILE.
+ * state - if not NULL, set to the state saved with the number (see logSetState()).
+ *
+ * Return - the number, or -1 if the file is missing or damaged.
+ */
+long readLogSequence(int * state) {
+  char buf[LOG_SEQ_DIGITS + 5];
+  if (state) {
+    *state = LOG_STATE_NONE;
+  }
+  if (!seqFile.open(LOG_SEQUENCE_FILE, O_RDONLY)) {
+    return -1;
+  }
+  int n = seqFile.read(buf, sizeof(buf) - 1);
+  seqFile.close();
+  if (n < LOG_SEQ_DIGITS) {
     return -1;
   }
-  return logTimeHistory[index];
+  long seq = 0;
+  for (int i = 0; i < LOG_SEQ_DIGITS; i++) {
+    if (!isdigit(buf[i])) {
+      return -1;
+    }
+    seq = seq * 10 + buf[i] - '0';
+  }
+  // Files written before the state was added hold just the number.
+  if (state && n > LOG_SEQ_DIGITS + 1 && buf[LOG_SEQ_DIGITS] == ' ' && isdigit(buf[LOG_SEQ_DIGITS + 1])) {
+    *state = buf[LOG_SEQ_DIGITS + 1] - '0';
+  }
+  return seq;
 }
 
 
+/**
+ * Record the number of the next log file, and the state of the current log, in
+ * LOG_SEQUENCE_FILE. The record is always the same length, so once the file exists it
+ * is rewritten in place and the FAT is not touched.
+ *
+ * Return - true if successful.
+ */
+bool writeLogSequence(long seq, int state) {
+  char buf[LOG_SEQ_DIGITS + 5];
+  if (!seqFile.open(LOG_SEQUENCE_FILE, O_RDWR | O_CREAT)) {
+    return false;
+  }
+  rightJustify(buf, LOG_SEQ_DIGITS, seq, '0');
+  strcat(buf, " -\r\n");
+  if (state >= 0 && state <= 9) {
+    buf[LOG_SEQ_DIGITS + 1] = '0' + state;
+  }
+  bool result = seqFile.seekSet(0) && seqFile.write(buf, strlen(buf)) == strlen(buf);
+  result = seqFile.close() && result;
+  return result;
+}
+
 
-bool generateLogFileName(const char *, const char *) {
+/**
+ * Find the number of the next log file by scanning the root directory for the highest
+ * numbered log file. Only used if LOG_SEQUENCE_FILE is missing or damaged.
+ *
+ * Return - the number, or -1 if the directory could not be read.
+ */
+long scanLogSequence() {
   char wrkBuf[80];
-  if (sd.begin(SD_CONFIG)) {
-    int fileCnt = 0;
-    if (root.open("/")) {
-      while (file.openNext(&root, O_RDONLY)) {
-        if (file.isFile()) {
-          file.getName(wrkBuf, sizeof(wrkBuf));
-          Serial.print(wrkBuf);
-          Serial.print(": (");
-          Serial.print(file.size());
-          Serial.println(" bytes)");
-          fileCnt++;
+  unsigned int prefixLen = strlen(LOG_FILE_NAME_PREFIX);
+  long next = 0;
+  int fileCnt = 0;
+  if (!root.open("/")) {
+    return -1;
+  }
+  while (file.openNext(&root, O_RDONLY)) {
+    if (file.isFile()) {
+      fileCnt++;
+      file.getName(wrkBuf, sizeof(wrkBuf));
+      if (strncmp(wrkBuf, LOG_FILE_NAME_PREFIX, prefixLen) == 0 && isdigit(wrkBuf[prefixLen])) {
+        long seq = atol(wrkBuf + prefixLen);
+        if (seq >= next) {
+          next = seq + 1;
         }
-        file.close();
-      }
-      Serial.print("Found "); Serial.print(fileCnt); Serial.println(" files.");
-      strcpy(logFileName, LOG_FILE_NAME_PREFIX);
-      strcat(logFileName, rightJustify(wrkBuf, 4, fileCnt, '0'));
-      strcat(logFileName, ".");
-      strcat(logFileName, LOG_FILE_NAME_EXT);
-      if (file.open(logFileName, O_RDWR | O_CREAT | O_AT_END)) {
-        file.close();
-        loggingEnabled = true;
       }
     }
+    file.close();
+  }
+  root.close();
+  Serial.print(F("Scanned ")); Serial.print(fileCnt); Serial.println(F(" files."));
+  return next;
+}
+
+
+/**
+ * Start the SD card and read the state saved with the log sequence number.
+ * Nothing is written, so this can be called first thing at startup to decide whether
+ * the previous log can be resumed (see getLogRestartState()).
+ *
+ * Return - true if the card is ready.
+ */
+bool logBegin() {
+  if (!sdStarted) {
+    sdStarted = sd.begin(SD_CONFIG);
+    if (sdStarted) {
+      readLogSequence(&restartState);
+    }
+  }
+  return sdStarted;
+}
+
+
+/**
+ * Return the state saved for the previous log by logSetState(), or LOG_STATE_NONE if
+ * it was closed (or the card could not be read). Only valid after logBegin().
+ */
+int getLogRestartState() {
+  return restartState;
+}
+
+
+/**
+ * Save a state (0 to 9) for the current log, e.g. the flight phase, with the log
+ * sequence number. At the next startup getLogRestartState() returns it, unless the
+ * log was closed. LOG_STATE_NONE clears it.
+ *
+ * Return - true if successful.
+ */
+bool logSetState(int state) {
+  if (logSeq < 0) {
+    return false;
+  }
+  return writeLogSequence(logSeq + 1, state);
+}
+
+
+/**
+ * Start the SD card and create the next log file.
+ *
+ * The log files are numbered in sequence. The next number is kept in LOG_SEQUENCE_FILE,
+ * so the directory is only scanned if that file is missing or damaged. A name that is
+ * already in use (e.g. the sequence file was restored from an older card) is skipped.
+ *
+ * Return - true if logging is enabled.
+ */
+bool generateLogFileName(const char *, const char *) {
+  if (!logBegin()) {
+    return false;
+  }
+
+  long seq = readLogSequence(NULL);
+  for (int probes = 0; seq >= 0 && seq <= LOG_MAX_SEQ; probes++) {
+    makeLogFileName(logFileName, seq);
+    if (!sd.exists(logFileName)) {
+      break;
+    }
+    // Too many names in use, the sequence file is not to be trusted.
+    seq = probes < LOG_SEQ_MAX_PROBES ? seq + 1 : -1;
+  }
+  if (seq < 0) {
+    seq = scanLogSequence();
+  }
+  if (seq < 0 || seq > LOG_MAX_SEQ) {
+    Serial.println(F("No log file number available."));
+    return false;
+  }
+
+#if defined(LOG_PREALLOCATE)
+  // The previous log file is the one that may not have been closed.
+  if (seq > 0) {
+    makeLogFileName(logFileName, seq - 1);
+    recoverLogFile(logFileName);
+  }
+#endif
+  // Record the next number before the log file is created. If power is lost before the
+  // log file is created, a number is skipped, but no name is ever used twice.
+  if (!writeLogSequence(seq + 1, LOG_STATE_NONE)) {
+    Serial.println(F("*** Unable to update " LOG_SEQUENCE_FILE));
+  }
+  logSeq = seq;
+
+  makeLogFileName(logFileName, seq);
+  if (file.open(logFileName, O_RDWR | O_CREAT | O_AT_END)) {
+#if defined(LOG_PREALLOCATE)
+    logPreallocated = preallocateLogFile();
+    Serial.print(F("Log preallocated: ")); Serial.println(logPreallocated ? F("yes") : F("no"));
+#endif
+#if defined(LOG_GROUP_COMMIT)
+    // Keep the file open. Align the buffer with the end of the file so that
+    // buffer sector boundaries are also file sector boundaries.
+    logBufHead = logBufTail = file.curPosition() % LOG_BUFFER_SIZE;
+    logBufCnt = 0;
+    unsyncedBytes = 0;
+    lastSyncTime = millis();
+#else
+    file.close();
+#endif
+    loggingEnabled = true;
   }
   return loggingEnabled;
 }
 
+
+/**
+ * Reopen the previous log after a warm restart (see getLogRestartState()) and continue
+ * logging to it. Any record that was torn when the power was lost is removed, so the
+ * next record follows the last complete one. For a preallocated log, the end of the
+ * data is found on the card and the log continues with direct sector writes.
+ *
+ * Return - true if logging is enabled. If not, generateLogFileName() should be used.
+ */
+bool logResume() {
+  if (!logBegin()) {
+    return false;
+  }
+  long seq = readLogSequence(NULL) - 1;
+  if (seq < 0) {
+    return false;
+  }
+  makeLogFileName(logFileName, seq);
+  if (!file.open(logFileName, O_RDWR)) {
+    return false;
+  }
+
+  uint32_t length = file.fileSize();
+#if defined(LOG_PREALLOCATE)
+  uint32_t firstSector, lastSector;
+  logPreallocated = false;
+  if (length == LOG_PREALLOCATE_SIZE && file.contiguousRange(&firstSector, &lastSector)) {
+    if (!findLogLength(firstSector, lastSector, &length)) {
+      file.close();
+      return false;
+    }
+    logPreallocated = true;
+    logFirstSector = firstSector;
+    logSectorCnt = lastSector - firstSector + 1;
+  }
+#endif
+
+  // Check the last one or two sectors of data, starting on a sector boundary.
+#if defined(LOG_GROUP_COMMIT)
+  uint8_t * tail = (uint8_t *) logBuffer;       // Logging has not started, the buffer is free.
+#else
+  uint8_t tail[LOG_RESUME_TAIL_SIZE];
+#endif
+  uint32_t tailStart = length > LOG_RESUME_TAIL_SIZE
+      ? (length - LOG_RESUME_TAIL_SIZE + LOG_SECTOR_SIZE - 1) / LOG_SECTOR_SIZE * LOG_SECTOR_SIZE : 0;
+  unsigned int tailLen = length - tailStart;
+  if (!file.seekSet(tailStart) || file.read(tail, tailLen) != (int) tailLen) {
+    file.close();
+    return false;
+  }
+  uint32_t newLength = tailStart + logTailLength(tail, tailLen, tailStart == 0);
+  logDiscarded = length - newLength;
+
+#if defined(LOG_PREALLOCATE)
+  if (logPreallocated) {
+    // Keep the partial last sector in the buffer, where it would have been had logging
+    // continued, and erase any sector written beyond it so that a later recovery stops there.
+    logHighWater = newLength / LOG_SECTOR_SIZE * LOG_SECTOR_SIZE;
+    logBufCnt = newLength - logHighWater;
+    logBufTail = logHighWater % LOG_BUFFER_SIZE;
+    logBufHead = logBufTail + logBufCnt;
+    memmove(logBuffer + logBufTail, tail + (logHighWater - tailStart), logBufCnt);
+    uint32_t eraseFrom = (newLength + LOG_SECTOR_SIZE - 1) / LOG_SECTOR_SIZE;
+    uint32_t eraseTo = (length + LOG_SECTOR_SIZE - 1) / LOG_SECTOR_SIZE;
+    if (eraseFrom < eraseTo && !sd.card()->erase(logFirstSector + eraseFrom, logFirstSector + eraseTo - 1)) {
+      logPreallocated = false;
+      file.close();
+      return false;
+    }
+  } else
+#endif
+  {
+    if (!file.truncate(newLength) || !file.seekEnd()) {
+      file.close();
+      return false;
+    }
+#if defined(LOG_GROUP_COMMIT)
+    logBufHead = logBufTail = newLength % LOG_BUFFER_SIZE;
+    logBufCnt = 0;
+#endif
+  }
+#if defined(LOG_GROUP_COMMIT)
+  unsyncedBytes = 0;
+  lastSyncTime = millis();
+#else
+  file.close();
+#endif
+
+  logSeq = seq;
+  loggingEnabled = true;
+  Serial.print(F("Resumed: ")); Serial.print(logFileName);
+  Serial.print(F(" length: ")); Serial.print(newLength);
+  Serial.print(F(" discarded: ")); Serial.println(logDiscarded);
+  return true;
+}
+
+
+/**
+ * Return the number of bytes of torn records removed by logResume().
+ */
+uint32_t getLogDiscarded() {
+  return logDiscarded;
+}
+
+
 const char * getLogFileName() {
   return logFileName;
 }
@@ -110,30 +636,345 @@ bool isLoggingEnabled() {
 }
 
 
+#if defined(LOG_GROUP_COMMIT)
+#if defined(LOG_PREALLOCATE)
 /**
- * Log a message to the SD Card.
+ * Write buffered log data directly to the sectors of the preallocated file.
+ *
+ * A partial sector is padded with zeros and written, but is kept in the
+ * buffer so that it is rewritten once the rest of the sector is logged.
+ */
+bool logSectorDrain(bool partialSector) {
+  while (logBufCnt >= LOG_SECTOR_SIZE) {
+    // logBufTail is sector aligned, write as many sectors as we can without wrapping.
+    uint32_t sectorCnt = (LOG_BUFFER_SIZE - logBufTail) / LOG_SECTOR_SIZE;
+    if (sectorCnt > logBufCnt / LOG_SECTOR_SIZE) {
+      sectorCnt = logBufCnt / LOG_SECTOR_SIZE;
+    }
+    uint32_t sector = logHighWater / LOG_SECTOR_SIZE;
+    if (sector + sectorCnt > logSectorCnt
+          || !sd.card()->writeSectors(logFirstSector + sector, (const uint8_t *) logBuffer + logBufTail, sectorCnt)) {
+      logBufCnt = 0;
+      logBufTail = logBufHead;
+      return false;
+    }
+    logBufTail = (logBufTail + sectorCnt * LOG_SECTOR_SIZE) % LOG_BUFFER_SIZE;
+    logBufCnt -= sectorCnt * LOG_SECTOR_SIZE;
+    logHighWater += sectorCnt * LOG_SECTOR_SIZE;
+  }
+
+  if (partialSector && logBufCnt > 0) {
+    // The rest of the partial sector in the buffer is free space, so pad it in place.
+    memset(logBuffer + logBufHead, 0, LOG_SECTOR_SIZE - logBufCnt);
+    uint32_t sector = logHighWater / LOG_SECTOR_SIZE;
+    if (sector >= logSectorCnt
+          || !sd.card()->writeSector(logFirstSector + sector, (const uint8_t *) logBuffer + logBufTail)) {
+      logBufCnt = 0;
+      logBufTail = logBufHead;
+      return false;
+    }
+  }
+  return true;
+}
+#endif
+
+
+/**
+ * Write buffered log data to the card.
+ *
+ * Only whole sectors are written unless partialSector is true, in which case
+ * the buffer is completely emptied.
+ *
+ * Return - false if the card did not accept the data. The unwritten data is discarded.
+ */
+bool logBufferDrain(bool partialSector) {
+#if defined(LOG_PREALLOCATE)
+  if (logPreallocated) {
+    return logSectorDrain(partialSector);
+  }
+#endif
+  while (logBufCnt > 0) {
+    unsigned int n = LOG_SECTOR_SIZE - logBufTail % LOG_SECTOR_SIZE;
+    if (n > logBufCnt) {
+      if (!partialSector) {
+        break;              // Wait until we have the rest of the sector.
+      }
+      n = logBufCnt;
+    }
+    if (file.write(logBuffer + logBufTail, n) != n) {
+      logBufCnt = 0;
+      logBufTail = logBufHead;
+      return false;
+    }
+    logBufTail = (logBufTail + n) % LOG_BUFFER_SIZE;
+    logBufCnt -= n;
+  }
+  return true;
+}
+
+
+/**
+ * Copy data into the log buffer, writing out full sectors if the buffer fills up.
+ */
+bool logBufferAppend(const char * data, unsigned int len) {
+  while (len > 0) {
+    if (logBufCnt == LOG_BUFFER_SIZE && !logBufferDrain(false)) {
+      return false;
+    }
+    unsigned int n = LOG_BUFFER_SIZE - logBufHead;    // Space to the end of the buffer.
+    if (n > LOG_BUFFER_SIZE - logBufCnt) {
+      n = LOG_BUFFER_SIZE - logBufCnt;                // Free space in the buffer.
+    }
+    if (n > len) {
+      n = len;
+    }
+    memcpy(logBuffer + logBufHead, data, n);
+    logBufHead = (logBufHead + n) % LOG_BUFFER_SIZE;
+    logBufCnt += n;
+    unsyncedBytes += n;
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+
+/**
+ * Write everything in the log buffer to the card and commit it.
+ *
+ * Return - true if successful.
+ */
+bool logFlush() {
+  if (!isLoggingEnabled()) {
+    return false;
+  }
+  bool result = logBufferDrain(true);
+#if defined(LOG_PREALLOCATE)
+  if (logPreallocated) {
+    // The file's directory entry does not change, just make sure the card has the data.
+    result = sd.card()->syncDevice() && result;
+  } else {
+    result = file.sync() && result;
+  }
+#else
+  result = file.sync() && result;
+#endif
+  unsyncedBytes = 0;
+  lastSyncTime = millis();
+  return result;
+}
+
+
+/**
+ * Write everything in the log buffer to the card and close the log file.
+ * A preallocated log file is truncated to the length of the logged data.
+ * No further records can be logged.
+ *
+ * Return - true if successful.
+ */
+bool logClose() {
+  if (!isLoggingEnabled()) {
+    return false;
+  }
+  bool result = logFlush();
+#if defined(LOG_PREALLOCATE)
+  if (logPreallocated) {
+    result = file.truncate(logHighWater + logBufCnt) && result;
+    logPreallocated = false;
+  }
+#endif
+  result = file.close() && result;
+  loggingEnabled = false;
+  // A closed log is not resumed.
+  logSetState(LOG_STATE_NONE);
+  return result;
+}
+
+
+/**
+ * Periodic logger housekeeping. Should be called every time through loop.
+ * Commits buffered data once it has been waiting for LOG_SYNC_INTERVAL_MS.
+ */
+void logService() {
+  if (isLoggingEnabled() && unsyncedBytes > 0 && millis() - lastSyncTime >= LOG_SYNC_INTERVAL_MS) {
+    timerStart(TimerSd);
+    logFlush();
+    timerStop(TimerSd);
+  }
+}
+
+
+/**
+ * Write out what has been logged once a sync limit is reached, otherwise
+ * just any whole sectors.
+ *
+ * Return - false if the card did not accept the data.
+ */
+bool logCommit(uint32_t now) {
+  if (unsyncedBytes >= LOG_SYNC_BYTES || now - lastSyncTime >= LOG_SYNC_INTERVAL_MS) {
+    return logFlush();
+  }
+  return logBufCnt < LOG_SECTOR_SIZE || logBufferDrain(false);
+}
+
+
+// Set if the card did not accept the data written to make room for the record being built.
+bool logBeginFailed = false;
+
+/**
+ * Start a text record at the head of the log buffer, first writing out whole
+ * sectors if there is not room for the longest record.
+ *
+ * Return - a cursor to append the record to. The CR LF is added by logMessageEnd().
+ */
+FmtCursor logMessageBegin() {
+  logBeginFailed = false;
+  if (isLoggingEnabled() && LOG_BUFFER_SIZE - logBufCnt < LOG_MAX_RECORD_SIZE) {
+    timerStart(TimerSd);
+    logBeginFailed = !logBufferDrain(false);
+    timerStop(TimerSd);
+  }
+  return FmtCursor(logBuffer + logBufHead, LOG_MAX_RECORD_SIZE - 1);
+}
+
+
+/**
+ * Log the record built since logMessageBegin().
+ * The record is buffered, only whole sectors are written until the sync
+ * interval or sync byte limit is reached.
  *
  * Return - the time (ms) required to log the record.
  */
-int logMessage(const char * msg) {
-  // Serial.print("Request to log: "); Serial.println(msg);
+int logMessageEnd(FmtCursor & out) {
+  uint32_t _startTime = millis();
+  if (!isLoggingEnabled() || out.getText() != logBuffer + logBufHead) {
+    return -1;
+  }
+
+  timerStart(TimerSd);
+  unsigned int len = out.getLength();
+  char * eol = logBuffer + logBufHead + len;
+  eol[0] = '\r';
+  eol[1] = '\n';
+  len += 2;
+  if (logBufHead + len > LOG_BUFFER_SIZE) {
+    memcpy(logBuffer, logBuffer + LOG_BUFFER_SIZE, logBufHead + len - LOG_BUFFER_SIZE);
+  }
+  logBufHead = (logBufHead + len) % LOG_BUFFER_SIZE;
+  logBufCnt += len;
+  unsyncedBytes += len;
+  bool ok = logCommit(_startTime) && !logBeginFailed;
+  timerStop(TimerSd);
+  return ok ? (int) (millis() - _startTime) : -1;
+}
+
+
+/**
+ * Log a binary record to the SD Card. The record is buffered in the same way as messages.
+ *
+ * Return - the time (ms) required to log the record.
+ */
+int logRecord(const void * rec, unsigned int len) {
+  uint32_t _startTime = millis();
+  if (!isLoggingEnabled()) {
+    return -1;
+  }
+
+  timerStart(TimerSd);
+  bool ok = logBufferAppend((const char *) rec, len) && logCommit(_startTime);
+  timerStop(TimerSd);
+  return ok ? (int) (millis() - _startTime) : -1;
+}
+
+#else
+
+// The text record being built, room is left for the CR LF.
+char logRecBuf[LOG_MAX_RECORD_SIZE];
+
+/**
+ * Start a text record.
+ *
+ * Return - a cursor to append the record to. The CR LF is added by logMessageEnd().
+ */
+FmtCursor logMessageBegin() {
+  return FmtCursor(logRecBuf, LOG_MAX_RECORD_SIZE - 1);
+}
+
+
+/**
+ * Log the record built since logMessageBegin() to the SD Card.
+ *
+ * Return - the time (ms) required to log the record.
+ */
+int logMessageEnd(FmtCursor & out) {
+  uint32_t _startTime = millis();
+  if (!isLoggingEnabled() || out.getText() != logRecBuf) {
+    return -1;
+  }
+
+  timerStart(TimerSd);
+  if (file.open(logFileName, O_RDWR | O_CREAT | O_AT_END)) {
+    size_t len = out.getLength();
+    logRecBuf[len++] = '\r';
+    logRecBuf[len++] = '\n';
+    size_t n = file.write(logRecBuf, len);
+    file.close();
+    timerStop(TimerSd);
+    return n == len ? (int) (millis() - _startTime) : -1;
+  }
+  return -1;
+}
+
+
+/**
+ * Log a binary record to the SD Card.
+ *
+ * Return - the time (ms) required to log the record.
+ */
+int logRecord(const void * rec, unsigned int len) {
   uint32_t _startTime = millis();
   if (!isLoggingEnabled()) {
     return -1;
   }
 
+  timerStart(TimerSd);
   if (file.open(logFileName, O_RDWR | O_CREAT | O_AT_END)) {
-    // Serial.println("File opened, writing message");
-    file.println(msg);
-    // file.flush();
+    size_t n = file.write(rec, len);
     file.close();
-    return millis() - _startTime;
+    timerStop(TimerSd);
+    return n == len ? (int) (millis() - _startTime) : -1;
   }
   return -1;
-  
-  // boolean result = file.println(msg);
-  // file.flush();
-  // return result;
+}
+
+
+// Each record is written and closed as it is logged, so there is nothing to do.
+void logService() {
+}
+
+bool logFlush() {
+  return isLoggingEnabled();
+}
+
+bool logClose() {
+  bool result = isLoggingEnabled();
+  loggingEnabled = false;
+  logSetState(LOG_STATE_NONE);
+  return result;
+}
+
+#endif
+
+
+/**
+ * Log a message to the SD Card.
+ *
+ * Return - the time (ms) required to log the record.
+ */
+int logMessage(const char * msg) {
+  FmtCursor out = logMessageBegin();
+  out.appendText(msg);
+  return logMessageEnd(out);
 }
 
 
@@ -4,29 +4,73 @@
 #include <Arduino.h>
 
 #include "hab_config.h"
+#include "FixedFormat.h"
 #include <SdFat.h>
 #include <sdios.h>
 
 #define MAX_LOG_FILE_NAME_SIZE 12
+
+// Number of digits in a log file number (LOG_FILE_NAME_PREFIX + digits + "." + LOG_FILE_NAME_EXT).
+#define LOG_SEQ_DIGITS      4
+#define LOG_MAX_SEQ         9999L
+// Number of names in use that are skipped before the sequence file is ignored and the
+// directory is scanned.
+#define LOG_SEQ_MAX_PROBES  8
 // SD_FAT_TYPE = 0 for SdFat/File as defined in SdFatConfig.h,
 // 1 for FAT16/FAT32, 2 for exFAT, 3 for FAT16/FAT32 and exFAT.
 #define SD_FAT_TYPE 3
 
-// Number of log time history records.
-#define MAX_LOG_HISTORY     40
+// Size of an SD card sector. Buffered log data is written in multiples of this.
+#define LOG_SECTOR_SIZE 512
+
+#if defined(LOG_GROUP_COMMIT) && (LOG_BUFFER_SIZE % LOG_SECTOR_SIZE) != 0
+#error "LOG_BUFFER_SIZE must be a multiple of LOG_SECTOR_SIZE"
+#endif
+
+// Amount of the end of a log that is checked for a torn record when it is resumed.
+#define LOG_RESUME_TAIL_SIZE (2 * LOG_SECTOR_SIZE)
+
+// State saved with the log sequence number once the log is closed (see logSetState()).
+#define LOG_STATE_NONE  -1
+
+#if defined(LOG_GROUP_COMMIT) && LOG_BUFFER_SIZE < LOG_RESUME_TAIL_SIZE
+#error "LOG_BUFFER_SIZE must be at least LOG_RESUME_TAIL_SIZE"
+#endif
+
+// Longest text record, including the CR LF, that can be built with logMessageBegin().
+#define LOG_MAX_RECORD_SIZE 512
 
-// Log history functions
-extern void recordLogTimeinHistory(int);
-extern void resetLogTimeHistory();
-extern int getLogTimeFromHistory(int);
+#if defined(LOG_GROUP_COMMIT) && LOG_BUFFER_SIZE < LOG_MAX_RECORD_SIZE + LOG_SECTOR_SIZE
+#error "LOG_BUFFER_SIZE must be at least LOG_MAX_RECORD_SIZE + LOG_SECTOR_SIZE"
+#endif
 
+#if defined(LOG_PREALLOCATE) && !defined(LOG_GROUP_COMMIT)
+#error "LOG_PREALLOCATE requires LOG_GROUP_COMMIT"
+#endif
 
+extern bool logBegin();
+extern int getLogRestartState();
+extern bool logSetState(int);
 extern bool generateLogFileName(const char *, const char *);
+extern bool logResume();
+extern uint32_t getLogDiscarded();
 extern const char * getLogFileName();
 
 extern bool isLoggingEnabled();
 
+/*
+ * A text record is built in place in the log buffer: logMessageBegin() returns a
+ * cursor positioned where the record will go, the fields are appended to it, then
+ * logMessageEnd() ends the line and logs it. Nothing else may be logged in between.
+ * A record longer than LOG_MAX_RECORD_SIZE is cut short (see FmtCursor::isTruncated()).
+ */
+extern FmtCursor logMessageBegin();
+extern int logMessageEnd(FmtCursor &);
 extern int logMessage(const char *);
+extern int logRecord(const void *, unsigned int);
+extern void logService();
+extern bool logFlush();
+extern bool logClose();
 // extern bool logMessage(const __FlashStringHelper *);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "RetainedDisplay.h"
+
+// Maximum number of bytes in an I2C transmission. This matches what Adafruit_SSD1306 uses.
+#if defined(I2C_BUFFER_LENGTH)
+#define OLED_WIRE_MAX min(256, I2C_BUFFER_LENGTH)
+#elif defined(BUFFER_LENGTH)
+#define OLED_WIRE_MAX min(256, BUFFER_LENGTH)
+#elif defined(SERIAL_BUFFER_SIZE)
+#define OLED_WIRE_MAX min(255, SERIAL_BUFFER_SIZE - 1)
+#else
+#define OLED_WIRE_MAX 32
+#endif
+
+// I2C clock during and after a transfer. These are the Adafruit_SSD1306 defaults.
+#define OLED_WIRE_CLOCK       400000UL
+#define OLED_WIRE_CLOCK_AFTER 100000UL
+
+// Character cell size of the default font at text size 1.
+#define CHAR_WIDTH  6
+#define CHAR_HEIGHT 8
+
+
+RetainedDisplay::RetainedDisplay(Adafruit_SSD1306 & display, TwoWire & wire, uint8_t i2cAddr,
+                    const DisplayFieldDef * fields, uint8_t fieldCnt)
+  : display(display), wire(wire), i2cAddr(i2cAddr), fields(fields), fieldCnt(fieldCnt) {
+  if (this->fieldCnt > MAX_DISPLAY_FIELDS) {
+    this->fieldCnt = MAX_DISPLAY_FIELDS;
+  }
+  clearDirty();
+}
+
+
+void RetainedDisplay::begin() {
+  display.clearDisplay();
+  display.setTextColor(WHITE);
+  // An empty field is drawn as blank, so a field set to "" does not need to be redrawn.
+  for (uint8_t i = 0; i < fieldCnt; i++) {
+    text[i][0] = '\0';
+  }
+  markDirty(0, 0, OLED_SCREEN_WIDTH, OLED_SCREEN_HEIGHT);
+  lastRefreshTime = millis() - OLED_MIN_REFRESH_MS;
+}
+
+
+void RetainedDisplay::setField(uint8_t fieldId, const char * newText) {
+  if (fieldId >= fieldCnt) {
+    return;
+  }
+  const DisplayFieldDef & fld = fields[fieldId];
+  char * curText = text[fieldId];
+  if (strncmp(curText, newText, fld.maxChars) == 0) {
+    return;           // No change.
+  }
+  strncpy(curText, newText, fld.maxChars);
+  curText[fld.maxChars] = '\0';
+
+  int16_t w = fld.maxChars * CHAR_WIDTH * fld.textSize;
+  int16_t h = CHAR_HEIGHT * fld.textSize;
+  display.fillRect(fld.x, fld.y, w, h, BLACK);
+  display.setTextSize(fld.textSize);
+  display.setCursor(fld.x, fld.y);
+  display.print(curText);
+  markDirty(fld.x, fld.y, w, h);
+}
+
+
+void RetainedDisplay::markDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+  int16_t colStart = max(x, (int16_t) 0);
+  int16_t colEnd = min((int16_t) (x + w - 1), (int16_t) (OLED_SCREEN_WIDTH - 1));
+  int16_t pageStart = max(y, (int16_t) 0) / 8;
+  int16_t pageEnd = min((int16_t) (y + h - 1), (int16_t) (OLED_SCREEN_HEIGHT - 1)) / 8;
+  if (colStart > colEnd || pageStart > pageEnd) {
+    return;
+  }
+
+  for (int16_t page = pageStart; page <= pageEnd; page++) {
+    dirtyColMin[page] = min((int16_t) dirtyColMin[page], colStart);
+    dirtyColMax[page] = max((int16_t) dirtyColMax[page], colEnd);
+  }
+  dirty = true;
+}
+
+
+/*
+ * Mark every page as clean. A clean page has dirtyColMin > dirtyColMax.
+ */
+void RetainedDisplay::clearDirty() {
+  for (uint8_t page = 0; page < OLED_PAGE_CNT; page++) {
+    dirtyColMin[page] = 0xFF;
+    dirtyColMax[page] = 0;
+  }
+  dirty = false;
+}
+
+
+bool RetainedDisplay::refresh() {
+  if (!dirty) {
+    return false;
+  }
+  uint32_t _now = millis();
+  if (_now - lastRefreshTime < OLED_MIN_REFRESH_MS) {
+    return false;       // Too soon, send the changes later.
+  }
+  lastRefreshTime = _now;
+
+  wire.setClock(OLED_WIRE_CLOCK);
+  for (uint8_t page = 0; page < OLED_PAGE_CNT; page++) {
+    if (dirtyColMin[page] <= dirtyColMax[page]) {
+      sendPage(page, dirtyColMin[page], dirtyColMax[page]);
+    }
+  }
+  wire.setClock(OLED_WIRE_CLOCK_AFTER);
+  clearDirty();
+  return true;
+}
+
+
+/*
+ * Send the columns colStart to colEnd (inclusive) of a page from the frame buffer.
+ * The display is in horizontal addressing mode (set by Adafruit_SSD1306::begin),
+ * so we set a window and stream the data into it.
+ */
+void RetainedDisplay::sendPage(uint8_t page, uint8_t colStart, uint8_t colEnd) {
+  wire.beginTransmission(i2cAddr);
+  wire.write((uint8_t) 0x00);             // Command stream.
+  wire.write((uint8_t) SSD1306_COLUMNADDR);
+  wire.write(colStart);
+  wire.write(colEnd);
+  wire.write((uint8_t) SSD1306_PAGEADDR);
+  wire.write(page);
+  wire.write(page);
+  wire.endTransmission();
+
+  const uint8_t * p = display.getBuffer() + page * OLED_SCREEN_WIDTH + colStart;
+  uint16_t n = colEnd - colStart + 1;
+  while (n > 0) {
+    uint16_t chunk = min(n, (uint16_t) (OLED_WIRE_MAX - 1));
+    wire.beginTransmission(i2cAddr);
+    wire.write((uint8_t) 0x40);           // Data stream.
+    wire.write(p, chunk);
+    wire.endTransmission();
+    p += chunk;
+    n -= chunk;
+  }
+}
@@ -0,0 +1,72 @@
+#ifndef _RETAINEDDISPLAY_H
+#define _RETAINEDDISPLAY_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+#include "hab_config.h"
+
+// Maximum number of fields and characters per field on the display.
+#define MAX_DISPLAY_FIELDS  12
+#define MAX_FIELD_CHARS     10
+
+// Number of 8 pixel high pages on the display.
+#define OLED_PAGE_CNT (OLED_SCREEN_HEIGHT / 8)
+
+/*
+ * Position and size of a text field on the display.
+ * The field occupies maxChars characters of textSize, so it is
+ * maxChars * 6 * textSize pixels wide and 8 * textSize pixels high.
+ */
+struct DisplayFieldDef {
+  int16_t x;
+  int16_t y;
+  uint8_t textSize;
+  uint8_t maxChars;
+};
+
+
+/*
+ * A retained mode display.
+ *
+ * The display is made up of a fixed set of text fields. Only fields whose text changes
+ * are redrawn in the frame buffer, and only the pages and columns of the display that
+ * they cover are sent to the SSD1306. Transfers are limited to one every
+ * OLED_MIN_REFRESH_MS, changes made in between are sent by a later refresh().
+ */
+class RetainedDisplay {
+  public:
+    RetainedDisplay(Adafruit_SSD1306 & display, TwoWire & wire, uint8_t i2cAddr,
+                    const DisplayFieldDef * fields, uint8_t fieldCnt);
+
+    // Clear the display and schedule a full refresh.
+    void begin();
+    // Set the text of a field. Nothing is drawn if the text has not changed.
+    void setField(uint8_t fieldId, const char * text);
+    // Send the changed parts of the display if they are due.
+    // Returns true if anything was sent.
+    bool refresh();
+    // Returns true if there are changes waiting to be sent.
+    bool isPending() { return dirty; }
+
+  private:
+    void markDirty(int16_t x, int16_t y, int16_t w, int16_t h);
+    void clearDirty();
+    void sendPage(uint8_t page, uint8_t colStart, uint8_t colEnd);
+
+    Adafruit_SSD1306 & display;
+    TwoWire & wire;
+    uint8_t i2cAddr;
+    const DisplayFieldDef * fields;
+    uint8_t fieldCnt;
+
+    char text[MAX_DISPLAY_FIELDS][MAX_FIELD_CHARS + 1];
+    uint8_t dirtyColMin[OLED_PAGE_CNT];
+    uint8_t dirtyColMax[OLED_PAGE_CNT];
+    bool dirty = false;
+    uint32_t lastRefreshTime = 0;
+};
+
+#endif
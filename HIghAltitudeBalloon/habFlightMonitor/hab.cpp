@@ -25,58 +25,263 @@ OneWire oneWire(ONE_WIRE_BUS);
 DallasTemperature sensors(&oneWire);
 
 // arrays to hold device addresses
-int temperatureSensorCnt = 0;
-#define MAX_SENSOR_CNT 2
+// Only the first two sensors (INTERNAL_TEMP and EXTERNAL_TEMP) are displayed and logged,
+// but up to MAX_SENSOR_CNT sensors on the bus are read.
+unsigned int temperatureSensorCnt = 0;
+#define MAX_SENSOR_CNT 8
 DeviceAddress tempSensorAddr[MAX_SENSOR_CNT];
 double temperature[MAX_SENSOR_CNT];
 
+// Interval between temperature conversions (ms).
+#define TEMPERATURE_UPDATE_INTERVAL 1000
+
 // Include our library.
 
 #include "hab.h"
 #include "Logger.h"
+#include "GpsIngest.h"
+#include "Instrument.h"
+#include "Nmea.h"
 
-#ifdef ARDUINO_AVR_UNO
-#include <SoftwareSerial.h>
-#define RX 2
-#define TX 3
-SoftwareSerial GPS_PORT(RX, TX);
-#define SERIAL_TYPE "Software"
-#else
-#define SERIAL_TYPE "Hardware"
-#endif
 
+char gpsSentence[GPS_MAX_SENTENCE + 1];
+#define INVALID_SENTENCE_TAG '!'
 
-char gpsSentence[200];
-unsigned int gpsSentenceIdx = 0;
+// Number of sentences with an incorrect checksum, by talker ID.
+unsigned int checksumErrCnt[TalkerCnt];
 
-// Sentences to record.
+// Sentences to record (see GPS_LOG_SENTENCES).
 // Talker ID:
 // * GN - Any compination of GNSS (GP, GL, GA, GB)
 // * GP - The GPS, SBAS, QZSS systems.
 // Sentences:
 // $xxRMC - Recommended Min data: time, lat, lon, speed over ground, course over ground, date, magnetic variation, pos mode, nav status.
 // $xxGGA - System fix data: time, lat, lon, quality ind, num sat, hdop,alt,sep, differential
+// $xxGSA - DOP and active satellites.
+// $xxGSV - Satellites in view, one to nine sentences per message.
 
-const char *sentenceFilters[] = {
-  // Sentences processed by TinyGPS++
-   "$GPRMC"       // $GPRMC - GPS system: Recommended Minimum Data.
-  ,"$GPGGA"       // $GPGPA - GPS system: System Fix Data.
-  ,"$GNRMC"       // $GNGLL - General (all systems): Recommended Minimum Data.
-  ,"$GNGGA"       // $GNRMC - General (all systems): : System Fix Data.
-  // Additional sentences (None)
-  ,"$GNTXT"       // $GNTXT - General (all systems): generic text message.
-  ,"$GPTXT"       // $GPTXT - GPS system: generic text message.
+struct SentenceFilter {
+  const char * address;
+  unsigned int every;
 };
 
+const SentenceFilter sentenceFilters[] = GPS_LOG_SENTENCES;
+
+#define NMEA_TALKER_CNT (NmeaTalkerOther + 1)
+#define NMEA_TYPE_CNT   (NmeaTypeTXT + 1)
+
+// Address text of each talker ID and sentence type, for listing the filters.
+const char * const nmeaTalkerIds[NMEA_TALKER_CNT] = { "", "GP", "GL", "GA", "GB", "GQ", "GN", "P", "" };
+const char * const nmeaTypeIds[NMEA_TYPE_CNT] = { "", "RMC", "GGA", "GLL", "GSA", "GSV", "VTG", "ZDA", "TXT" };
+
+// How often each sentence is logged, indexed by the talker ID and sentence type found by
+// nmeaClassify(), so matching a sentence is a single lookup however many are logged.
+struct SentenceLogRate {
+  uint16_t every;         // Log every nth sentence, 0 = not logged.
+  uint16_t count;         // Sentences (GSV: groups) seen since the last one logged.
+  bool logging;           // The current GSV group is being logged.
+};
+
+SentenceLogRate sentenceLogRates[NMEA_TALKER_CNT][NMEA_TYPE_CNT];
+
+
+void checkFlightPhase(double, long);
+
+
+/*
+ * Count a sentence with an incorrect checksum against its talker ID.
+ */
+void countChecksumError(NmeaTalker nmeaTalker) {
+  enum GpsTalker talker = TalkerOther;
+  if (nmeaTalker == NmeaTalkerGP) {
+    talker = TalkerGP;
+  } else if (nmeaTalker == NmeaTalkerGN) {
+    talker = TalkerGN;
+  }
+  checksumErrCnt[talker]++;
+}
+
+unsigned int getChecksumErrCnt(enum GpsTalker talker) {
+  return checksumErrCnt[talker];
+}
+
+void resetChecksumErrCnt() {
+  for (int i = 0; i < TalkerCnt; i++) {
+    checksumErrCnt[i] = 0;
+  }
+}
+
+
+/*
+ * Set how often the sentences with an address are logged: every nth one, or none if
+ * every is 0. A 3 letter address (e.g. "GSV") applies to every GNSS talker ID and a
+ * proprietary one (e.g. "PUBX") to all proprietary sentences.
+ *
+ * Return - false if the address is not a sentence that is recognised.
+ */
+bool setSentenceFilter(const char * address, unsigned int every) {
+  char addr[6] = "GP";
+  size_t len = strlen(address);
+  bool anyTalker = len == 3;
+  if (len < 1 || len > 5 || every > 0xFFFF) {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++) {
+    addr[(anyTalker ? 2 : 0) + i] = toupper(address[i]);
+  }
+  addr[anyTalker ? 5 : len] = '\0';
+
+  NmeaTalker talker;
+  NmeaType type;
+  nmeaClassify(addr, strlen(addr), talker, type);
+  if (talker != NmeaTalkerProprietary
+        && (strlen(addr) != 5 || talker == NmeaTalkerOther || type == NmeaTypeUnknown)) {
+    return false;
+  }
+
+  NmeaTalker first = anyTalker ? NmeaTalkerGP : talker;
+  NmeaTalker last = anyTalker ? NmeaTalkerGN : talker;
+  for (int t = first; t <= last; t++) {
+    SentenceLogRate & rate = sentenceLogRates[t][type];
+    rate.every = every;
+    rate.count = 0;
+    rate.logging = false;
+  }
+  return true;
+}
+
+
+/*
+ * Load the sentence filters from GPS_LOG_SENTENCES.
+ */
+void initSentenceFilters() {
+  memset(sentenceLogRates, 0, sizeof(sentenceLogRates));
+  for (unsigned int i = 0; i < ARRAY_SIZE(sentenceFilters); i++) {
+    if (!setSentenceFilter(sentenceFilters[i].address, sentenceFilters[i].every)) {
+      Serial.print(F("*** Invalid GPS_LOG_SENTENCES address: ")); Serial.println(sentenceFilters[i].address);
+    }
+  }
+}
+
+
+/*
+ * List the sentences being logged on the console, e.g. "GPRMC GPGSV/10".
+ */
+void printSentenceFilters() {
+  Serial.print(F("Logged sentences:"));
+  for (int t = 0; t < NMEA_TALKER_CNT; t++) {
+    for (int ty = 0; ty < NMEA_TYPE_CNT; ty++) {
+      const SentenceLogRate & rate = sentenceLogRates[t][ty];
+      if (rate.every == 0) {
+        continue;
+      }
+      Serial.print(' '); Serial.print(nmeaTalkerIds[t]);
+      Serial.print(t == NmeaTalkerProprietary ? "*" : nmeaTypeIds[ty]);
+      if (rate.every > 1) {
+        Serial.print('/'); Serial.print(rate.every);
+      }
+    }
+  }
+  Serial.println();
+}
+
+
+/*
+ * Return true if a sentence is the first of its message, i.e. a GSV sentence whose
+ * message number (the second field) is 1.
+ */
+bool isFirstOfGroup(const char * sentence) {
+  const char * p = strchr(sentence, ',');
+  if (p) {
+    p = strchr(p + 1, ',');
+  }
+  return !p || (p[1] == '1' && p[2] == ',');
+}
+
 
+/*
+ * Decide whether a sentence is logged, counting it towards its filter's decimation.
+ * The sentences of a GSV message follow the decision made for its first sentence.
+ */
+bool isSentenceLogged(NmeaTalker talker, NmeaType type, const char * sentence) {
+  SentenceLogRate & rate = sentenceLogRates[talker][type];
+  if (rate.every == 0) {
+    return false;
+  }
+  if (type == NmeaTypeGSV && !isFirstOfGroup(sentence)) {
+    return rate.logging;
+  }
+  rate.logging = rate.count == 0;
+  if (++rate.count >= rate.every) {
+    rate.count = 0;
+  }
+  return rate.logging;
+}
+
+
+/*
+ * Process the complete sentences received from the GPS.
+ * Each sentence is echoed to the console, passed to TinyGPS++ and, if its filter
+ * (see setSentenceFilter()) says so, logged.
+ * The checksum is verified as the sentence is received (see GpsIngest). Sentences that
+ * fail are counted and are logged with a leading INVALID_SENTENCE_TAG, or not logged
+ * if GPS_SKIP_INVALID_SENTENCES is defined.
+ *
+ * Return - 1 if new GPS data is available.
+ */
 int checkGPSData() {
+  timerStart(TimerGps);
+#if !defined(GPS_INGEST_ISR)
+  gpsIngestPoll();          // No timer interrupt, so collect the received bytes here.
+#endif
 
-#if defined(TEST_MODE)
-  while (GPS_PORT.available()) {
-    char ch = GPS_PORT.read();
-    Serial.print(ch);
-    gps.encode(ch);
+  char * sentence = gpsSentence;
+  int len;
+  bool checksumOk;
+  bool drained = false;
+  while ((len = gpsReadSentence(sentence, GPS_MAX_SENTENCE, &checksumOk)) > 0) {
+    drained = true;
+    Serial.write(sentence, len);
+    for (int i = 0; i < len; i++) {
+      gps.encode(sentence[i]);
+    }
+    // Remove the line terminator before logging.
+    while (len > 0 && (sentence[len - 1] == '\n' || sentence[len - 1] == '\r')) {
+      len--;
+    }
+    sentence[len] = '\0';
+    if (len == 0) {
+      continue;
+    }
+    // Only the address field is examined, the checksum was verified when it was received.
+    NmeaTalker talker = NmeaTalkerUnknown;
+    NmeaType type = NmeaTypeUnknown;
+    if (sentence[0] == '$') {
+      nmeaClassify(sentence + 1, len - 1, talker, type);
+    }
+    if (!checksumOk) {
+      countChecksumError(talker);
+#if defined(GPS_SKIP_INVALID_SENTENCES)
+      continue;
+#endif
+    }
+#if !defined(TEST_MODE)
+    if (isSentenceLogged(talker, type, sentence)) {
+      // Copied straight from the sentence buffer into the log buffer.
+      FmtCursor out = logMessageBegin();
+      if (!checksumOk) {
+        out.appendChar(INVALID_SENTENCE_TAG);
+      }
+      out.appendText(sentence, len);
+      logMessageEnd(out);
+    }
+#endif
+  }
+  if (drained) {
+    timerStop(TimerGps);      // Only passes that had sentences to process are timed.
   }
+
+#if defined(TEST_MODE)
   // TODO Remove this in favour of using the actual GPS data to determine "new data" status.
   static uint32_t lastUpdateTime;  
   uint32_t updateInterval = 5000;       // TODO remove this
@@ -89,72 +294,22 @@ int checkGPSData() {
   }
   return 0;
 #else
-  while (GPS_PORT.available()) {
-    char ch = GPS_PORT.read();
-    if (ch == '\n' || ch == '\r') {
-      if (gpsSentenceIdx != 0) {
-        for (unsigned int i = 0; i < ARRAY_SIZE(sentenceFilters); i++) {
-          int result = strncmp(sentenceFilters[i], gpsSentence, strlen(sentenceFilters[i]));
-          if (result == 0) {
-            int logTime = logMessage(gpsSentence);
-            recordLogTimeinHistory(logTime);
-            break;
-          }
-        }
-        gpsSentenceIdx = 0;
-        gpsSentence[gpsSentenceIdx] = '\0';
-      }
-    } else if (gpsSentenceIdx < sizeof(gpsSentence)) {
-      gpsSentence[gpsSentenceIdx++] = ch;
-      gpsSentence[gpsSentenceIdx] = '\0';
-    }
-    Serial.print(ch);
-    gps.encode(ch);
-  }
-  if (gps.location.isUpdated()
-        || gps.altitude.isUpdated()
+  // Reading a value clears its updated flag, so check for new data before the phase does.
+  bool altUpdated = gps.altitude.isUpdated();
+  bool newData = gps.location.isUpdated()
+        || altUpdated
         || gps.time.isUpdated()
         // || gps.hdop.isUpdated()
-        || gps.satellites.isUpdated()
-      ) {
-    return 1;
+        || gps.satellites.isUpdated();
+  if (altUpdated && gps.altitude.isValid() && gps.time.isValid()) {
+    checkFlightPhase(gps.altitude.meters(), gps.time.hour() * 3600L + gps.time.minute() * 60L + gps.time.second());
   }
-  return 0;
+  return newData ? 1 : 0;
 #endif
 }
 
 
 
-int tempCnt = 0;
-uint32_t sumTempUpdateTime = 0;
-uint32_t slowestTempUpdateTime = 0;
-void logTempTime(uint32_t startTime) {
-  tempCnt += 1;
-  uint32_t updTime = millis() - startTime;
-  if (updTime > slowestTempUpdateTime) {
-    slowestTempUpdateTime = updTime;
-  }
-  sumTempUpdateTime += updTime;
-}
-
-
-
-int getTempUpdCnt() {
-  return tempCnt;
-}
-uint32_t getSumTempUpdateTime() {
-  return sumTempUpdateTime;
-}
-uint32_t getSlowestTempUpdateTime() {
-  return slowestTempUpdateTime;
-}
-void resetTempMetrics() {
-  tempCnt = 0;
-  sumTempUpdateTime = 0;
-  slowestTempUpdateTime = 0;
-}
-
-
 void dumpStr(const char * lbl, const char *buf, int bufSize) {
   Serial.print(lbl);
   Serial.print(": Hex: ");
@@ -167,20 +322,58 @@ void dumpStr(const char * lbl, const char *buf, int bufSize) {
 
 
 
+/*
+ * Temperature acquisition is split into phases so that the loop is never blocked
+ * waiting for the DS18B20s to complete a conversion:
+ *   TempIdle       - wait for the update interval, then start a conversion on all sensors.
+ *   TempConverting - wait for the conversion time for TEMPERATURE_PRECISION.
+ *   TempReading    - read one sensor each time through the loop.
+ * TimerTemp records the time spent on the bus by each of these steps, which is how
+ * long the loop was held up.
+ */
+enum TempState {
+  TempIdle, TempConverting, TempReading
+};
+
 int checkTemperatureData() {
+static enum TempState state = TempIdle;
 static uint32_t lastUpdateTime;
-unsigned long updateInterval = 1000;
+static uint32_t conversionTime;
+static unsigned int sensorIdx;
 
   uint32_t _now = millis();
-  if (_now - lastUpdateTime > updateInterval) {
-    lastUpdateTime = _now;
-    // Serial.println(F("Checking temperature"));
-    sensors.requestTemperatures();
-    for (unsigned int i = 0; i < ARRAY_SIZE(tempSensorAddr); i++) {
-      temperature[i] = sensors.getTempC(tempSensorAddr[i]);
-    }
-    logTempTime(_now);
-    return 1;
+  switch (state) {
+    case TempIdle:
+      if (_now - lastUpdateTime > TEMPERATURE_UPDATE_INTERVAL) {
+        lastUpdateTime = _now;
+        // Serial.println(F("Checking temperature"));
+        timerStart(TimerTemp);
+        sensors.requestTemperatures();    // Returns immediately, see initTemperatureSensors.
+        conversionTime = sensors.millisToWaitForConversion(TEMPERATURE_PRECISION);
+        timerStop(TimerTemp);
+        state = TempConverting;
+      }
+      break;
+
+    case TempConverting:
+      if (_now - lastUpdateTime >= conversionTime) {
+        sensorIdx = 0;
+        state = TempReading;
+      }
+      break;
+
+    case TempReading:
+      if (sensorIdx < temperatureSensorCnt) {
+        timerStart(TimerTemp);
+        temperature[sensorIdx] = sensors.getTempC(tempSensorAddr[sensorIdx]);
+        timerStop(TimerTemp);
+        sensorIdx++;
+      }
+      if (sensorIdx >= temperatureSensorCnt) {
+        state = TempIdle;
+        return 1;
+      }
+      break;
   }
   return 0;
 }
@@ -274,6 +467,187 @@ const uint32_t ledBlinkInterval = 250;
 }
 
 
+/*
+ * Flight phase detection.
+ *
+ * The vertical speed is found from each new altitude fix (using the GPS time of the fix,
+ * so a backlog of sentences does not distort it) and filtered with a time constant of
+ * PHASE_VS_FILTER_SECS. The phase changes when the filtered speed has indicated a new
+ * phase for PHASE_CONFIRM_MS:
+ *   Pad     -> Ascent    climbing faster than PHASE_ASCENT_VS.
+ *   Ascent  -> Float     within PHASE_FLOAT_VS of level, PHASE_MIN_FLOAT_ALT above the pad.
+ *   Ascent, Float -> Descent   falling faster than PHASE_DESCENT_VS (e.g. a slow leak).
+ *   Float, Landed -> Ascent    climbing again.
+ *   Descent -> Landed    within PHASE_FLOAT_VS of level.
+ * A burst is found from the unfiltered speed (PHASE_BURST_VS) and is confirmed after
+ * PHASE_BURST_CONFIRM_MS. The phase becomes Descent PHASE_BURST_MS later.
+ */
+const char * const flightPhaseNames[PhaseCnt] = { "pad", "ascent", "float", "burst", "descent", "landed" };
+const uint32_t phaseLogIntervalMs[PhaseCnt] = LOG_PHASE_INTERVALS_MS;
+const unsigned int phaseLogBudget[PhaseCnt] = LOG_PHASE_BUDGETS;
+
+enum FlightPhase flightPhase = PhasePad;
+enum FlightPhase candidatePhase = PhasePad;     // The phase currently indicated.
+uint32_t candidateSinceMs = 0;
+uint32_t phaseStartMs = 0;
+bool phaseChanged = false;                      // Set once the phase has changed from Pad.
+unsigned int phaseLogCnt[PhaseCnt];             // $HAB records logged in each phase.
+
+double padAlt = 0.0;
+double verticalSpeed = 0.0;                     // Filtered (m/s).
+double prevPhaseAlt = 0.0;
+long prevPhaseTime = -1;                        // GPS time (s since midnight) of the previous fix.
+
+
+void setFlightPhase(enum FlightPhase phase, uint32_t now) {
+  flightPhase = candidatePhase = phase;
+  phaseStartMs = now;
+  phaseChanged = true;
+  // Saved with the log, so that a reset during the flight can resume it.
+  logSetState(phase);
+  Serial.print(F("Flight phase: ")); Serial.print(flightPhaseNames[phase]);
+  Serial.print(F(" vs=")); Serial.println(verticalSpeed, 1);
+}
+
+
+/*
+ * Update the flight phase with a new altitude fix.
+ * time - the GPS time of the fix (seconds since midnight).
+ */
+void checkFlightPhase(double alt, long time) {
+  uint32_t _now = millis();
+  if (prevPhaseTime < 0) {
+    prevPhaseTime = time;
+    prevPhaseAlt = alt;
+    if (flightPhase == PhasePad) {
+      padAlt = alt;
+    }
+    return;
+  }
+  long dt = time - prevPhaseTime;
+  if (dt < 0) {
+    dt += 24 * 3600L;             // Past midnight.
+  }
+  if (dt == 0) {
+    return;                       // The same fix.
+  }
+  double vs = (alt - prevPhaseAlt) / dt;
+  verticalSpeed += dt / (PHASE_VS_FILTER_SECS + dt) * (vs - verticalSpeed);
+  prevPhaseTime = time;
+  prevPhaseAlt = alt;
+
+  enum FlightPhase indicated = flightPhase;
+  uint32_t confirmMs = PHASE_CONFIRM_MS;
+  switch (flightPhase) {
+    case PhasePad:
+      padAlt = alt;
+      if (verticalSpeed > PHASE_ASCENT_VS) {
+        indicated = PhaseAscent;
+      }
+      break;
+
+    case PhaseAscent:
+    case PhaseFloat:
+      if (vs < PHASE_BURST_VS) {
+        indicated = PhaseBurst;
+        confirmMs = PHASE_BURST_CONFIRM_MS;
+      } else if (verticalSpeed < PHASE_DESCENT_VS) {
+        indicated = PhaseDescent;
+      } else if (flightPhase == PhaseAscent && fabs(verticalSpeed) < PHASE_FLOAT_VS && alt > padAlt + PHASE_MIN_FLOAT_ALT) {
+        indicated = PhaseFloat;
+      } else if (flightPhase == PhaseFloat && verticalSpeed > PHASE_ASCENT_VS) {
+        indicated = PhaseAscent;
+      }
+      break;
+
+    case PhaseBurst:
+      if (_now - phaseStartMs >= PHASE_BURST_MS) {
+        setFlightPhase(PhaseDescent, _now);
+      }
+      return;
+
+    case PhaseDescent:
+      if (fabs(verticalSpeed) < PHASE_FLOAT_VS) {
+        indicated = PhaseLanded;
+      }
+      break;
+
+    case PhaseLanded:
+      if (verticalSpeed > PHASE_ASCENT_VS) {
+        indicated = PhaseAscent;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  if (indicated == flightPhase) {
+    candidatePhase = flightPhase;
+  } else if (indicated != candidatePhase) {
+    candidatePhase = indicated;
+    candidateSinceMs = _now;
+  } else if (_now - candidateSinceMs >= confirmMs) {
+    setFlightPhase(indicated, _now);
+  }
+}
+
+
+/*
+ * Continue in the phase saved with the log after a warm restart. The records are
+ * logged at the transition rate for a while to cover the gap. The launch altitude
+ * is not known, so it is taken to be sea level.
+ */
+void resumeFlightPhase(enum FlightPhase phase) {
+  flightPhase = candidatePhase = phase;
+  phaseStartMs = millis();
+  phaseChanged = true;
+  padAlt = 0.0;
+  Serial.print(F("Flight phase resumed: ")); Serial.println(flightPhaseNames[phase]);
+}
+
+
+enum FlightPhase getFlightPhase() {
+  return flightPhase;
+}
+
+
+const char * getFlightPhaseName(enum FlightPhase phase) {
+  return phase < PhaseCnt ? flightPhaseNames[phase] : "?";
+}
+
+
+double getVerticalSpeed() {
+  return verticalSpeed;
+}
+
+
+/*
+ * Return the interval (ms) between $HAB records for the current phase.
+ * The rate is raised around a phase change, and lowered once the phase has logged
+ * its budget of records.
+ */
+uint32_t getLogInterval() {
+  uint32_t interval = phaseLogIntervalMs[flightPhase];
+  if (candidatePhase != flightPhase || (phaseChanged && millis() - phaseStartMs < LOG_TRANSITION_MS)) {
+    interval = LOG_TRANSITION_INTERVAL_MS;
+  }
+  if (phaseLogCnt[flightPhase] >= phaseLogBudget[flightPhase] && interval < LOG_BUDGET_INTERVAL_MS) {
+    interval = LOG_BUDGET_INTERVAL_MS;
+  }
+  return interval;
+}
+
+
+/*
+ * Count a $HAB record against the current phase's budget.
+ */
+void countLogRecord() {
+  phaseLogCnt[flightPhase]++;
+}
+
+
+
 double getHdop(void) {
 #ifdef TEST_MODE
   return random(0, 5000L) / 1000.0;
@@ -355,7 +729,7 @@ double getTemperature(int sensorId) {
 #ifdef TEST_MODE
   return random(0,160)/2.0 - 40;
 #else
-  if (sensorId >= 0 && sensorId < ARRAY_SIZE(temperature)) {
+  if (sensorId >= 0 && sensorId < (int) ARRAY_SIZE(temperature)) {
     return temperature[sensorId];
   } else {
     return -99.99;
@@ -440,6 +814,9 @@ void initTemperatureSensors(Adafruit_SSD1306 & display) {
   Serial.print(F("Found "));
   temperatureSensorCnt = sensors.getDeviceCount();
   Serial.print(temperatureSensorCnt);
+  if (temperatureSensorCnt > MAX_SENSOR_CNT) {
+    temperatureSensorCnt = MAX_SENSOR_CNT;
+  }
   Serial.println(F(" devices."));
   display.print("Found ");
   display.print(temperatureSensorCnt);
@@ -451,7 +828,14 @@ void initTemperatureSensors(Adafruit_SSD1306 & display) {
   if (sensors.isParasitePowerMode()) Serial.println("ON");
   else Serial.println("OFF");
 
-  for (unsigned int i = 0; i < ARRAY_SIZE(tempSensorAddr); i++) {
+  // Don't wait for conversions to complete, checkTemperatureData() collects the results later.
+  sensors.setWaitForConversion(false);
+
+  for (unsigned int i = 0; i < ARRAY_SIZE(temperature); i++) {
+    temperature[i] = DEVICE_DISCONNECTED_C;
+  }
+
+  for (unsigned int i = 0; i < temperatureSensorCnt; i++) {
     if (sensors.getAddress(tempSensorAddr[i], i)) {
       sensors.setResolution(tempSensorAddr[i], TEMPERATURE_PRECISION);
       Serial.print(F("Found ds18b20 "));
@@ -484,7 +868,6 @@ void initHab(Adafruit_SSD1306 & display) {
   delay(100);
   altitudeRecordLedOn(false);
   heaterOn(false);
-  GPS_PORT.begin(GPS_BAUD);
-
-  resetLogTimeHistory();
+  initSentenceFilters();
+  gpsIngestBegin();
 }
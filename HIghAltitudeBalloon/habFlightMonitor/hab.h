@@ -23,6 +23,17 @@ enum AltitudeRecordState getAaltitudeRecordState();
 
 extern void initHab(Adafruit_SSD1306 & display);
 extern int checkGPSData();
+
+// Talker IDs for which checksum errors are counted.
+enum GpsTalker {
+  TalkerGP, TalkerGN, TalkerOther, TalkerCnt
+};
+
+extern bool setSentenceFilter(const char *, unsigned int);
+extern void printSentenceFilters(void);
+
+extern unsigned int getChecksumErrCnt(enum GpsTalker);
+extern void resetChecksumErrCnt(void);
 extern int checkTemperatureData();
 
 extern double getLat(void);
@@ -47,10 +58,17 @@ extern boolean isTimeValid(void);
 
 extern double getTemperature(int);
 
-extern int getTempUpdCnt(void);
-extern uint32_t getSumTempUpdateTime(void);
-extern uint32_t getSlowestTempUpdateTime(void);
-extern void resetTempMetrics(void);
+// Flight phases, in the order of the LOG_PHASE_xxx tables in hab_config.h.
+enum FlightPhase {
+  PhasePad, PhaseAscent, PhaseFloat, PhaseBurst, PhaseDescent, PhaseLanded, PhaseCnt
+};
+
+extern enum FlightPhase getFlightPhase(void);
+extern void resumeFlightPhase(enum FlightPhase);
+extern const char * getFlightPhaseName(enum FlightPhase);
+extern double getVerticalSpeed(void);
+extern uint32_t getLogInterval(void);
+extern void countLogRecord(void);
 
 
 extern boolean checkHeater(double, double);
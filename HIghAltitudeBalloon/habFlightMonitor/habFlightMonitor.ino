@@ -2,6 +2,99 @@
  * Program to monitor and log a High Altitude Balloon
  * flight.
  *
+ *  v1.13.06.00 gm310509 17-10-2026
+ *    * On AVR the latency histogram halves every bucket when one fills,
+ *      rather than letting it stop counting, which made p50, p90 and p99
+ *      of the loop timer report about the maximum.
+ *  v1.13.05.00 gm310509 17-10-2026
+ *    * Console command "close" writes out and closes the log, which
+ *      truncates a preallocated log to its length. Otherwise an unclosed
+ *      log is recovered at the next startup.
+ *  v1.13.04.00 gm310509 17-10-2026
+ *    * Fixed recovery of an unclosed preallocated log with binary records.
+ *      A sector is only taken to be unwritten if all of it is erased, and
+ *      the end of the data is found by following the records rather than
+ *      by stripping 0x00 / 0xFF bytes, which a binary record may hold.
+ *  v1.13.03.00 gm310509 17-10-2026
+ *    * The logged GPS sentences are set by GPS_LOG_SENTENCES in hab_config.h
+ *      and matched with a single table lookup. Each can be logged every nth
+ *      time (GSV by whole message) to limit the amount written to the card.
+ *    * Console command "nmea [address n]" lists or changes the logged
+ *      sentences while running.
+ *  v1.13.02.00 gm310509 17-10-2026
+ *    * Text records ($HAB, headers and NMEA sentences) are built in place
+ *      in the log buffer (logMessageBegin / logMessageEnd), without a
+ *      separate record buffer. A record too long for LOG_MAX_RECORD_SIZE
+ *      is cut short and reported on the console.
+ *  v1.13.01.00 gm310509 17-10-2026
+ *    * Numbers are formatted with integer fixed point arithmetic
+ *      (FixedFormat.h). The text $HAB record no longer needs sprintf
+ *      float support, and rightJustifyF no longer has rounding artifacts
+ *      in the fraction digits.
+ *
+ *  v1.13.00.00 gm310509 17-10-2026
+ *    * Warm restart (LOG_WARM_RESTART). After a reset during the flight
+ *      the splash and serial delays are skipped, any record torn by the
+ *      reset is removed and logging resumes in the previous log, after a
+ *      $HABRS record that marks the gap. The flight phase is saved with
+ *      the log sequence number so that it survives the reset.
+ *
+ *  v1.12.00.00 gm310509 17-10-2026
+ *    * The flight phase (pad, ascent, float, burst, descent, landed) is
+ *      found from the filtered vertical speed. The $HAB record interval
+ *      is set per phase, raised around phase changes and capped by a per
+ *      phase budget. This replaces the altitude threshold log rates.
+ *
+ *  v1.11.01.00 gm310509 17-10-2026
+ *    * The next log file number is kept on the card (LOG_SEQUENCE_FILE), so
+ *      the directory is no longer listed at startup. It is only scanned, for
+ *      the highest numbered log, if the sequence file is lost.
+ *
+ *  v1.11.00.00 gm310509 17-10-2026
+ *    * Loop latency instrumentation (Instrument.h). The whole loop, GPS
+ *      drain, temperature, OLED and SD write stages are timed (us) into
+ *      log-linear histograms, which are summarised (count, p50, p90, p99,
+ *      max) in each $HAB record and reset. These replace the oledUpd,
+ *      tempUpd, sumLogTimeMs and logHist fields.
+ *
+ *  v1.10.01.00 gm310509 17-10-2026
+ *    * GPS sentences are matched against the log filter by talker and type
+ *      using the shared NMEA tokenizer (Nmea.h).
+ *
+ *  v1.10.00.00 gm310509 17-10-2026
+ *    * GPS sentence checksums are verified as they are received. Invalid
+ *      sentences are logged with a leading '!' (or skipped, see
+ *      GPS_SKIP_INVALID_SENTENCES) and counted by talker ID in the $HAB
+ *      record (chkErrGP, chkErrGN, chkErrOther).
+ *
+ *  v1.09.00.00 gm310509 17-10-2026
+ *    * GPS data is received into a ring buffer by a timer interrupt
+ *      (GpsIngest) and complete sentences are processed by the loop.
+ *    * Added gpsOvfCnt and gpsHighWater to the $HAB record.
+ *
+ *  v1.08.00.00 gm310509 17-10-2026
+ *    * updateDisplayV2 uses a retained mode display (RetainedDisplay). Only
+ *      fields that change are redrawn and only their pages are sent to the
+ *      OLED, at most once every OLED_MIN_REFRESH_MS.
+ *
+ *  v1.07.00.00 gm310509 17-10-2026
+ *    * Temperature sensors are read without blocking: the conversion is
+ *      started, then one sensor is read per loop once it has completed.
+ *      Up to 8 sensors are supported. tempUpd metrics now time each bus step.
+ *
+ *  v1.06.00.00 gm310509 17-10-2026
+ *    * Optional compact binary $HAB record (LOG_BINARY_HAB). See HabRecord.h
+ *      and GPSCheckSum/habdecode.cpp.
+ *
+ *  v1.05.00.00 gm310509 17-10-2026
+ *    * Log file is preallocated as a contiguous extent and log sectors are
+ *      written directly into it (LOG_PREALLOCATE). An unclosed log is
+ *      truncated to its real length at the next startup.
+ *
+ *  v1.04.00.00 gm310509 17-10-2026
+ *    * Log file is held open and records are written to the SD card in
+ *      whole sectors from a RAM buffer (LOG_GROUP_COMMIT).
+ *
  *  v1.03.02.00 gm310509 31-05-2024
  *    * modified logging to allow for a history of log times.
  *    * modified the $HAB record to output the history of log times 
@@ -32,13 +125,19 @@
  *  
  */
 
-#define VERSION "v1.03.02.00"
+#define VERSION "v1.13.06.00"
 
 
 // HAB stuff
 #include "hab.h"
 #include "Utility.h"
 #include "Logger.h"
+#include "HabRecord.h"
+#include "GpsIngest.h"
+#include "Instrument.h"
+#include "FixedFormat.h"
+
+static_assert(TimerCnt == HAB_REC_TIMER_CNT, "The $HAB record does not match the timers");
 
 
 // OLED stuff.
@@ -46,6 +145,7 @@
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include "RetainedDisplay.h"
 
 
 
@@ -63,25 +163,30 @@
 
 Adafruit_SSD1306 display(OLED_SCREEN_WIDTH, OLED_SCREEN_HEIGHT, & OLED_PORT, OLED_RESET);
 
+// Fields displayed by updateDisplayV2.
+enum OledField {
+  FldTime, FldAlt, FldAltUnit, FldAltRecord,
+  FldTemp1, FldTemp1Unit, FldHeater,
+  FldTemp2, FldTemp2Unit, FldRecord
+};
 
+const DisplayFieldDef oledLayout[] = {
+  //  x,  y, size, chars
+  {   0,  0,   2,  10 },    // FldTime
+  {   0, 16,   2,  10 },    // FldAlt
+  { 120, 16,   1,   1 },    // FldAltUnit
+  { 120, 24,   1,   1 },    // FldAltRecord
+  {   0, 32,   2,   5 },    // FldTemp1
+  {  60, 32,   2,   2 },    // FldTemp1Unit
+  {  84, 32,   2,   2 },    // FldHeater
+  {   0, 48,   2,   5 },    // FldTemp2
+  {  60, 48,   2,   2 },    // FldTemp2Unit
+  {  84, 48,   2,   2 },    // FldRecord
+};
+
+RetainedDisplay oled(display, OLED_PORT, OLED_SCREEN_ADDRESS, oledLayout, ARRAY_SIZE(oledLayout));
 
-int oledCnt = 0;
-uint32_t sumOledUpdateTime = 0;
-uint32_t slowestOledUpdateTime = 0;
-void logOledTime(uint32_t startTime) {
-  oledCnt += 1;
-  uint32_t updTime = millis() - startTime;
-  if (updTime > slowestOledUpdateTime) {
-    slowestOledUpdateTime = updTime;
-  }
-  sumOledUpdateTime += updTime;
-}
 
-void resetOledTime() {
-  oledCnt = 0;
-  sumOledUpdateTime = 0;
-  slowestOledUpdateTime = 0;
-}
 
 // void dumpStr(const char * lbl, const char *buf, int bufSize) {
 //   Serial.print(lbl);
@@ -101,16 +206,30 @@ void logHeader() {
   // logMessage(F("$GPGGA,time,lat,ns,lon,ew,quality,numSV,hdop,alt,altU,sep,sepU,diffAge,diffStation,chksum"));
   // logMessage(F("$GNRMC,time,status,lat,ns,lon,ew,spdKnot,cog,date,mv,mvEW,posMode,navStatus,chksum"));
   // logMessage(F("$GNGGA,time,lat,ns,lon,ew,quality,numSV,hdop,alt,altU,sep,sepU,diffAge,diffStation,chksum"));
-  logMessage("$HAB,UTCTime,lat,lon,alt,hdop,satCnt,T1,T2,battV,oledUpdCnt,oledUpdSumTime,oledUpdMaxTime,tempUpdCnt,tempUpdSumTime,tempUpdMaxTime,sumLogTimeMs,logCnt,logHist0,logHist1,logHist2,logHist3,logHist4,logHist5,logHist6,logHist7,logHist8,logHist9,logHist10,logHist11,logHist12,logHist13,logHist14,logHist15,logHist16,logHist17,logHist18,logHist19");
+  logMessage(HAB_LOG_HEADER);
   logMessage("$GPRMC,time,status,lat,ns,lon,ew,spdKnot,cog,date,mv,mvEW,posMode,navStatus,chksum");
   logMessage("$GPGGA,time,lat,ns,lon,ew,quality,numSV,hdop,alt,altU,sep,sepU,diffAge,diffStation,chksum");
   logMessage("$GNRMC,time,status,lat,ns,lon,ew,spdKnot,cog,date,mv,mvEW,posMode,navStatus,chksum");
   logMessage("$GNGGA,time,lat,ns,lon,ew,quality,numSV,hdop,alt,altU,sep,sepU,diffAge,diffStation,chksum");
   logMessage("$GNTXT,numMsg,msgNum,msgType,text,chksum");
   logMessage("$GPTXT,numMsg,msgNum,msgType,text,chksum");
+  logMessage(HAB_RESTART_HEADER);
 
 }
 
+/*
+ * Mark a warm restart in the log (see HAB_RESTART_HEADER), so that the gap in the
+ * records can be found after the flight.
+ */
+void logRestart() {
+  FmtCursor out = logMessageBegin();
+  out.appendText("$HABRS,").appendUnsigned(millis()).appendSeparator().appendUnsigned(getLogDiscarded());
+  out.appendSeparator().appendText(getFlightPhaseName(getFlightPhase())).appendSeparator().appendText(VERSION);
+  if (logMessageEnd(out) == -1) {
+    Serial.println(F("*** Failed to log $HABRS record"));
+  }
+}
+
 void logData (int hour, int minute, int second, bool timeValid,
               double lat, double lon, bool locValid,
               double alt, bool altValid, bool recordBroken,
@@ -120,67 +239,113 @@ void logData (int hour, int minute, int second, bool timeValid,
               double battV) {
 
 static uint32_t prevLogTime = 0;
-static uint32_t logInterval = LOG_LOW_RATE_MS;
 static unsigned int logCnt = 0;
-static uint32_t logCumulativeTimeMs = 0;
 
 
   uint32_t _now = millis();
-  char logRec [400];
-  char wrkBuf[100];      // Workbuffer for any numeric conversions we need to do.
   
-    // Is it too soon to log the next record?
-  if (_now - prevLogTime < logInterval) {
+    // Is it too soon to log the next record? The interval depends upon the flight phase.
+  if (_now - prevLogTime < getLogInterval()) {
     return;       // Yes, so just return.
   }
 
   // Setup the parameters for the next logging point.
   prevLogTime = _now;
-  // Calculate the interval to the next log time.
-  if (alt >= LOG_RATE_HIGH_THRESHOLD_ALT + LOG_THRESHOLD_ALT_TOL) {
-    logInterval = LOG_HIGH_RATE_MS;
-  } else if (alt <= LOG_RATE_HIGH_THRESHOLD_ALT - LOG_THRESHOLD_ALT_TOL) {
-    logInterval = LOG_LOW_RATE_MS;
+  countLogRecord();
+  if (!isLoggingEnabled()) {
+    return;       // No card, or the log was closed by the "close" command.
   }
 
-  // Log the current data.
-  // The record layout is "$HAB,time,lat,lon,alt,hdop,satCnt,C1,C2,battV"
-  strcpy(logRec, "$HAB,");
-
-  sprintf(wrkBuf, "%d:%02d:%02d,", hour, minute,second);
-  strcat(logRec,wrkBuf);
-
-  sprintf(wrkBuf, "%.6f,%.6f,%.2f,%.4f,%d,", lat, lon, alt, hdop, satCnt);
-  strcat(logRec, wrkBuf);
-
-  sprintf(wrkBuf, "%.2f,%.2f,%.2f,", tempC1, tempC2, battV);
-  strcat(logRec, wrkBuf);
-
-  sprintf(wrkBuf, "%d,%lu,%lu,", oledCnt, sumOledUpdateTime, slowestOledUpdateTime);
-  strcat(logRec, wrkBuf);
-  resetOledTime();
-
-  sprintf(wrkBuf, "%d,%lu,%lu,", getTempUpdCnt(), getSumTempUpdateTime(), getSlowestTempUpdateTime());
-  strcat(logRec, wrkBuf);
-  resetTempMetrics();
-
-  sprintf(wrkBuf, "%lu,%u", logCumulativeTimeMs, logCnt);
-  strcat(logRec, wrkBuf);
+#if defined(LOG_BINARY_HAB)
+  // Log the current data as a binary record (see HabRecord.h).
+  HabRecord rec;
+  rec.hour = hour;
+  rec.minute = minute;
+  rec.second = second;
+  rec.flags = (timeValid ? HAB_FLAG_TIME_VALID : 0)
+            | (locValid ? HAB_FLAG_LOC_VALID : 0)
+            | (altValid ? HAB_FLAG_ALT_VALID : 0)
+            | (hdopValid ? HAB_FLAG_HDOP_VALID : 0)
+            | (satCntValid ? HAB_FLAG_SAT_VALID : 0)
+            | (recordBroken ? HAB_FLAG_RECORD_BROKEN : 0)
+            | (isHeaterOn() ? HAB_FLAG_HEATER_ON : 0);
+  rec.lat = lround(lat * 1000000.0);
+  rec.lon = lround(lon * 1000000.0);
+  rec.alt = lround(alt * 100.0);
+  rec.hdop = lround(hdop * 10000.0);
+  rec.satCnt = satCnt;
+  rec.temp1 = lround(tempC1 * 100.0);
+  rec.temp2 = lround(tempC2 * 100.0);
+  rec.battV = lround(battV * 100.0);
+
+  rec.gpsOvfCnt = habSat16(gpsGetOverflowCnt());
+  rec.gpsHighWater = habSat16(gpsGetHighWater());
+  gpsResetMetrics();
+
+  rec.chkErrGP = habSat16(getChecksumErrCnt(TalkerGP));
+  rec.chkErrGN = habSat16(getChecksumErrCnt(TalkerGN));
+  rec.chkErrOther = habSat16(getChecksumErrCnt(TalkerOther));
+  resetChecksumErrCnt();
+
+  rec.logCnt = logCnt;
+  for (int i = 0; i < TimerCnt; i++) {
+    habSummariseTimer(rec.timers[i], getTimerHistogram((enum InstrTimer) i));
+  }
 
-  for (int i = 0; i < MAX_LOG_HISTORY; i++) {
-    sprintf(wrkBuf, ",%d", getLogTimeFromHistory(i));
-    strcat(logRec, wrkBuf);
+  if (logRecord(&rec, habFinishRecord(rec)) == -1) {
+    Serial.println(F("*** Failed to log binary $HAB record"));
+  }
+#else
+  // Log the current data.
+  // The record layout is "$HAB,time,lat,lon,alt,hdop,satCnt,C1,C2,battV,..." (see HAB_LOG_HEADER).
+  // The values are scaled to integers as for the binary record, and formatted without
+  // floating point (FixedFormat.h) straight into the log buffer.
+  FmtCursor out = logMessageBegin();
+  out.appendText("$HAB,");
+  out.appendTime(hour, minute, second).appendSeparator();
+
+  out.appendFixed(lround(lat * 1000000.0), 6, 6).appendSeparator();
+  out.appendFixed(lround(lon * 1000000.0), 6, 6).appendSeparator();
+  out.appendFixed(lround(alt * 100.0), 2, 2).appendSeparator();
+  out.appendFixed(lround(hdop * 10000.0), 4, 4).appendSeparator();
+  out.appendSigned(satCnt).appendSeparator();
+
+  out.appendFixed(lround(tempC1 * 100.0), 2, 2).appendSeparator();
+  out.appendFixed(lround(tempC2 * 100.0), 2, 2).appendSeparator();
+  out.appendFixed(lround(battV * 100.0), 2, 2).appendSeparator();
+
+  out.appendUnsigned(gpsGetOverflowCnt()).appendSeparator().appendUnsigned(gpsGetHighWater()).appendSeparator();
+  gpsResetMetrics();
+
+  out.appendUnsigned(getChecksumErrCnt(TalkerGP)).appendSeparator();
+  out.appendUnsigned(getChecksumErrCnt(TalkerGN)).appendSeparator();
+  out.appendUnsigned(getChecksumErrCnt(TalkerOther)).appendSeparator();
+  resetChecksumErrCnt();
+
+  out.appendUnsigned(logCnt);
+
+  // Count, p50, p90, p99 and max of each timer (us).
+  for (int i = 0; i < TimerCnt; i++) {
+    const LatencyHistogram & hist = getTimerHistogram((enum InstrTimer) i);
+    out.appendSeparator().appendUnsigned(hist.getCount());
+    out.appendSeparator().appendUnsigned(hist.percentile(50));
+    out.appendSeparator().appendUnsigned(hist.percentile(90));
+    out.appendSeparator().appendUnsigned(hist.percentile(99));
+    out.appendSeparator().appendUnsigned(hist.getMax());
   }
 
-  if (logMessage(logRec) == -1) {
-    Serial.print(F("*** Failed to log: ")); Serial.println(logRec);
+  bool truncated = out.isTruncated();
+  if (logMessageEnd(out) == -1) {
+    Serial.println(F("*** Failed to log $HAB record"));
+  } else if (truncated) {
+    Serial.println(F("*** $HAB record truncated"));
   }
-  resetLogTimeHistory();
+#endif
+  resetTimers();
 
   uint32_t endTime = millis();
 
   uint32_t logTime = endTime - _now;
-  logCumulativeTimeMs += logTime;
   logCnt++;
   Serial.print(F("Log msg: ")); Serial.print(logCnt); Serial.print(F(" ms=")); Serial.println(logTime);
 }
@@ -333,6 +498,10 @@ void updateDisplay(int hour, int minute, int second, bool timeValid,
 }
 
 
+/*
+ * Update the display with the latest data.
+ * Only the fields that have changed are redrawn and sent to the display.
+ */
 void updateDisplayV2(int hour, int minute, int second, bool timeValid,
               double lat, double lon, bool locValid,
               double alt, bool altValid, bool recordBroken,
@@ -341,14 +510,7 @@ void updateDisplayV2(int hour, int minute, int second, bool timeValid,
               double tempC1, double tempC2,
               double battV) {
   char buf[20];  // Buffer for padding up to 9 characters including string terminator.
-
-  display.clearDisplay();
-  display.setTextColor(WHITE);
-  display.setCursor(0,0);
-  int16_t x, y, dx, dy;
-  uint16_t w, h;
-  // Location
-
+  char text[MAX_FIELD_CHARS + 1];
 
   // Time
  #ifdef TEST_MODE
@@ -361,15 +523,15 @@ void updateDisplayV2(int hour, int minute, int second, bool timeValid,
     Serial.print(F(" valid: ")); Serial.println(timeValid ? "T": "F");
  #endif
 
-  display.setTextSize(2);
   if (timeValid) {
-    display.print(rightJustify(buf, 4, hour));
-    display.print(":");
-    display.print(rightJustify(buf, 2, minute, '0'));
-    display.print(":");
-    display.println(rightJustify(buf, 2, second, '0'));
+    strcpy(text, rightJustify(buf, 4, hour));
+    strcat(text, ":");
+    strcat(text, rightJustify(buf, 2, minute, '0'));
+    strcat(text, ":");
+    strcat(text, rightJustify(buf, 2, second, '0'));
+    oled.setField(FldTime, text);
   } else {
-    display.println("  --:--:--");
+    oled.setField(FldTime, "  --:--:--");
   }
 
   // Altitude
@@ -379,37 +541,19 @@ void updateDisplayV2(int hour, int minute, int second, bool timeValid,
   Serial.print(F(" valid: ")); Serial.println(altValid ? "T": "F");
 #endif
 
-  display.setTextSize(2); // larger font for key metric.
   if (altValid) {
-    display.print(rightJustifyF(buf, 10, alt, 2, ' ', ','));
-    x = display.getCursorX();
-    y = display.getCursorY();
-    display.getTextBounds((const char *) buf, x, y, &dx, &dy, &w, &h);
-    display.setTextSize(1);
-    x = display.getCursorX();
-    display.println("m");
-    dy = display.getCursorY();
-    display.setCursor(x, dy);
-    if (recordBroken) {
-      display.print("R");
-    }
-    // Leave a small amount of space below the large font messages.
-    // display.setCursor(0, y + h + OLED_LINE_SPACING);
-    display.setCursor(0, y + h);
+    oled.setField(FldAlt, rightJustifyF(buf, 10, alt, 2, ' ', ','));
+    oled.setField(FldAltUnit, "m");
+    oled.setField(FldAltRecord, recordBroken ? "R" : "");
   } else {
-    display.println("Alt: --");
-    // display.setCursor(0, display.getCursorY() + OLED_LINE_SPACING);
-    display.setCursor(0, display.getCursorY());
-    display.setTextSize(1);
+    oled.setField(FldAlt, "Alt: --");
+    oled.setField(FldAltUnit, "");
+    oled.setField(FldAltRecord, "");
   }
 
 
   // Temperature
 #if defined(TEST_MODE)
-  for (unsigned int i = 0; i < sizeof(buf); i++) {
-    buf[i] = '*';
-  }
-
   Serial.print("temps: ");
     Serial.print(tempC1, 2);
     Serial.print(", ");
@@ -419,21 +563,26 @@ void updateDisplayV2(int hour, int minute, int second, bool timeValid,
     Serial.println();
 #endif
 
-  display.setTextSize(2);
-  display.print(rightJustifyF(buf, 5, tempC1, 1));
-  display.print(" C");
-  display.println(isHeaterOn() ? " H" : "");
-  display.print(rightJustifyF(buf, 5, tempC2, 1));
-  display.print(" C");
-  if (recordBroken) {
-      display.print(" R");
-  }
-  display.display();
+  oled.setField(FldTemp1, rightJustifyF(buf, 5, tempC1, 1));
+  oled.setField(FldTemp1Unit, " C");
+  oled.setField(FldHeater, isHeaterOn() ? " H" : "");
+  oled.setField(FldTemp2, rightJustifyF(buf, 5, tempC2, 1));
+  oled.setField(FldTemp2Unit, " C");
+  oled.setField(FldRecord, recordBroken ? " R" : "");
+
+  oled.refresh();
 }
 
 
 
 void setup() {
+  bool warmRestart = false;
+
+#if defined(LOG_WARM_RESTART)
+  // Was the previous log still in flight when the logger was reset (e.g. a brown out)?
+  int restartPhase = logBegin() ? getLogRestartState() : LOG_STATE_NONE;
+  warmRestart = restartPhase > PhasePad && restartPhase < PhaseLanded;
+#endif
 
   // SSD1306_SWITCHCAPVCC = generate display voltage from 3.3V internally
   if(!display.begin(OLED_MODEL, OLED_SCREEN_ADDRESS)) {
@@ -447,8 +596,10 @@ void setup() {
       interval = 1000 - interval;
     }
   }
-  display.display();
-  delay(1000);
+  if (!warmRestart) {
+    display.display();
+    delay(1000);
+  }
 
   display.clearDisplay();
   display.setCursor(0,0);
@@ -469,10 +620,11 @@ void setup() {
       // Teensy appears to require a positive connection before Serial is true.
       // So, include a timeout mechanism to allow the code to execute.
       // TODO: Rearrange this and put startup progress messages on the OLED.
-  int cnt = 2000;
+  // Don't wait for a console after a warm restart.
+  int cnt = warmRestart ? 0 : 2000;
   while (!Serial && cnt--)
     ;
-  if (cnt) {
+  if (Serial) {
     display.println(F("connected."));
   } else {
     display.println(F("not connected."));
@@ -483,12 +635,22 @@ void setup() {
   display.print(F("init hab: "));
   display.display();
   initHab(display);
+#if defined(LOG_WARM_RESTART)
+  if (warmRestart && logResume()) {
+    display.print(F("Resumed:"));
+    display.println(getLogFileName());
+    resumeFlightPhase((enum FlightPhase) restartPhase);
+    logRestart();
+    logFlush();
+  } else
+#endif
   if (generateLogFileName(LOG_FILE_NAME_PREFIX, LOG_FILE_NAME_EXT)) {
     display.print(F("Log:"));
     display.println(getLogFileName());
     Serial.print(F("log filename: "));
     Serial.println(getLogFileName());
     logHeader();
+    logFlush();
   } else {
     display.println(F("NO SD CARD!!"));
     Serial.println(F("No SD Card"));
@@ -496,8 +658,79 @@ void setup() {
 
   display.println(F("Init complete."));
   display.display();
-  delay(5000);
-  display.clearDisplay();
+  if (!warmRestart) {
+    delay(5000);
+  }
+  oled.begin();
+  resetTimers();            // Only time the flight, not the startup.
+}
+
+
+// Console command line being received.
+#define CONSOLE_LINE_SIZE 40
+char consoleLine[CONSOLE_LINE_SIZE];
+unsigned int consoleLineLen = 0;
+
+/*
+ * Process a console command:
+ *   nmea               List the GPS sentences being logged.
+ *   nmea address n     Log every nth sentence with the address, e.g. "nmea GPGSV 10".
+ *                      0 stops logging it. See GPS_LOG_SENTENCES in hab_config.h.
+ *   close              Write out and close the log, e.g. before the power is removed
+ *                      after recovery. A preallocated log is truncated to its length.
+ *                      Logging stops until the next reset, which starts a new log.
+ */
+void processConsoleCommand(char * cmd) {
+  char * tokens[3];
+  int tokenCnt = 0;
+  for (char * tok = strtok(cmd, " "); tok && tokenCnt < 3; tok = strtok(NULL, " ")) {
+    tokens[tokenCnt++] = tok;
+  }
+  if (tokenCnt == 0) {
+    return;
+  }
+
+  if (strcasecmp(tokens[0], "nmea") == 0) {
+    if (tokenCnt == 3) {
+      char * end;
+      unsigned long every = strtoul(tokens[2], &end, 10);
+      if (*end != '\0' || !setSentenceFilter(tokens[1], every)) {
+        Serial.print(F("*** Invalid sentence filter: ")); Serial.print(tokens[1]);
+        Serial.print(' '); Serial.println(tokens[2]);
+      }
+    } else if (tokenCnt != 1) {
+      Serial.println(F("Usage: nmea [address n]"));
+      return;
+    }
+    printSentenceFilters();
+  } else if (strcasecmp(tokens[0], "close") == 0) {
+    if (!isLoggingEnabled()) {
+      Serial.println(F("*** The log is not open"));
+    } else if (logClose()) {
+      Serial.print(F("Closed: ")); Serial.println(getLogFileName());
+    } else {
+      Serial.print(F("*** Failed to close: ")); Serial.println(getLogFileName());
+    }
+  } else {
+    Serial.print(F("*** Unknown command: ")); Serial.println(tokens[0]);
+  }
+}
+
+
+/*
+ * Collect console input and process each line as a command.
+ */
+void checkConsoleInput() {
+  while (Serial.available() > 0) {
+    char ch = Serial.read();
+    if (ch == '\n' || ch == '\r') {
+      consoleLine[consoleLineLen] = '\0';
+      consoleLineLen = 0;
+      processConsoleCommand(consoleLine);
+    } else if (consoleLineLen < CONSOLE_LINE_SIZE - 1) {
+      consoleLine[consoleLineLen++] = ch;
+    }
+  }
 }
 
 
@@ -509,6 +742,9 @@ static bool recordBroken = false;
 static bool locValid = false, altValid = false, satCntValid = false, timeValid = false, hdopValid = false;
 bool newData = false;
 
+  timerStart(TimerLoop);
+  logService();                   // Commit any buffered log records that are due to be written.
+  checkConsoleInput();            // Commands, e.g. to change the sentences that are logged.
   checkAltitudeRecord(alt);       // Check the altitude and if appropriate, set or blink the record LED.
 
   if (checkGPSData()) {
@@ -569,9 +805,16 @@ bool newData = false;
 
 
   if (newData) {
-    uint32_t startTime = millis();
+    timerStart(TimerOled);
     updateDisplayV2(localHour, minute, second, timeValid, lat, lon, locValid, alt, altValid, recordBroken, hdop, hdopValid, satCnt, satCntValid, tempInternal, tempExternal, batteryVoltage);
-    logOledTime(startTime);
+    timerStop(TimerOled);
     logData(utcHour, minute, second, timeValid, lat, lon, locValid, alt, altValid, recordBroken, hdop, hdopValid, satCnt, satCntValid, tempInternal, tempExternal, batteryVoltage);
+  } else if (oled.isPending()) {
+    // Send any display changes that were held back by the refresh rate limit.
+    timerStart(TimerOled);
+    if (oled.refresh()) {
+      timerStop(TimerOled);
+    }
   }
+  timerStop(TimerLoop);
 }
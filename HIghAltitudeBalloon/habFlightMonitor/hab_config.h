@@ -3,6 +3,20 @@
  */
 
  /* Revision History
+  *
+  * 2026-10-17 LOG_BUFFER_SIZE is 2 sectors on AVR, to leave room for the latency histograms.
+  *
+  * 2026-10-17 Added GPS_LOG_SENTENCES, which replaces the sentence list in hab.cpp.
+  *
+  * 2026-10-17 Added LOG_WARM_RESTART.
+  *
+  * 2026-10-17 Flight phase detection and per phase log intervals and budgets replace
+  *            the altitude based LOG_LOW_RATE_MS and LOG_HIGH_RATE_MS.
+  *            Added LOG_SEQUENCE_FILE.
+  *
+  * 2026-10-17 Added buffered (group commit), preallocated and binary logging parameters.
+  *            Added OLED refresh rate limit and GPS receive buffer parameters.
+  *            Added GPS_SKIP_INVALID_SENTENCES.
   *
   * 2024-05-18 Added Timezone offset and other configuration constants. 
   *
@@ -40,27 +54,128 @@
 #define HEATER_TEMP_SENSOR INTERNAL_TEMP
 
 
+// Flight phase detection (see checkFlightPhase in hab.cpp).
+// The phase is found from the vertical speed, which is filtered with this time constant (s).
+#define PHASE_VS_FILTER_SECS    10.0
+// Climbing faster than this (m/s) is an ascent.
+#define PHASE_ASCENT_VS         1.0
+// Moving up or down slower than this (m/s) is a float, or after a descent, landed.
+#define PHASE_FLOAT_VS          0.5
+// Falling faster than this (m/s) is a descent.
+#define PHASE_DESCENT_VS        -1.5
+// Falling faster than this (m/s) between two fixes while ascending or floating is a burst.
+// Not filtered, so that the burst is seen at once.
+#define PHASE_BURST_VS          -10.0
+// A float is only recognised this far (m) above the launch site.
+#define PHASE_MIN_FLOAT_ALT     1000
+// A new phase must be indicated for this long (ms) before it is accepted.
+#define PHASE_CONFIRM_MS        5000L
+#define PHASE_BURST_CONFIRM_MS  2000L
+// Time (ms) from a burst until the phase becomes descent.
+#define PHASE_BURST_MS          60000L
+
+
 // Logger parameters.
-// Altitude at which a higher rate of logging is applied.
-#define LOG_RATE_HIGH_THRESHOLD_ALT 10000L
-// A window where the logging rate doesn't change. To trigger a logging rate change:
-// During ascent, the altitude must be or exceed the threshold + this tollerance.
-// During descent, the altitude must be or lower than the threshold - this tollerance.
-#define LOG_THRESHOLD_ALT_TOL 100
-// Logging rates.
-#define LOG_LOW_RATE_MS     5*1000L
-#define LOG_HIGH_RATE_MS    1*1000L
+// Interval (ms) between $HAB records in each flight phase: pad, ascent, float, burst, descent, landed.
+#define LOG_PHASE_INTERVALS_MS  { 10000, 5000, 10000, 1000, 2000, 30000 }
+// Around a phase change, that is while a new phase is being confirmed and for LOG_TRANSITION_MS
+// after it is accepted, records are logged every LOG_TRANSITION_INTERVAL_MS.
+#define LOG_TRANSITION_INTERVAL_MS  1000L
+#define LOG_TRANSITION_MS       60000L
+// Most $HAB records logged in each phase (same order as LOG_PHASE_INTERVALS_MS). Once a
+// phase has used its budget, records are logged every LOG_BUDGET_INTERVAL_MS.
+#define LOG_PHASE_BUDGETS       { 2000, 3000, 3000, 300, 2500, 1000 }
+#define LOG_BUDGET_INTERVAL_MS  60000L
+
+
+// Log file buffering.
+// When defined, the log file is held open and records are collected in a RAM buffer
+// which is written to the SD card in whole 512 byte sectors. The file is synced when
+// either of the LOG_SYNC_xxx limits below is reached, which bounds the amount of data
+// that can be lost if power fails.
+// When not defined, the log file is opened, appended to and closed for every record.
+#define LOG_GROUP_COMMIT
+// Size of the RAM log buffer. Must be a multiple of the SD card sector size (512), and
+// at least 2 sectors. Smaller on AVR (e.g. Mega), which has 8KB of RAM in all.
+#if defined(__AVR__)
+#define LOG_BUFFER_SIZE       (2 * 512)
+#else
+#define LOG_BUFFER_SIZE       (4 * 512)
+#endif
+// Maximum time that a logged record may sit in the buffer before the file is synced.
+#define LOG_SYNC_INTERVAL_MS  2000L
+// Maximum number of bytes that may be logged before the file is synced.
+#define LOG_SYNC_BYTES        (8 * 512L)
+
+// Preallocated log file. Requires LOG_GROUP_COMMIT and a FAT16/FAT32 formatted card.
+// When defined, a contiguous file of LOG_PREALLOCATE_SIZE bytes is allocated and erased
+// when the log is created and buffered sectors are written directly into it, so no
+// FAT updates occur during the flight. The file is truncated to the length actually
+// logged when it is closed by the console command "close" or, if it was not closed
+// (the power was removed or lost), when the logger next starts.
+// If the file cannot be preallocated, the logger falls back to regular buffered writes.
+#define LOG_PREALLOCATE
+// The default GPS_LOG_SENTENCES are about 150 bytes/s (an RMC and a GGA each second) and a
+// text $HAB record is about 175 bytes. At the LOG_PHASE_INTERVALS_MS that is about 170 bytes/s
+// on the pad and at float (10s), 185 bytes/s in the ascent (5s) and 330 bytes/s after burst
+// (1s), so 32MB is over 27 hours even at the fastest rate. Logging every sentence the GPS
+// sends (including GSV) is roughly 1KB/s, for which 32MB is about 9 hours.
+#define LOG_PREALLOCATE_SIZE  (32UL * 1024UL * 1024UL)
+
+
+// Binary $HAB records.
+// When defined, $HAB records are logged in the compact binary layout defined in
+// HabRecord.h instead of as text. The NMEA sentences are still logged as text.
+// Use GPSCheckSum/habdecode to convert the log back to the text layout.
+// #define LOG_BINARY_HAB
 
 
 // A prefix and extension for the log file name.
 #define LOG_FILE_NAME_PREFIX  "hab"
 #define LOG_FILE_NAME_EXT     "log"
+// File on the card that holds the number of the next log file, so that the directory
+// does not have to be scanned at startup. It is recreated by a scan if it is lost.
+// The flight phase of the current log is saved with it whenever the phase changes.
+#define LOG_SEQUENCE_FILE     "habseq.txt"
+
+// Warm restart.
+// When defined, a reset during the flight (ascent, float, burst or descent), e.g. a brown
+// out, is detected at startup from the flight phase saved in LOG_SEQUENCE_FILE. The splash
+// screen and serial delays are skipped, any record torn by the reset is removed from the
+// end of the previous log and logging continues in it, after a $HABRS record that marks
+// the gap. On the pad, after landing, or once the log has been closed, a new log is started.
+#define LOG_WARM_RESTART
 
 
 // The port the GPS is connected to.
 #define GPS_PORT  Serial1
 // Baud rate of the GPS.
 #define GPS_BAUD 9600
+// Size of the GPS receive ring buffer (a power of 2). 4096 is about 4 seconds of data at 9600 baud.
+#if defined(TEENSYDUINO)
+#define GPS_RING_SIZE 4096
+#else
+#define GPS_RING_SIZE 1024
+#endif
+// How often (us) the GPS_PORT is emptied into the ring buffer by the timer interrupt (Teensy).
+// At 9600 baud about 5 bytes arrive every 5ms.
+#define GPS_INGEST_POLL_US 5000
+// GPS sentences with an incorrect checksum are logged with a leading '!'.
+// Uncomment to not log them at all. They are counted in the $HAB record either way.
+// #define GPS_SKIP_INVALID_SENTENCES
+// The GPS sentences that are logged: { address, n } logs every nth sentence with that address
+// (1 = all of them). A 3 letter address (e.g. "GSV") applies to every GNSS talker ID, and a
+// proprietary address (e.g. "PUBX") to all proprietary sentences. A GSV message is logged or
+// skipped as a whole group. Use the console command "nmea" to list or change the set while
+// running, e.g. "nmea GPGSV 10", or "nmea GPGSV 0" to stop logging it.
+#define GPS_LOG_SENTENCES { \
+  { "GPRMC", 1 },   /* GPS system: Recommended Minimum Data. */ \
+  { "GPGGA", 1 },   /* GPS system: System Fix Data. */ \
+  { "GNRMC", 1 },   /* General (all systems): Recommended Minimum Data. */ \
+  { "GNGGA", 1 },   /* General (all systems): System Fix Data. */ \
+  { "GNTXT", 1 },   /* General (all systems): generic text message. */ \
+  { "GPTXT", 1 },   /* GPS system: generic text message. */ \
+}
 
 // The port that the OLED is connected to.
 #define OLED_PORT Wire
@@ -69,6 +184,9 @@
 #define OLED_SCREEN_ADDRESS 0x3C ///< See datasheet for Address; 0x3D for 128x64, 0x3C for 128x32
 #define OLED_SCREEN_WIDTH 128 // OLED display width, in pixels
 #define OLED_SCREEN_HEIGHT 64 // OLED display height, in pixels
+// Minimum time between transfers to the OLED (ms). Changes made in between are sent later,
+// so that a burst of GPS updates cannot saturate the I2C bus.
+#define OLED_MIN_REFRESH_MS 250
 
 
 
@@ -0,0 +1,63 @@
+#ifndef _ADAFRUIT_GFX_H
+#define _ADAFRUIT_GFX_H
+
+/*
+ * Host emulation of the parts of Adafruit_GFX used by the flight monitor: text in
+ * the default 6x8 character cell (scaled by the text size) and filled rectangles.
+ *
+ * The real font is not included. Each character is drawn as a pattern made from its
+ * code, so that a change of text changes the frame buffer just as it would on the
+ * display. The text is also kept in a grid of character cells so that it can be
+ * printed (see hostDisplayDump()).
+ */
+
+#include <Arduino.h>
+
+#define HOST_GFX_CHAR_WIDTH  6
+#define HOST_GFX_CHAR_HEIGHT 8
+
+class Adafruit_GFX : public Print {
+  public:
+    Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    int16_t getCursorX() const { return cursorX; }
+    int16_t getCursorY() const { return cursorY; }
+    void setTextSize(uint8_t size) { textSize = size > 0 ? size : 1; }
+    void setTextColor(uint16_t color) { textColor = color; textBgColor = color; }
+    void setTextColor(uint16_t color, uint16_t bg) { textColor = color; textBgColor = bg; }
+    void setTextWrap(bool wrap) { this->wrap = wrap; }
+    void getTextBounds(const char * text, int16_t x, int16_t y, int16_t * x1, int16_t * y1, uint16_t * w, uint16_t * h);
+
+    int16_t width() const { return WIDTH; }
+    int16_t height() const { return HEIGHT; }
+
+    size_t write(uint8_t ch) override;
+    using Print::write;
+
+    // Text drawn on the display, one character per 6x8 cell. Cells covered by larger
+    // text hold the character in their top left cell and are otherwise blank.
+    char getTextCell(int16_t col, int16_t row) const;
+
+  protected:
+    void clearText();
+
+    const int16_t WIDTH;
+    const int16_t HEIGHT;
+
+  private:
+    void drawChar(int16_t x, int16_t y, unsigned char ch);
+
+    int16_t cursorX = 0;
+    int16_t cursorY = 0;
+    uint8_t textSize = 1;
+    uint16_t textColor = 1;
+    uint16_t textBgColor = 1;
+    bool wrap = true;
+    char text[8][21] = {};
+};
+
+#endif
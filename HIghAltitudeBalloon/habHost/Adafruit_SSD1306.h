@@ -0,0 +1,42 @@
+#ifndef _ADAFRUIT_SSD1306_H
+#define _ADAFRUIT_SSD1306_H
+
+/*
+ * Host emulation of an SSD1306 OLED on the I2C bus. The frame buffer is held in
+ * memory, and display() sends it over the (emulated) bus in the same transmissions
+ * as the real library, so its cost is counted.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+
+#define BLACK                 0
+#define WHITE                 1
+#define INVERSE               2
+
+#define SSD1306_SWITCHCAPVCC  0x02
+#define SSD1306_EXTERNALVCC   0x01
+#define SSD1306_COLUMNADDR    0x21
+#define SSD1306_PAGEADDR      0x22
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+  public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire * twi, int8_t rstPin = -1);
+    ~Adafruit_SSD1306();
+
+    bool begin(uint8_t vccState = SSD1306_SWITCHCAPVCC, uint8_t i2cAddr = 0);
+    void display();
+    void clearDisplay();
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    uint8_t * getBuffer() { return buffer; }
+
+  private:
+    void sendCommands(const uint8_t * cmds, size_t len);
+
+    TwoWire * wire;
+    uint8_t i2cAddr = 0x3C;
+    uint8_t * buffer = NULL;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef _ARDUINO_H
+#define _ARDUINO_H
+
+/*
+ * Host emulation of the parts of the Arduino core used by the flight monitor.
+ * The pin numbers are those of the Teensy 4.1.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH        1
+#define LOW         0
+#define INPUT       0
+#define OUTPUT      1
+#define LED_BUILTIN 13
+#define A0          14
+#define A7          21
+#define HOST_PIN_CNT 64
+
+#define DEC         10
+#define HEX         16
+
+#define PROGMEM
+#define F(text)     (text)
+typedef const char * PGM_P;
+inline uint8_t pgm_read_byte(const void * p) { return *(const uint8_t *) p; }
+
+inline int stricmp(const char * a, const char * b) { return strcasecmp(a, b); }
+
+template <typename A, typename B> inline auto min(A a, B b) { return a < b ? a : b; }
+template <typename A, typename B> inline auto max(A a, B b) { return a > b ? a : b; }
+
+extern uint32_t millis();
+extern uint32_t micros();
+extern void delay(uint32_t ms);
+extern void delayMicroseconds(uint32_t us);
+
+extern void pinMode(int pin, int mode);
+extern void digitalWrite(int pin, int value);
+extern int digitalRead(int pin);
+extern int analogRead(int pin);
+
+extern long random(long howBig);
+extern long random(long howSmall, long howBig);
+extern void randomSeed(unsigned long seed);
+
+// The host is single threaded, there is nothing to disable.
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+
+/*
+ * Formatted output, as Arduino's Print.
+ */
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+
+    virtual size_t write(const uint8_t * buf, size_t len) {
+      size_t n = 0;
+      while (len--) {
+        n += write(*buf++);
+      }
+      return n;
+    }
+    size_t write(const char * text) { return text ? write((const uint8_t *) text, strlen(text)) : 0; }
+    size_t write(const char * buf, size_t len) { return write((const uint8_t *) buf, len); }
+
+    size_t print(const char * text) { return write(text); }
+    size_t print(char ch) { return write((uint8_t) ch); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long) n, base); }
+    size_t print(int n, int base = DEC) { return print((long) n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long) n, base); }
+    size_t print(long n, int base = DEC) {
+      if (base != DEC) {
+        return print((unsigned long) n, base);
+      }
+      char buf[24];
+      snprintf(buf, sizeof(buf), "%ld", n);
+      return write(buf);
+    }
+    size_t print(unsigned long n, int base = DEC) {
+      char buf[24];
+      snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", n);
+      return write(buf);
+    }
+    size_t print(double n, int digits = 2) {
+      char buf[48];
+      snprintf(buf, sizeof(buf), "%.*f", digits, n);
+      return write(buf);
+    }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+};
+
+
+/*
+ * A serial port. Port 0 (Serial) is the console, port 1 (Serial1) replays the GPS log.
+ */
+class HardwareSerial : public Stream {
+  public:
+    HardwareSerial(int port) : port(port) {}
+
+    void begin(unsigned long baud);
+    operator bool() const { return true; }
+    int available() override;
+    int read() override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t * buf, size_t len) override;
+    using Print::write;
+
+  private:
+    int port;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif
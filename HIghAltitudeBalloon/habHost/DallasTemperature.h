@@ -0,0 +1,42 @@
+#ifndef _DALLAS_TEMPERATURE_H
+#define _DALLAS_TEMPERATURE_H
+
+/*
+ * Host emulation of two DS18B20 sensors: the inside of the payload (0) and the
+ * outside air (1). The air temperature follows the standard atmosphere at the
+ * latest GPS altitude. The payload is warmed by the air around it and by the heater,
+ * and follows changes with a time constant of a few minutes.
+ *
+ * The time each 1-Wire transaction would take is added to the emulated clock.
+ */
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+typedef uint8_t DeviceAddress[8];
+
+#define DEVICE_DISCONNECTED_C -127
+
+class DallasTemperature {
+  public:
+    DallasTemperature(OneWire * bus) : bus(bus) {}
+
+    void begin() {}
+    uint8_t getDeviceCount() { return 2; }
+    bool isParasitePowerMode() { return false; }
+    bool getAddress(uint8_t * addr, uint8_t index);
+    void setResolution(const uint8_t * addr, uint8_t bits) { (void) addr; resolution = bits; }
+    uint8_t getResolution(const uint8_t * addr) { (void) addr; return resolution; }
+    void setWaitForConversion(bool wait) { waitForConversion = wait; }
+    int16_t millisToWaitForConversion(uint8_t bits);
+
+    void requestTemperatures();
+    float getTempC(const uint8_t * addr);
+
+  private:
+    OneWire * bus;
+    uint8_t resolution = 12;
+    bool waitForConversion = true;
+};
+
+#endif
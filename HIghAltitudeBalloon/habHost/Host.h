@@ -0,0 +1,77 @@
+#ifndef _HOST_H
+#define _HOST_H
+
+/*
+ * Host emulation of the flight monitor's hardware.
+ *
+ * The emulated clock (millis() and micros()) is the real time since the emulation
+ * started, multiplied by the replay speed, plus the time that devices are "busy":
+ * I2C transfers, 1-Wire transactions, SD card writes and delay(). Device time is added
+ * rather than waited for, so it is counted the same way at any speed. At speed 0 the
+ * clock also skips ahead to the next GPS byte whenever the sketch is waiting for one,
+ * so a flight is replayed as fast as the sketch can process it.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Clock.
+ */
+extern void hostClockBegin(double speed);
+extern double hostClockSpeed();
+extern uint64_t hostMicros();
+extern void hostSkipTo(uint64_t us);          // Skip ahead (speed 0 only).
+
+enum HostDevice {
+  HostDeviceDelay, HostDeviceI2c, HostDeviceOneWire, HostDeviceSd, HostDeviceCnt
+};
+extern void hostCharge(HostDevice device, uint64_t us);   // Device time, added to the clock.
+extern uint64_t hostChargedUs(HostDevice device);         // Device time charged so far.
+
+/*
+ * Pins.
+ */
+extern void hostSetAnalog(int pin, int value);
+extern int hostPinState(int pin);
+
+/*
+ * Console (Serial).
+ */
+extern bool hostConsoleQuiet;
+
+/*
+ * GPS replay (Serial1). The sentences of a recorded log are delivered at the time
+ * they were received, one byte at a time at the baud rate, into a receive buffer of
+ * the given size. Bytes that arrive when the buffer is full are lost.
+ */
+extern bool hostReplayLoad(const char * file);
+extern void hostReplaySetRxBuffer(unsigned int size);
+extern void hostReplayIdle();                 // Between passes of loop().
+extern bool hostReplayDone();
+extern uint32_t hostReplayDurationSecs();
+extern uint64_t hostReplayBytes();            // Bytes delivered so far.
+extern uint64_t hostReplayOverruns();         // Bytes lost because the buffer was full.
+extern unsigned long hostReplayLines();
+
+/*
+ * SD card, backed by a directory. Statistics are for the card as a whole.
+ */
+extern void hostSdSetRoot(const char * dir);
+extern void hostSdSetSectorCost(uint32_t us);
+extern uint64_t hostSdBytesWritten();
+extern unsigned long hostSdWriteCnt();
+
+/*
+ * I2C bus.
+ */
+extern uint64_t hostI2cBytes();
+extern unsigned long hostI2cTransmissions();
+
+/*
+ * Devices.
+ */
+extern void hostGpsAltitude(double alt);       // Latest altitude, for the temperature model.
+extern void hostDisplayDump();                 // Print the text on the OLED.
+
+#endif
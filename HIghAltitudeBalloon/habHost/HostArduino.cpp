@@ -0,0 +1,251 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <chrono>
+#include <random>
+#include <poll.h>
+#include <unistd.h>
+
+#include "Host.h"
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+TwoWire Wire;
+
+bool hostConsoleQuiet = false;
+
+// Implemented by the GPS replay.
+extern void hostReplayBegin(unsigned long baud);
+extern int hostReplayAvailable();
+extern int hostReplayRead();
+
+
+/*********************************************
+ * Clock
+ ********************************************/
+
+static double clockSpeed = 1.0;
+static std::chrono::steady_clock::time_point clockStart = std::chrono::steady_clock::now();
+static uint64_t chargedUs[HostDeviceCnt];
+static uint64_t totalChargedUs = 0;
+static uint64_t skippedUs = 0;
+static uint64_t lastUs = 0;
+
+
+void hostClockBegin(double speed) {
+  clockSpeed = speed;
+  clockStart = std::chrono::steady_clock::now();
+}
+
+
+double hostClockSpeed() {
+  return clockSpeed;
+}
+
+
+uint64_t hostMicros() {
+  double realUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - clockStart).count();
+  uint64_t us = (uint64_t) (realUs * (clockSpeed > 0 ? clockSpeed : 1.0)) + totalChargedUs + skippedUs;
+  if (us < lastUs) {
+    us = lastUs;          // Never go backwards, e.g. when the speed is changed.
+  }
+  lastUs = us;
+  return us;
+}
+
+
+void hostSkipTo(uint64_t us) {
+  uint64_t now = hostMicros();
+  if (clockSpeed <= 0 && us > now) {
+    skippedUs += us - now;
+  }
+}
+
+
+void hostCharge(HostDevice device, uint64_t us) {
+  chargedUs[device] += us;
+  totalChargedUs += us;
+}
+
+
+uint64_t hostChargedUs(HostDevice device) {
+  return chargedUs[device];
+}
+
+
+uint32_t millis() {
+  return (uint32_t) (hostMicros() / 1000);
+}
+
+
+uint32_t micros() {
+  return (uint32_t) hostMicros();
+}
+
+
+void delay(uint32_t ms) {
+  hostCharge(HostDeviceDelay, ms * 1000ULL);
+}
+
+
+void delayMicroseconds(uint32_t us) {
+  hostCharge(HostDeviceDelay, us);
+}
+
+
+/*********************************************
+ * Pins
+ ********************************************/
+
+static int pinState[HOST_PIN_CNT];
+static int analogValue[HOST_PIN_CNT];
+
+
+void pinMode(int pin, int mode) {
+  (void) pin;
+  (void) mode;
+}
+
+
+void digitalWrite(int pin, int value) {
+  if (pin >= 0 && pin < HOST_PIN_CNT) {
+    pinState[pin] = value ? HIGH : LOW;
+  }
+}
+
+
+int digitalRead(int pin) {
+  return pin >= 0 && pin < HOST_PIN_CNT ? pinState[pin] : LOW;
+}
+
+
+int hostPinState(int pin) {
+  return digitalRead(pin);
+}
+
+
+void hostSetAnalog(int pin, int value) {
+  if (pin >= 0 && pin < HOST_PIN_CNT) {
+    analogValue[pin] = value;
+  }
+}
+
+
+int analogRead(int pin) {
+  return pin >= 0 && pin < HOST_PIN_CNT ? analogValue[pin] : 0;
+}
+
+
+static std::mt19937 randomGenerator;
+
+long random(long howBig) {
+  return howBig > 0 ? (long) (randomGenerator() % (unsigned long) howBig) : 0;
+}
+
+
+long random(long howSmall, long howBig) {
+  return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+
+void randomSeed(unsigned long seed) {
+  randomGenerator.seed(seed);
+}
+
+
+/*********************************************
+ * Serial ports
+ ********************************************/
+
+// Console input that has been read from stdin but not yet by the sketch.
+static char consoleIn[256];
+static size_t consoleInLen = 0;
+static size_t consoleInPos = 0;
+static bool consoleInEof = false;
+
+
+/*
+ * Collect any console input without waiting for it.
+ */
+static void pollConsole() {
+  if (consoleInPos < consoleInLen || consoleInEof) {
+    return;
+  }
+  struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+  if (poll(&pfd, 1, 0) == 1) {
+    ssize_t n = ::read(STDIN_FILENO, consoleIn, sizeof(consoleIn));
+    consoleInEof = n <= 0;
+    consoleInLen = n > 0 ? n : 0;
+    consoleInPos = 0;
+  }
+}
+
+
+void HardwareSerial::begin(unsigned long baud) {
+  if (port == 1) {
+    hostReplayBegin(baud);
+  }
+}
+
+
+int HardwareSerial::available() {
+  if (port == 1) {
+    return hostReplayAvailable();
+  }
+  pollConsole();
+  return consoleInLen - consoleInPos;
+}
+
+
+int HardwareSerial::read() {
+  if (port == 1) {
+    return hostReplayRead();
+  }
+  pollConsole();
+  return consoleInPos < consoleInLen ? (uint8_t) consoleIn[consoleInPos++] : -1;
+}
+
+
+size_t HardwareSerial::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+
+size_t HardwareSerial::write(const uint8_t * buf, size_t len) {
+  if (port == 0 && !hostConsoleQuiet) {
+    fwrite(buf, 1, len, stdout);
+  }
+  return len;
+}
+
+
+/*********************************************
+ * I2C
+ ********************************************/
+
+static uint64_t i2cBytes = 0;
+static unsigned long i2cTransmissions = 0;
+
+
+/*
+ * Each byte (including the address) takes 9 clocks, plus a clock each for the start
+ * and stop conditions.
+ */
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  (void) sendStop;
+  uint64_t bits = (txLen + 1) * 9 + 2;
+  hostCharge(HostDeviceI2c, (bits * 1000000ULL + clockHz / 2) / clockHz);
+  i2cBytes += txLen;
+  i2cTransmissions++;
+  txLen = 0;
+  return 0;
+}
+
+
+uint64_t hostI2cBytes() {
+  return i2cBytes;
+}
+
+
+unsigned long hostI2cTransmissions() {
+  return i2cTransmissions;
+}
@@ -0,0 +1,455 @@
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+#include <DallasTemperature.h>
+#include <TinyGPS++.h>
+#include <string>
+
+#include "Host.h"
+#include "hab_config.h"
+
+
+/*********************************************
+ * Adafruit_GFX
+ ********************************************/
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  for (int16_t j = y; j < y + h; j++) {
+    for (int16_t i = x; i < x + w; i++) {
+      drawPixel(i, j, color);
+    }
+  }
+  // Remove any text that was in the rectangle.
+  for (int16_t row = max(y, (int16_t) 0) / HOST_GFX_CHAR_HEIGHT; row < 8 && row * HOST_GFX_CHAR_HEIGHT < y + h; row++) {
+    for (int16_t col = max(x, (int16_t) 0) / HOST_GFX_CHAR_WIDTH; col < 21 && col * HOST_GFX_CHAR_WIDTH < x + w; col++) {
+      text[row][col] = '\0';
+    }
+  }
+}
+
+
+/*
+ * As Adafruit_GFX, text wraps at the right hand edge.
+ */
+size_t Adafruit_GFX::write(uint8_t ch) {
+  int16_t cellW = HOST_GFX_CHAR_WIDTH * textSize;
+  int16_t cellH = HOST_GFX_CHAR_HEIGHT * textSize;
+  if (ch == '\n') {
+    cursorX = 0;
+    cursorY += cellH;
+  } else if (ch != '\r') {
+    if (wrap && cursorX + cellW > WIDTH) {
+      cursorX = 0;
+      cursorY += cellH;
+    }
+    drawChar(cursorX, cursorY, ch);
+    cursorX += cellW;
+  }
+  return 1;
+}
+
+
+/*
+ * Draw a character as a pattern made from its code: a column for each of the low
+ * 5 bits that is set, 7 pixels high.
+ */
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char ch) {
+  int16_t s = textSize;
+  if (textBgColor != textColor) {
+    fillRect(x, y, HOST_GFX_CHAR_WIDTH * s, HOST_GFX_CHAR_HEIGHT * s, textBgColor);
+  }
+  if (ch != ' ') {
+    for (int16_t col = 0; col < 5; col++) {
+      if ((ch >> col) & 1 || col == 0) {
+        for (int16_t row = 0; row < 7 * s; row++) {
+          for (int16_t dx = 0; dx < s; dx++) {
+            drawPixel(x + col * s + dx, y + row, textColor);
+          }
+        }
+      }
+    }
+  }
+  int16_t col = x / HOST_GFX_CHAR_WIDTH;
+  int16_t row = y / HOST_GFX_CHAR_HEIGHT;
+  if (x >= 0 && y >= 0 && x % HOST_GFX_CHAR_WIDTH == 0 && y % HOST_GFX_CHAR_HEIGHT == 0 && row < 8 && col < 21) {
+    for (int16_t r = row; r < row + s && r < 8; r++) {
+      for (int16_t c = col; c < col + s && c < 21; c++) {
+        text[r][c] = ' ';
+      }
+    }
+    text[row][col] = ch;
+  }
+}
+
+
+/*
+ * As Adafruit_GFX for the default font: the box covered by the text if it were
+ * printed at (x, y).
+ */
+void Adafruit_GFX::getTextBounds(const char * str, int16_t x, int16_t y, int16_t * x1, int16_t * y1, uint16_t * w, uint16_t * h) {
+  int16_t cellW = HOST_GFX_CHAR_WIDTH * textSize;
+  int16_t cellH = HOST_GFX_CHAR_HEIGHT * textSize;
+  int16_t minX = WIDTH, minY = HEIGHT, maxX = -1, maxY = -1;
+  for (const char * p = str; *p; p++) {
+    if (*p == '\n') {
+      x = 0;
+      y += cellH;
+    } else if (*p != '\r') {
+      if (wrap && x + cellW > WIDTH) {
+        x = 0;
+        y += cellH;
+      }
+      minX = min(minX, x);
+      minY = min(minY, y);
+      maxX = max(maxX, (int16_t) (x + cellW - 1));
+      maxY = max(maxY, (int16_t) (y + cellH - 1));
+      x += cellW;
+    }
+  }
+  *x1 = maxX >= minX ? minX : x;
+  *y1 = maxY >= minY ? minY : y;
+  *w = maxX >= minX ? maxX - minX + 1 : 0;
+  *h = maxY >= minY ? maxY - minY + 1 : 0;
+}
+
+
+char Adafruit_GFX::getTextCell(int16_t col, int16_t row) const {
+  return row >= 0 && row < 8 && col >= 0 && col < 21 ? text[row][col] : '\0';
+}
+
+
+void Adafruit_GFX::clearText() {
+  memset(text, 0, sizeof(text));
+}
+
+
+/*********************************************
+ * Adafruit_SSD1306
+ ********************************************/
+
+static Adafruit_SSD1306 * hostDisplay = NULL;
+
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire * twi, int8_t rstPin)
+  : Adafruit_GFX(w, h), wire(twi) {
+  (void) rstPin;
+  hostDisplay = this;
+}
+
+
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+  free(buffer);
+  if (hostDisplay == this) {
+    hostDisplay = NULL;
+  }
+}
+
+
+/*
+ * Allocate the frame buffer and send the same initialisation sequence as the real
+ * library (the values do not matter, only the number of bytes).
+ */
+bool Adafruit_SSD1306::begin(uint8_t vccState, uint8_t i2cAddr) {
+  (void) vccState;
+  if (!buffer && !(buffer = (uint8_t *) malloc(WIDTH * ((HEIGHT + 7) / 8)))) {
+    return false;
+  }
+  clearDisplay();
+  if (i2cAddr) {
+    this->i2cAddr = i2cAddr;
+  }
+  static const uint8_t init[25] = {};
+  sendCommands(init, sizeof(init));
+  return true;
+}
+
+
+void Adafruit_SSD1306::sendCommands(const uint8_t * cmds, size_t len) {
+  wire->beginTransmission(i2cAddr);
+  wire->write((uint8_t) 0x00);
+  wire->write(cmds, len);
+  wire->endTransmission();
+}
+
+
+/*
+ * Send the whole frame buffer: a window command, then the data in transmissions of
+ * up to BUFFER_LENGTH - 1 bytes, at 400kHz.
+ */
+void Adafruit_SSD1306::display() {
+  wire->setClock(400000UL);
+  static const uint8_t window[6] = { SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0, 0 };
+  sendCommands(window, sizeof(window));
+  size_t n = WIDTH * ((HEIGHT + 7) / 8);
+  const uint8_t * p = buffer;
+  while (n > 0) {
+    size_t chunk = min(n, (size_t) (BUFFER_LENGTH - 1));
+    wire->beginTransmission(i2cAddr);
+    wire->write((uint8_t) 0x40);
+    wire->write(p, chunk);
+    wire->endTransmission();
+    p += chunk;
+    n -= chunk;
+  }
+  wire->setClock(100000UL);
+}
+
+
+void Adafruit_SSD1306::clearDisplay() {
+  if (buffer) {
+    memset(buffer, 0, WIDTH * ((HEIGHT + 7) / 8));
+  }
+  clearText();
+}
+
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if (!buffer || x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+    return;
+  }
+  uint8_t & b = buffer[x + (y / 8) * WIDTH];
+  uint8_t bit = 1 << (y & 7);
+  switch (color) {
+    case WHITE:   b |= bit;  break;
+    case BLACK:   b &= ~bit; break;
+    case INVERSE: b ^= bit;  break;
+  }
+}
+
+
+/*
+ * Print the text on the display.
+ */
+void hostDisplayDump() {
+  if (!hostDisplay) {
+    return;
+  }
+  fprintf(stderr, "+---------------------+\n");
+  for (int16_t row = 0; row < 8; row++) {
+    fputc('|', stderr);
+    for (int16_t col = 0; col < 21; col++) {
+      char ch = hostDisplay->getTextCell(col, row);
+      fputc(ch ? ch : ' ', stderr);
+    }
+    fprintf(stderr, "|\n");
+  }
+  fprintf(stderr, "+---------------------+\n");
+}
+
+
+/*********************************************
+ * DallasTemperature
+ ********************************************/
+
+// Time of 1-Wire operations (us): a reset and presence pulse, and a byte.
+#define ONE_WIRE_RESET_US 960
+#define ONE_WIRE_BYTE_US  (8 * 70)
+
+// Time constant of the payload temperature (s), and how much warmer it is than the air.
+#define PAYLOAD_TIME_CONST  300.0
+#define PAYLOAD_WARMTH      25.0
+#define HEATER_WARMTH       20.0
+
+static double gpsAltitude = 0;
+static double payloadTemp = 20.0;
+static uint64_t lastModelUs = 0;
+
+
+void hostGpsAltitude(double alt) {
+  gpsAltitude = alt;
+}
+
+
+/*
+ * Air temperature of the standard atmosphere.
+ */
+static double airTemperature(double alt) {
+  if (alt < 11000) {
+    return 15.0 - 0.0065 * alt;
+  }
+  return alt < 20000 ? -56.5 : -56.5 + 0.001 * (alt - 20000);
+}
+
+
+/*
+ * Bring the payload temperature up to date.
+ */
+static void updateTemperatureModel() {
+  uint64_t now = hostMicros();
+  double secs = (now - lastModelUs) / 1e6;
+  lastModelUs = now;
+  double target = airTemperature(gpsAltitude) + PAYLOAD_WARMTH
+                  + (hostPinState(HEATER_CONTROL_PIN) ? HEATER_WARMTH : 0);
+  payloadTemp += (target - payloadTemp) * (1.0 - exp(-secs / PAYLOAD_TIME_CONST));
+}
+
+
+bool DallasTemperature::getAddress(uint8_t * addr, uint8_t index) {
+  if (index >= getDeviceCount()) {
+    return false;
+  }
+  static const uint8_t family[7] = { 0x28, 0xFF, 0x64, 0x1E, 0x0C, 0x00, 0x00 };
+  memcpy(addr, family, sizeof(family));
+  addr[7] = index;
+  return true;
+}
+
+
+int16_t DallasTemperature::millisToWaitForConversion(uint8_t bits) {
+  switch (bits) {
+    case 9:  return 94;
+    case 10: return 188;
+    case 11: return 375;
+    default: return 750;
+  }
+}
+
+
+/*
+ * Reset, skip ROM and convert.
+ */
+void DallasTemperature::requestTemperatures() {
+  hostCharge(HostDeviceOneWire, ONE_WIRE_RESET_US + 2 * ONE_WIRE_BYTE_US);
+  if (waitForConversion) {
+    delay(millisToWaitForConversion(resolution));
+  }
+}
+
+
+/*
+ * Reset, match ROM (9 bytes including the command) and read the scratchpad (1 + 9 bytes).
+ */
+float DallasTemperature::getTempC(const uint8_t * addr) {
+  hostCharge(HostDeviceOneWire, ONE_WIRE_RESET_US + 19 * ONE_WIRE_BYTE_US);
+  updateTemperatureModel();
+  double t = addr[7] == 0 ? payloadTemp : airTemperature(gpsAltitude);
+  // The sensor's resolution is 1/16 C at 12 bits.
+  double step = 0.0625 * (1 << (12 - min(max((int) resolution, 9), 12)));
+  return (float) (floor(t / step) * step);
+}
+
+
+/*********************************************
+ * TinyGPSPlus
+ ********************************************/
+
+static uint32_t parseUnsigned(const NmeaField & fld) {
+  uint32_t value = 0;
+  for (NmeaOffset i = 0; i < fld.len && isdigit(fld.ptr[i]); i++) {
+    value = value * 10 + fld.ptr[i] - '0';
+  }
+  return value;
+}
+
+
+/*
+ * Parse a decimal as hundredths (e.g. "12.345" is 1234).
+ */
+static int32_t parseHundredths(const NmeaField & fld) {
+  NmeaOffset i = 0;
+  bool negative = fld.len > 0 && fld.ptr[0] == '-';
+  if (negative) {
+    i++;
+  }
+  int32_t value = 0;
+  for (; i < fld.len && isdigit(fld.ptr[i]); i++) {
+    value = value * 10 + fld.ptr[i] - '0';
+  }
+  value *= 100;
+  if (i < fld.len && fld.ptr[i] == '.') {
+    i++;
+    if (i < fld.len && isdigit(fld.ptr[i])) {
+      value += (fld.ptr[i++] - '0') * 10;
+      if (i < fld.len && isdigit(fld.ptr[i])) {
+        value += fld.ptr[i] - '0';
+      }
+    }
+  }
+  return negative ? -value : value;
+}
+
+
+/*
+ * Parse a latitude or longitude of the form (d)ddmm.mmmm and its hemisphere.
+ */
+static double parseDegrees(const NmeaField & fld, const NmeaField & hemi) {
+  double raw = atof(std::string(fld.ptr, fld.len).c_str());
+  int degrees = (int) (raw / 100);
+  double value = degrees + (raw - degrees * 100) / 60.0;
+  return hemi.len > 0 && (hemi.ptr[0] == 'S' || hemi.ptr[0] == 'W') ? -value : value;
+}
+
+
+uint32_t TinyGPSLocation::age() const {
+  return valid ? millis() - lastCommitTime : UINT32_MAX;
+}
+
+
+bool TinyGPSPlus::encode(char ch) {
+  charCnt++;
+  if (ch == '$') {
+    len = 0;
+  }
+  if (ch != '\r' && ch != '\n') {
+    if (len < sizeof(sentence) - 1) {
+      sentence[len++] = ch;
+    }
+    return false;
+  }
+  bool used = len > 0 && commit();
+  len = 0;
+  return used;
+}
+
+
+/*
+ * Apply a complete sentence.
+ */
+bool TinyGPSPlus::commit() {
+  NmeaSentence nmea;
+  NmeaStatus status = nmea.parse(sentence, len);
+  if (status == NmeaBadChecksum) {
+    failedCnt++;
+  }
+  if (status != NmeaOk) {
+    return false;
+  }
+  passedCnt++;
+
+  bool isGga = nmea.getType() == NmeaTypeGGA;
+  bool isRmc = nmea.getType() == NmeaTypeRMC;
+  if (!isGga && !isRmc) {
+    return false;
+  }
+  // GGA: time, lat, N/S, lon, E/W, quality, satellites, HDOP, altitude.
+  // RMC: time, status, lat, N/S, lon, E/W.
+  bool hasFix = isGga ? parseUnsigned(nmea.getField(6)) > 0
+                      : nmea.getField(2).len > 0 && nmea.getField(2).ptr[0] == 'A';
+  uint8_t latFld = isGga ? 2 : 3;
+
+  NmeaField timeFld = nmea.getField(1);
+  if (timeFld.len > 0) {
+    time.time = parseHundredths(timeFld);
+    time.valid = time.updated = true;
+  }
+  if (hasFix && nmea.getField(latFld).len > 0) {
+    location.latitude = parseDegrees(nmea.getField(latFld), nmea.getField(latFld + 1));
+    location.longitude = parseDegrees(nmea.getField(latFld + 2), nmea.getField(latFld + 3));
+    location.valid = location.updated = true;
+    location.lastCommitTime = millis();
+  }
+  if (isGga) {
+    satellites.val = parseUnsigned(nmea.getField(7));
+    satellites.valid = satellites.updated = true;
+    hdop.val = parseHundredths(nmea.getField(8));
+    hdop.valid = hdop.updated = true;
+    if (hasFix && nmea.getField(9).len > 0) {
+      altitude.val = parseHundredths(nmea.getField(9));
+      altitude.valid = altitude.updated = true;
+      hostGpsAltitude(altitude.val / 100.0);
+    }
+  }
+  if (hasFix) {
+    fixCnt++;
+  }
+  return true;
+}
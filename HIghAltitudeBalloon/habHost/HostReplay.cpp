@@ -0,0 +1,213 @@
+#include <Arduino.h>
+#include <vector>
+
+#include "Host.h"
+#include "../GPSCheckSumArduino/HabIndex.h"
+
+// The logger tags a sentence that had an incorrect checksum with this (see hab.cpp).
+#define INVALID_SENTENCE_TAG '!'
+
+/*
+ * A sentence to be replayed, at dueUs after the replay starts.
+ */
+struct ReplaySegment {
+  uint64_t dueUs;
+  uint32_t offset;
+  uint32_t length;
+};
+
+static std::vector<char> replayLog;
+static std::vector<ReplaySegment> segments;
+static uint32_t durationSecs = 0;
+
+// Delivery state.
+static bool started = false;
+static uint64_t startUs = 0;
+static double byteUs = 10e6 / 9600;       // 10 bits per byte.
+static double nextArrivalUs = 0;
+static size_t segIdx = 0;
+static uint32_t segPos = 0;
+
+// The UART receive buffer.
+static std::vector<uint8_t> rxBuf(64);
+static size_t rxHead = 0;
+static size_t rxCnt = 0;
+
+static uint64_t deliveredCnt = 0;
+static uint64_t overrunCnt = 0;
+static unsigned long lineCnt = 0;
+
+
+/*
+ * Return true if a record is one of the header lines written by logHeader().
+ */
+static bool isHeaderLine(const char * text, size_t len) {
+  while (len > 0 && (text[len - 1] == '\r' || text[len - 1] == '\n')) {
+    len--;
+  }
+  return len >= 6 && memcmp(text + len - 6, "chksum", 6) == 0;
+}
+
+
+/*
+ * Load a hab log (or a capture of the GPS output) and find the sentences in it.
+ * $HAB records and the header lines are skipped. A sentence the logger tagged as
+ * invalid is replayed as it was received, without the tag.
+ */
+bool hostReplayLoad(const char * file) {
+  FILE * f = fopen(file, "rb");
+  if (!f) {
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  replayLog.resize(size > 0 ? size : 0);
+  bool ok = fread(replayLog.data(), 1, replayLog.size(), f) == replayLog.size();
+  fclose(f);
+  if (!ok) {
+    return false;
+  }
+
+  HabLogScanner scanner;
+  int32_t firstTime = HAB_IDX_NO_TIME;
+  int32_t lastTime = HAB_IDX_NO_TIME;
+  std::vector<int32_t> times;
+  segments.clear();
+  for (size_t i = 0; i <= replayLog.size(); i++) {
+    bool done = i < replayLog.size() ? scanner.put(replayLog[i]) : scanner.finish();
+    if (!done) {
+      continue;
+    }
+    const HabLogRecord & rec = scanner.getRecord();
+    const char * text = replayLog.data() + rec.offset;
+    if (rec.binary || strncmp(rec.type, "$HAB", 4) == 0 || isHeaderLine(text, rec.length)) {
+      continue;
+    }
+    ReplaySegment seg = { 0, rec.offset, rec.length };
+    if (text[0] == INVALID_SENTENCE_TAG && seg.length > 1) {
+      seg.offset++;
+      seg.length--;
+    }
+    if (rec.time != HAB_IDX_NO_TIME) {
+      if (firstTime == HAB_IDX_NO_TIME) {
+        firstTime = rec.time;
+      }
+      lastTime = rec.time;
+    }
+    segments.push_back(seg);
+    times.push_back(rec.time);
+  }
+
+  // Sentences before the first with a time are sent at the start.
+  for (size_t i = 0; i < segments.size(); i++) {
+    segments[i].dueUs = times[i] == HAB_IDX_NO_TIME ? 0 : (uint64_t) (times[i] - firstTime) * 1000000ULL;
+  }
+  durationSecs = firstTime == HAB_IDX_NO_TIME ? 0 : lastTime - firstTime + 1;
+  return true;
+}
+
+
+void hostReplaySetRxBuffer(unsigned int size) {
+  rxBuf.assign(size > 0 ? size : 1, 0);
+  rxHead = rxCnt = 0;
+}
+
+
+/*
+ * Called when the sketch opens the port.
+ */
+void hostReplayBegin(unsigned long baud) {
+  started = true;
+  startUs = hostMicros();
+  byteUs = 10e6 / (baud > 0 ? baud : 9600);
+  segIdx = 0;
+  segPos = 0;
+  nextArrivalUs = startUs + (segments.empty() ? 0 : segments[0].dueUs);
+}
+
+
+/*
+ * Move the bytes that have arrived by now into the receive buffer.
+ */
+static void deliver() {
+  if (!started) {
+    return;
+  }
+  double now = (double) hostMicros();
+  while (segIdx < segments.size() && nextArrivalUs <= now) {
+    const ReplaySegment & seg = segments[segIdx];
+    uint8_t b = replayLog[seg.offset + segPos];
+    if (rxCnt < rxBuf.size()) {
+      rxBuf[(rxHead + rxCnt) % rxBuf.size()] = b;
+      rxCnt++;
+    } else {
+      overrunCnt++;
+    }
+    deliveredCnt++;
+    nextArrivalUs += byteUs;
+    if (++segPos == seg.length) {
+      segIdx++;
+      segPos = 0;
+      lineCnt++;
+      if (segIdx < segments.size()) {
+        nextArrivalUs = max(nextArrivalUs, (double) (startUs + segments[segIdx].dueUs));
+      }
+    }
+  }
+}
+
+
+int hostReplayAvailable() {
+  deliver();
+  return rxCnt;
+}
+
+
+int hostReplayRead() {
+  deliver();
+  if (rxCnt == 0) {
+    return -1;
+  }
+  uint8_t b = rxBuf[rxHead];
+  rxHead = (rxHead + 1) % rxBuf.size();
+  rxCnt--;
+  return b;
+}
+
+
+/*
+ * Called between passes of loop(). If the sketch has read everything that has arrived,
+ * skip ahead to the next byte (at speed 0).
+ */
+void hostReplayIdle() {
+  deliver();
+  if (started && rxCnt == 0 && segIdx < segments.size()) {
+    hostSkipTo((uint64_t) ceil(nextArrivalUs));
+  }
+}
+
+
+bool hostReplayDone() {
+  return started && segIdx >= segments.size() && rxCnt == 0;
+}
+
+
+uint32_t hostReplayDurationSecs() {
+  return durationSecs;
+}
+
+
+uint64_t hostReplayBytes() {
+  return deliveredCnt;
+}
+
+
+uint64_t hostReplayOverruns() {
+  return overrunCnt;
+}
+
+
+unsigned long hostReplayLines() {
+  return lineCnt;
+}
@@ -0,0 +1,402 @@
+#include <SdFat.h>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Host.h"
+
+#define SECTOR_SIZE 512
+
+// Sectors below this are left for the file system structures.
+#define FIRST_DATA_SECTOR 8192
+
+static std::string sdRoot = "sd";
+static uint32_t sectorCostUs = 0;
+static uint64_t bytesWritten = 0;
+static unsigned long writeCnt = 0;
+
+
+/*
+ * A contiguous range of sectors allocated to a preallocated file.
+ */
+struct SdExtent {
+  std::string path;
+  uint32_t firstSector;
+  uint32_t sectorCnt;
+  FILE * fp;              // Used for sector access, opened when first needed.
+};
+
+static std::vector<SdExtent> extents;
+static uint32_t nextFreeSector = FIRST_DATA_SECTOR;
+
+
+void hostSdSetRoot(const char * dir) {
+  sdRoot = dir;
+}
+
+
+void hostSdSetSectorCost(uint32_t us) {
+  sectorCostUs = us;
+}
+
+
+uint64_t hostSdBytesWritten() {
+  return bytesWritten;
+}
+
+
+unsigned long hostSdWriteCnt() {
+  return writeCnt;
+}
+
+
+/*
+ * Return the host path of a path on the card.
+ */
+static std::string hostPath(const char * path) {
+  while (*path == '/') {
+    path++;
+  }
+  return *path ? sdRoot + "/" + path : sdRoot;
+}
+
+
+/*
+ * Find the extent that holds a range of sectors, or NULL if it is not part of a file.
+ */
+static SdExtent * findExtent(uint32_t sector, size_t count) {
+  for (SdExtent & ext : extents) {
+    if (sector >= ext.firstSector && sector + count <= ext.firstSector + ext.sectorCnt) {
+      if (!ext.fp) {
+        ext.fp = fopen(ext.path.c_str(), "r+b");
+      }
+      return ext.fp ? &ext : NULL;
+    }
+  }
+  return NULL;
+}
+
+
+/*
+ * Account for writing to the card.
+ */
+static void chargeWrite(size_t bytes) {
+  bytesWritten += bytes;
+  writeCnt++;
+  hostCharge(HostDeviceSd, (uint64_t) sectorCostUs * ((bytes + SECTOR_SIZE - 1) / SECTOR_SIZE));
+}
+
+
+/*********************************************
+ * SdFs
+ ********************************************/
+
+bool SdFs::begin(SdioConfig config) {
+  (void) config;
+  mkdir(sdRoot.c_str(), 0777);
+  struct stat st;
+  return stat(sdRoot.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+
+bool SdFs::exists(const char * path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+
+bool SdFs::remove(const char * path) {
+  return ::remove(hostPath(path).c_str()) == 0;
+}
+
+
+bool SdFs::rename(const char * oldPath, const char * newPath) {
+  return ::rename(hostPath(oldPath).c_str(), hostPath(newPath).c_str()) == 0;
+}
+
+
+/*********************************************
+ * SdCard
+ ********************************************/
+
+bool SdCard::readSector(uint32_t sector, uint8_t * dst) {
+  SdExtent * ext = findExtent(sector, 1);
+  if (!ext) {
+    return false;
+  }
+  fflush(ext->fp);
+  off_t pos = (off_t) (sector - ext->firstSector) * SECTOR_SIZE;
+  ssize_t n = pread(fileno(ext->fp), dst, SECTOR_SIZE, pos);
+  if (n < SECTOR_SIZE) {
+    memset(dst + (n > 0 ? n : 0), 0, SECTOR_SIZE - (n > 0 ? n : 0));
+  }
+  return n >= 0;
+}
+
+
+bool SdCard::writeSectors(uint32_t sector, const uint8_t * src, size_t count) {
+  SdExtent * ext = findExtent(sector, count);
+  if (!ext) {
+    return false;
+  }
+  off_t pos = (off_t) (sector - ext->firstSector) * SECTOR_SIZE;
+  size_t len = count * SECTOR_SIZE;
+  chargeWrite(len);
+  return pwrite(fileno(ext->fp), src, len, pos) == (ssize_t) len;
+}
+
+
+/*
+ * The emulated card erases to zeros.
+ */
+bool SdCard::erase(uint32_t firstSector, uint32_t lastSector) {
+  SdExtent * ext = findExtent(firstSector, lastSector - firstSector + 1);
+  if (!ext) {
+    return false;
+  }
+  static const uint8_t zeros[64 * SECTOR_SIZE] = {};
+  for (uint32_t s = firstSector; s <= lastSector; ) {
+    uint32_t n = min((uint32_t) (sizeof(zeros) / SECTOR_SIZE), lastSector - s + 1);
+    if (pwrite(fileno(ext->fp), zeros, n * SECTOR_SIZE, (off_t) (s - ext->firstSector) * SECTOR_SIZE) < 0) {
+      return false;
+    }
+    s += n;
+  }
+  return true;
+}
+
+
+bool SdCard::syncDevice() {
+  for (SdExtent & ext : extents) {
+    if (ext.fp) {
+      fflush(ext.fp);
+    }
+  }
+  hostCharge(HostDeviceSd, sectorCostUs);
+  return true;
+}
+
+
+/*********************************************
+ * FsFile
+ ********************************************/
+
+bool FsFile::open(const char * path, int oflag) {
+  close();
+  std::string host = hostPath(path);
+  struct stat st;
+  if (stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+    dir = opendir(host.c_str());
+  } else {
+    bool write = (oflag & O_ACCMODE) != O_RDONLY;
+    bool exists = stat(host.c_str(), &st) == 0;
+    if (exists && (oflag & O_CREAT) && (oflag & O_EXCL)) {
+      return false;
+    }
+    if (!exists && !(oflag & O_CREAT)) {
+      return false;
+    }
+    fp = fopen(host.c_str(), !write ? "rb" : (exists && !(oflag & O_TRUNC)) ? "r+b" : "w+b");
+    if (fp && (oflag & O_AT_END)) {
+      fseek(fp, 0, SEEK_END);
+    }
+  }
+  if (isOpen()) {
+    snprintf(this->path, sizeof(this->path), "%s", host.c_str());
+  }
+  return isOpen();
+}
+
+
+bool FsFile::open(FsFile * dirFile, const char * path, int oflag) {
+  if (!dirFile || !dirFile->isDir()) {
+    return false;
+  }
+  std::string dirPath = dirFile->path;
+  std::string rel = dirPath.size() > sdRoot.size() ? dirPath.substr(sdRoot.size() + 1) + "/" + path : path;
+  return open(rel.c_str(), oflag);
+}
+
+
+bool FsFile::openNext(FsFile * dirFile, int oflag) {
+  if (!dirFile || !dirFile->dir) {
+    return false;
+  }
+  struct dirent * entry;
+  while ((entry = readdir(dirFile->dir)) != NULL) {
+    if (entry->d_name[0] != '.') {
+      return open(dirFile, entry->d_name, oflag);
+    }
+  }
+  return false;
+}
+
+
+bool FsFile::close() {
+  bool ok = true;
+  if (fp) {
+    ok = fclose(fp) == 0;
+  }
+  if (dir) {
+    closedir(dir);
+  }
+  fp = NULL;
+  dir = NULL;
+  path[0] = '\0';
+  return ok;
+}
+
+
+size_t FsFile::getName(char * name, size_t size) const {
+  const char * base = strrchr(path, '/');
+  base = base ? base + 1 : path;
+  snprintf(name, size, "%s", base);
+  return strlen(name);
+}
+
+
+uint64_t FsFile::fileSize() const {
+  if (!fp) {
+    return 0;
+  }
+  fflush(fp);
+  struct stat st;
+  return fstat(fileno(fp), &st) == 0 ? st.st_size : 0;
+}
+
+
+uint64_t FsFile::curPosition() const {
+  return fp ? ftello(fp) : 0;
+}
+
+
+bool FsFile::seekSet(uint64_t pos) {
+  return fp && fseeko(fp, pos, SEEK_SET) == 0;
+}
+
+
+bool FsFile::seekEnd(int64_t offset) {
+  return fp && fseeko(fp, offset, SEEK_END) == 0;
+}
+
+
+bool FsFile::truncate(uint64_t length) {
+  if (!fp) {
+    return false;
+  }
+  fflush(fp);
+  for (SdExtent & ext : extents) {
+    if (ext.fp && ext.path == path) {
+      fflush(ext.fp);
+    }
+  }
+  bool ok = ftruncate(fileno(fp), length) == 0;
+  if (curPosition() > length) {
+    seekSet(length);
+  }
+  return ok;
+}
+
+
+bool FsFile::sync() {
+  if (fp) {
+    fflush(fp);
+    hostCharge(HostDeviceSd, sectorCostUs);
+  }
+  return fp != NULL;
+}
+
+
+/*
+ * Extend the file, which is then given a contiguous range of sectors on the card.
+ */
+bool FsFile::preAllocate(uint64_t length) {
+  if (!fp || ftruncate(fileno(fp), length) != 0) {
+    return false;
+  }
+  for (SdExtent & ext : extents) {
+    if (ext.path == path) {
+      if (ext.fp) {
+        fclose(ext.fp);
+      }
+      ext.fp = NULL;
+      ext.sectorCnt = (length + SECTOR_SIZE - 1) / SECTOR_SIZE;
+      return true;
+    }
+  }
+  SdExtent ext = { path, nextFreeSector, (uint32_t) ((length + SECTOR_SIZE - 1) / SECTOR_SIZE), NULL };
+  extents.push_back(ext);
+  nextFreeSector += ext.sectorCnt;
+  return true;
+}
+
+
+/*
+ * A file that was preallocated by this run is contiguous. Any other file is given
+ * sectors now, as if it had been preallocated by an earlier run.
+ */
+bool FsFile::contiguousRange(uint32_t * bgnSector, uint32_t * endSector) {
+  uint64_t size = fileSize();
+  if (!fp || size == 0) {
+    return false;
+  }
+  SdExtent * found = NULL;
+  for (SdExtent & ext : extents) {
+    if (ext.path == path) {
+      found = &ext;
+    }
+  }
+  if (!found) {
+    SdExtent ext = { path, nextFreeSector, (uint32_t) ((size + SECTOR_SIZE - 1) / SECTOR_SIZE), NULL };
+    extents.push_back(ext);
+    nextFreeSector += ext.sectorCnt;
+    found = &extents.back();
+  }
+  *bgnSector = found->firstSector;
+  *endSector = found->firstSector + found->sectorCnt - 1;
+  return true;
+}
+
+
+int FsFile::available() {
+  if (!fp) {
+    return 0;
+  }
+  uint64_t size = fileSize();
+  uint64_t pos = curPosition();
+  return pos < size ? (int) min(size - pos, (uint64_t) INT32_MAX) : 0;
+}
+
+
+int FsFile::read() {
+  return fp ? fgetc(fp) : -1;
+}
+
+
+int FsFile::read(void * buf, size_t count) {
+  return fp ? (int) fread(buf, 1, count, fp) : -1;
+}
+
+
+int FsFile::fgets(char * str, int num, char * delim) {
+  (void) delim;
+  if (!fp || !::fgets(str, num, fp)) {
+    return -1;
+  }
+  return strlen(str);
+}
+
+
+size_t FsFile::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+
+size_t FsFile::write(const uint8_t * buf, size_t count) {
+  if (!fp) {
+    return 0;
+  }
+  chargeWrite(count);
+  return fwrite(buf, 1, count, fp);
+}
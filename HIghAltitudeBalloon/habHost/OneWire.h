@@ -0,0 +1,15 @@
+#ifndef _ONEWIRE_H
+#define _ONEWIRE_H
+
+// Host emulation of the 1-Wire bus. The sensors on it are emulated by DallasTemperature.
+#include <Arduino.h>
+
+class OneWire {
+  public:
+    OneWire(uint8_t pin) : pin(pin) {}
+
+  private:
+    uint8_t pin;
+};
+
+#endif
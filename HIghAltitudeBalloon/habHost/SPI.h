@@ -0,0 +1,7 @@
+#ifndef _SPI_H
+#define _SPI_H
+
+// The SD card is reached through the emulated card (see SdFat.h), not the SPI bus.
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef _SDFAT_H
+#define _SDFAT_H
+
+/*
+ * Host emulation of the parts of SdFat 2 used by the flight monitor (SD_FAT_TYPE 3).
+ *
+ * The card is a directory on the host (see hostSdSetRoot()). Each file is a host
+ * file. A preallocated file is given a contiguous range of sectors on the emulated
+ * card, and sector reads and writes within that range go to the host file, so the
+ * logger's direct sector writes and recovery work as they do on the card.
+ */
+
+#include <Arduino.h>
+#include <dirent.h>
+
+#define O_RDONLY  0x00
+#define O_WRONLY  0x01
+#define O_RDWR    0x02
+#define O_ACCMODE 0x03
+#define O_APPEND  0x08
+#define O_CREAT   0x10
+#define O_TRUNC   0x20
+#define O_EXCL    0x40
+#define O_AT_END  0x4000
+
+#define O_READ    O_RDONLY
+#define O_WRITE   O_WRONLY
+#define FILE_READ  O_RDONLY
+#define FILE_WRITE (O_RDWR | O_CREAT | O_AT_END)
+
+#define HAS_SDIO_CLASS 1
+#define FIFO_SDIO 0
+
+struct SdioConfig {
+  SdioConfig(uint8_t options) : options(options) {}
+  uint8_t options;
+};
+
+
+class FsFile : public Stream {
+  public:
+    FsFile() {}
+    ~FsFile() { close(); }
+    FsFile(const FsFile &) = delete;
+    FsFile & operator=(const FsFile &) = delete;
+
+    bool open(const char * path, int oflag = O_RDONLY);
+    bool open(FsFile * dir, const char * path, int oflag = O_RDONLY);
+    bool openNext(FsFile * dir, int oflag = O_RDONLY);
+    bool close();
+    bool isOpen() const { return fp != NULL || dir != NULL; }
+    bool isFile() const { return fp != NULL; }
+    bool isDir() const { return dir != NULL; }
+    size_t getName(char * name, size_t size) const;
+
+    uint64_t fileSize() const;
+    uint64_t size() const { return fileSize(); }
+    uint64_t curPosition() const;
+    bool seekSet(uint64_t pos);
+    bool seekEnd(int64_t offset = 0);
+    bool truncate(uint64_t length);
+    bool truncate() { return truncate(curPosition()); }
+    bool sync();
+    void flush() { sync(); }
+
+    bool preAllocate(uint64_t length);
+    bool contiguousRange(uint32_t * bgnSector, uint32_t * endSector);
+
+    int available() override;
+    int read() override;
+    int read(void * buf, size_t count);
+    int fgets(char * str, int num, char * delim = NULL);
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t * buf, size_t count) override;
+    size_t write(const void * buf, size_t count) { return write((const uint8_t *) buf, count); }
+    using Print::write;
+
+  private:
+    FILE * fp = NULL;
+    DIR * dir = NULL;
+    char path[256] = "";
+};
+
+
+/*
+ * The card, for sector access to preallocated files.
+ */
+class SdCard {
+  public:
+    bool readSector(uint32_t sector, uint8_t * dst);
+    bool writeSector(uint32_t sector, const uint8_t * src) { return writeSectors(sector, src, 1); }
+    bool writeSectors(uint32_t sector, const uint8_t * src, size_t count);
+    bool erase(uint32_t firstSector, uint32_t lastSector);
+    bool syncDevice();
+};
+
+
+class SdFs {
+  public:
+    bool begin(SdioConfig config);
+    bool exists(const char * path);
+    bool remove(const char * path);
+    bool rename(const char * oldPath, const char * newPath);
+    SdCard * card() { return &sdCard; }
+
+  private:
+    SdCard sdCard;
+};
+
+#endif
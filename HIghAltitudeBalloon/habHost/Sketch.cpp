@@ -0,0 +1,6 @@
+/*
+ * The flight monitor sketch, compiled as C++ in the same way as the Arduino IDE.
+ */
+#include <Arduino.h>
+
+#include "habFlightMonitor.ino"
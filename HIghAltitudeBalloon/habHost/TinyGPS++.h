@@ -0,0 +1,105 @@
+#ifndef _TINYGPSPLUS_H
+#define _TINYGPSPLUS_H
+
+/*
+ * Host emulation of the parts of TinyGPS++ used by the flight monitor, built on the
+ * sketch's own NMEA tokenizer (Nmea.h). As in TinyGPS++, only sentences with a
+ * correct checksum are used: GGA updates the time, location, altitude, satellites
+ * and HDOP, RMC updates the time and location. The location and altitude are only
+ * updated when the receiver has a fix. Reading a value clears its updated flag.
+ */
+
+#include <Arduino.h>
+
+#include "Nmea.h"
+
+class TinyGPSLocation {
+  public:
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t age() const;
+    double lat() { updated = false; return latitude; }
+    double lng() { updated = false; return longitude; }
+
+  private:
+    friend class TinyGPSPlus;
+    bool valid = false, updated = false;
+    uint32_t lastCommitTime = 0;
+    double latitude = 0, longitude = 0;
+};
+
+class TinyGPSTime {
+  public:
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t value() { updated = false; return time; }
+    uint8_t hour() { updated = false; return time / 1000000; }
+    uint8_t minute() { updated = false; return time / 10000 % 100; }
+    uint8_t second() { updated = false; return time / 100 % 100; }
+
+  private:
+    friend class TinyGPSPlus;
+    bool valid = false, updated = false;
+    uint32_t time = 0;            // hhmmsscc.
+};
+
+class TinyGPSDecimal {
+  public:
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    int32_t value() { updated = false; return val; }
+
+  protected:
+    friend class TinyGPSPlus;
+    bool valid = false, updated = false;
+    int32_t val = 0;              // Hundredths.
+};
+
+class TinyGPSAltitude : public TinyGPSDecimal {
+  public:
+    double meters() { return value() / 100.0; }
+};
+
+class TinyGPSHDOP : public TinyGPSDecimal {
+  public:
+    double hdop() { return value() / 100.0; }
+};
+
+class TinyGPSInteger {
+  public:
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t value() { updated = false; return val; }
+
+  private:
+    friend class TinyGPSPlus;
+    bool valid = false, updated = false;
+    uint32_t val = 0;
+};
+
+
+class TinyGPSPlus {
+  public:
+    // Process a received character. Return true if it completed a usable sentence.
+    bool encode(char ch);
+
+    uint32_t charsProcessed() const { return charCnt; }
+    uint32_t sentencesWithFix() const { return fixCnt; }
+    uint32_t failedChecksum() const { return failedCnt; }
+    uint32_t passedChecksum() const { return passedCnt; }
+
+    TinyGPSLocation location;
+    TinyGPSTime time;
+    TinyGPSAltitude altitude;
+    TinyGPSInteger satellites;
+    TinyGPSHDOP hdop;
+
+  private:
+    bool commit();
+
+    char sentence[NMEA_MAX_LENGTH + 1];
+    unsigned int len = 0;
+    uint32_t charCnt = 0, fixCnt = 0, failedCnt = 0, passedCnt = 0;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef _WIRE_H
+#define _WIRE_H
+
+/*
+ * Host emulation of the I2C bus. Nothing is connected to it, but the time each
+ * transmission would take at the current clock rate is added to the emulated clock.
+ */
+
+#include <Arduino.h>
+
+// As the Teensy 4 Wire library.
+#define BUFFER_LENGTH 136
+
+class TwoWire {
+  public:
+    void begin() {}
+    void setClock(uint32_t hz) { clockHz = hz; }
+    void beginTransmission(uint8_t addr) { (void) addr; txLen = 0; }
+    size_t write(uint8_t b) { (void) b; txLen++; return 1; }
+    size_t write(const uint8_t * buf, size_t len) { (void) buf; txLen += len; return len; }
+    uint8_t endTransmission(bool sendStop = true);
+
+  private:
+    uint32_t clockHz = 100000;
+    size_t txLen = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
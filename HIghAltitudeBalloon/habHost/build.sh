@@ -0,0 +1,23 @@
+#!/bin/sh
+#
+# build.sh
+# --------
+#
+# Build habHost: the flight monitor sketch (../habFlightMonitor) compiled for a Linux
+# host against the emulated Arduino core and libraries in this directory.
+#
+# By: G. McCall
+#     Oct-2026
+#
+# Usage:
+#   sh build.sh [g++ options]
+#
+#   Any options are passed to g++, e.g. -DLOG_BINARY_HAB to build a variant, or
+#   -O0 to debug. The default is -O2 -g, which suits perf.
+#
+
+HOST=$(cd "$(dirname "$0")" && pwd)
+SKETCH="$HOST/../habFlightMonitor"
+
+exec g++ -std=gnu++17 -O2 -g -Wall "$@" -I"$HOST" -I"$SKETCH" -o "$HOST/habHost" \
+  "$HOST"/*.cpp "$SKETCH"/*.cpp
@@ -0,0 +1,225 @@
+/**
+  * habHost.cpp
+  * -----------
+  *
+  * Run the flight monitor (habFlightMonitor) on a Linux host, replaying the GPS
+  * sentences of a recorded log, so that the loop, the logger and the display can be
+  * measured and profiled (e.g. with perf) without the hardware.
+  *
+  * The sketch is compiled unchanged against emulations of the Arduino core and of the
+  * libraries it uses (in this directory):
+  *   - Serial is the console (stdin/stdout). Serial1 (GPS_PORT) replays the log.
+  *   - SdFs is a directory on the host. Preallocated log files and direct sector writes
+  *     are supported.
+  *   - Adafruit_SSD1306 draws into an in-memory frame buffer.
+  *   - DallasTemperature reports the standard atmosphere at the GPS altitude outside
+  *     and a heated payload inside.
+  *   - TinyGPS++ is emulated using the sketch's Nmea.h.
+  * The time the I2C, 1-Wire and SD card transfers would take on the device is added
+  * to the emulated clock (see Host.h), so their cost shows up in the sketch's own
+  * metrics ($HAB records) as well as in the summary.
+  *
+  * The host build uses the polled GPS receive path (GPS_INGEST_ISR is only defined for
+  * the Teensy), so a slow pass of loop() can overrun the UART receive buffer. Lost
+  * bytes are reported.
+  *
+  * By: G. McCall
+  *     Oct-2026
+  *
+  * Usage:
+  *   habHost [options] replay.log
+  *
+  *   -d dir          Directory that holds the SD card's files (default sd).
+  *   --speed x       Replay speed: 1 is real time (default), 10 is ten times faster,
+  *                   0 is as fast as the sketch can go.
+  *   --secs n        Stop after n seconds of emulated time.
+  *   --tail n        Seconds to keep running after the last sentence (default 10).
+  *   --rxbuf n       Size of the GPS UART receive buffer (default 64).
+  *   --sdcost us     Time the card takes to write a sector or sync (default 0).
+  *   --batt volts    Battery voltage (default 3.9).
+  *   --powerfail     Stop without closing the log, as when the power is lost.
+  *   --screen        Show the text on the OLED at the end.
+  *   -q              Discard the console output.
+  *
+  *   The summary is written to stderr.
+  *
+  * Build:
+  *   sh build.sh [g++ options, e.g. -DLOG_BINARY_HAB]
+  *
+  * History:
+  *
+  *  v1.00.00.00 - 17-Oct-2026
+  *    Initial version.
+  */
+
+#define VERSION "1.00.00.00"
+
+#include <Arduino.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <signal.h>
+
+#include "Host.h"
+#include "Logger.h"
+#include "hab_config.h"
+
+using namespace std;
+
+extern void setup();
+extern void loop();
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+  stopRequested = 1;
+}
+
+
+/*
+ * Format a time in microseconds as h:mm:ss.sss.
+ */
+string formatUs(uint64_t us) {
+  char buf[32];
+  uint64_t ms = us / 1000;
+  snprintf(buf, sizeof(buf), "%lu:%02lu:%02lu.%03lu", (unsigned long) (ms / 3600000), (unsigned long) (ms / 60000 % 60),
+           (unsigned long) (ms / 1000 % 60), (unsigned long) (ms % 1000));
+  return buf;
+}
+
+
+/*
+ * Report what happened during the run.
+ */
+void report(const char * replayFile, uint64_t emulatedUs, double realSecs, vector<uint32_t> & loopUs) {
+  sort(loopUs.begin(), loopUs.end());
+  uint32_t p50 = loopUs.empty() ? 0 : loopUs[loopUs.size() / 2];
+  uint32_t p99 = loopUs.empty() ? 0 : loopUs[loopUs.size() * 99 / 100];
+  uint32_t slowest = loopUs.empty() ? 0 : loopUs.back();
+
+  fprintf(stderr, "habHost v%s: %s\n", VERSION, replayFile);
+  fprintf(stderr, "  Emulated time:  %s in %.3f s real (x%.1f)\n", formatUs(emulatedUs).c_str(), realSecs,
+          realSecs > 0 ? emulatedUs / 1e6 / realSecs : 0.0);
+  fprintf(stderr, "  GPS replay:     %lu sentences, %lu bytes, %lu bytes lost (receive buffer full)\n",
+          hostReplayLines(), (unsigned long) hostReplayBytes(), (unsigned long) hostReplayOverruns());
+  fprintf(stderr, "  loop():         %zu passes, p50 %u us, p99 %u us, max %u us\n", loopUs.size(), p50, p99, slowest);
+  fprintf(stderr, "  I2C (OLED):     %s, %lu transmissions, %lu bytes\n", formatUs(hostChargedUs(HostDeviceI2c)).c_str(),
+          hostI2cTransmissions(), (unsigned long) hostI2cBytes());
+  fprintf(stderr, "  1-Wire:         %s\n", formatUs(hostChargedUs(HostDeviceOneWire)).c_str());
+  fprintf(stderr, "  SD card:        %s, %lu writes, %lu bytes\n", formatUs(hostChargedUs(HostDeviceSd)).c_str(),
+          hostSdWriteCnt(), (unsigned long) hostSdBytesWritten());
+  fprintf(stderr, "  delay():        %s\n", formatUs(hostChargedUs(HostDeviceDelay)).c_str());
+  fprintf(stderr, "  Log file:       %s\n", getLogFileName()[0] ? getLogFileName() : "-");
+}
+
+
+/* main
+ * ----
+ * Run setup(), then loop() until the replay (and the tail after it) is finished.
+ */
+int main(int argc, const char * argv[]) {
+  const char * sdDir = "sd";
+  const char * replayFile = NULL;
+  double speed = 1;
+  double maxSecs = 0;
+  double tailSecs = 10;
+  unsigned int rxBufSize = 64;
+  uint32_t sdCost = 0;
+  double battV = 3.9;
+  bool powerFail = false;
+  bool showScreen = false;
+
+  for (int i = 1; i < argc; i++) {
+    const char * opt = argv[i];
+    const char * arg = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(opt, "-q") == 0) {
+      hostConsoleQuiet = true;
+    } else if (strcmp(opt, "--powerfail") == 0) {
+      powerFail = true;
+    } else if (strcmp(opt, "--screen") == 0) {
+      showScreen = true;
+    } else if (opt[0] != '-') {
+      replayFile = opt;
+    } else if (arg == NULL) {
+      replayFile = NULL;
+      break;
+    } else {
+      i++;
+      if (strcmp(opt, "-d") == 0) {
+        sdDir = arg;
+      } else if (strcmp(opt, "--speed") == 0) {
+        speed = atof(arg);
+      } else if (strcmp(opt, "--secs") == 0) {
+        maxSecs = atof(arg);
+      } else if (strcmp(opt, "--tail") == 0) {
+        tailSecs = atof(arg);
+      } else if (strcmp(opt, "--rxbuf") == 0) {
+        rxBufSize = atoi(arg);
+      } else if (strcmp(opt, "--sdcost") == 0) {
+        sdCost = atoi(arg);
+      } else if (strcmp(opt, "--batt") == 0) {
+        battV = atof(arg);
+      } else {
+        fprintf(stderr, "Unknown option: %s\n", opt);
+        return 1;
+      }
+    }
+  }
+  if (!replayFile) {
+    fprintf(stderr, "Usage: habHost [-d dir] [--speed x] [--secs n] [--tail n] [--rxbuf n] [--sdcost us] [--batt volts]"
+                    " [--powerfail] [--screen] [-q] replay.log\n");
+    return 1;
+  }
+  if (!hostReplayLoad(replayFile)) {
+    fprintf(stderr, "Error reading %s\n", replayFile);
+    return 1;
+  }
+
+  hostSdSetRoot(sdDir);
+  hostSdSetSectorCost(sdCost);
+  hostReplaySetRxBuffer(rxBufSize);
+  hostSetAnalog(VOLTAGE_MEASURE, (int) (battV * DIVIDER_RATIO_GND / VREF * 1023.0 + 0.5));
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  auto realStart = chrono::steady_clock::now();
+  hostClockBegin(speed);
+  setup();
+
+  vector<uint32_t> loopUs;
+  uint64_t startUs = hostMicros();
+  uint64_t doneUs = 0;
+  while (!stopRequested) {
+    uint64_t t0 = hostMicros();
+    loop();
+    uint64_t t1 = hostMicros();
+    loopUs.push_back((uint32_t) min(t1 - t0, (uint64_t) UINT32_MAX));
+
+    if (hostReplayDone()) {
+      if (doneUs == 0) {
+        doneUs = t1;
+      }
+      if (t1 - doneUs >= tailSecs * 1e6) {
+        break;
+      }
+      hostSkipTo(t1 + 1000);        // Nothing more will arrive, let the sketch's timers run.
+    } else {
+      hostReplayIdle();
+    }
+    if (maxSecs > 0 && t1 - startUs >= maxSecs * 1e6) {
+      break;
+    }
+  }
+
+  if (!powerFail) {
+    logClose();
+  }
+  fflush(stdout);
+  double realSecs = chrono::duration<double>(chrono::steady_clock::now() - realStart).count();
+  report(replayFile, hostMicros(), realSecs, loopUs);
+  if (showScreen) {
+    hostDisplayDump();
+  }
+  return 0;
+}
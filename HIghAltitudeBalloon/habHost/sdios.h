@@ -0,0 +1,7 @@
+#ifndef _SDIOS_H
+#define _SDIOS_H
+
+// The flight monitor does not use the SdFat stream classes.
+#include <SdFat.h>
+
+#endif